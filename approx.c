@@ -0,0 +1,207 @@
+/*
+ * approx.c
+ *
+ * Estimates the triangles of a graph, with a 95% confidence interval, in a fraction of
+ * the time of the exact count. See headers/sampling.h for the methods. triest streams
+ * the edges of the file in one pass instead, in bounded memory (see headers/reservoir.h).
+ *
+ * Usage: ./approx [-m method] [-e error] [-L budget] [-p probability] [-k top] [-M memory] [-t threads] [-s seed] [-x] [-o csv] <graph ...>
+ *   graph: a .mtx file, a .csr snapshot or a generator spec, like tricount takes.
+ *   -m: wedge (default), doulion or triest.
+ *   -e: the target half width of the interval, in % of the estimate (default: 1).
+ *   -L: the time budget, in ms. Sampling stops before a round that wouldn't fit in it
+ *       (default: half the estimated time of the exact count).
+ *   -p: the probability doulion keeps an edge with (default: 0.1).
+ *   -k: also estimates the triangles of the k vertices of highest degree (default: 0).
+ *       With triest, the k vertices with the most triangles.
+ *   -M: the memory of the reservoirs of triest, in MB (default: 64).
+ *   -t: default: the number of cpus. The shards of triest.
+ *   -s: the seed of the samples (default: 1).
+ *   -x: also counts exactly, and reports the true error and whether the interval holds it.
+ *   -o: one row per estimate (default: stats/approx.csv).
+ *
+ * Authors: Antonios Antoniou - 9482 - aantonii@ece.auth.gr
+ *          Efthymios Grigorakis - 9694 - eegrigor@ece.auth.gr
+ *
+ * 2021 Aristotle University of Thessaloniki
+ * Parallel and Distributed Systems.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "headers/csr.h"
+#include "headers/mmio.h"
+#include "headers/helpers.h"
+#include "headers/bench.h"
+#include "headers/generator.h"
+#include "headers/sampling.h"
+#include "headers/reservoir.h"
+
+
+// The estimate, its interval and, with the exact count, its error.
+static void printEstimate(char *what, sample_estimate e, double exact) {
+  int interval = !isnan(e.low);
+  printf("%s: %.0f", what, e.estimate);
+  if (interval) {
+    printf(" [%.0f, %.0f] +-%.2f%%", e.low, e.high, (e.estimate > 0) ? 50 * (e.high - e.low) / e.estimate : 0);
+  }
+  if (exact >= 0) {
+    printf("\texact %.0f, error %+.2f%%%s", exact, (exact > 0) ? 100 * (e.estimate - exact) / exact : 0,
+      (interval && (exact < e.low || exact > e.high)) ? " OUTSIDE the interval" : "");
+  }
+  printf("\n");
+}
+
+
+static void writeEstimate(FILE *file, char *graph, sample_options options, long vertex, sample_estimate e,
+  sample_result result, double exact, double exactTime)
+{
+  if (file == NULL) {
+    return;
+  }
+
+  fprintf(file, "%s\t%s\t", graph, sampleMethodName(options.method));
+  if (vertex >= 0) {
+    fprintf(file, "%ld", vertex + 1);
+  } else {
+    fprintf(file, "NA");
+  }
+  fprintf(file, "\t%.1f", e.estimate);
+  if (!isnan(e.low)) {
+    fprintf(file, "\t%.1f\t%.1f", e.low, e.high);
+  } else {
+    fprintf(file, "\tNA\tNA");
+  }
+  fprintf(file, "\t%llu\t%d\t%d\t%.1f", e.samples, result.rounds, result.converged, result.time);
+  if (exact >= 0) {
+    fprintf(file, "\t%.0f\t%.1f", exact, exactTime);
+  } else {
+    fprintf(file, "\tNA\tNA");
+  }
+  fprintf(file, "\t%.4f\t%.4f\t%.0f\t%d\n", options.error, options.probability, options.memory, options.threads);
+}
+
+
+static void printUsage(char *program) {
+  printf("Usage: %s [-m wedge|doulion|triest] [-e error %%] [-L budget ms] [-p probability] [-k top] [-M memory MB] [-t threads]"
+    " [-s seed] [-x] [-o csv] <graph ...>\n", program);
+}
+
+
+int main(int argc, char **argv) {
+  sample_options options = defaultSampleOptions();
+  options.threads = sysconf(_SC_NPROCESSORS_ONLN);
+  char *csvName = "stats/approx.csv";
+  int exact = 0;
+
+  int option;
+  while ((option = getopt(argc, argv, "m:e:L:p:k:M:t:s:xo:")) != -1) {
+    switch (option) {
+      case 'm': options.method = parseSampleMethod(optarg); break;
+      case 'e': options.error = atof(optarg) / 100; break;
+      case 'L': options.budget = atof(optarg) * 1000; break;
+      case 'p': options.probability = atof(optarg); break;
+      case 'k': options.top = atoi(optarg); break;
+      case 'M': options.memory = atof(optarg) * 1048576; break;
+      case 't': options.threads = atoi(optarg); break;
+      case 's': options.seed = strtoull(optarg, NULL, 10); break;
+      case 'x': exact = 1; break;
+      case 'o': csvName = optarg; break;
+      default:
+        printUsage(argv[0]);
+        return 1;
+    }
+  }
+  if (optind >= argc || options.method < 0) {
+    printUsage(argv[0]);
+    return 1;
+  }
+  if (options.error <= 0 || options.probability <= 0 || options.probability > 1 || options.memory <= 0) {
+    printf("The error and the memory must be positive and the probability in (0, 1].\n");
+    return 1;
+  }
+  options.threads = (options.threads < 1) ? 1 : options.threads;
+
+  FILE *file = fopen(csvName, "w");
+  if (file == NULL) {
+    printf("Couldn't write %s\n", csvName);
+  } else {
+    fprintf(file, "graph\tmethod\tvertex\testimate\tlow\thigh\tsamples\trounds\tconverged\ttime_us"
+      "\texact\texact_us\terror\tprobability\tmemory\tthreads\n");
+  }
+
+  for (int g = optind; g < argc; g++) {
+    // triest streams the file itself, and only needs the table for the exact counts.
+    char *name = graphName(argv[g]);
+    csr table = {0, NULL, NULL, NULL};
+    if (options.method != SAMPLE_TRIEST || exact) {
+      table = loadGraph(argv[g]);
+      if (table.rowIndex == NULL) {
+        return 1;
+      }
+    }
+
+    sample_result result;
+    if (options.method == SAMPLE_TRIEST) {
+      result = estimateStream(argv[g], options);
+      if (isnan(result.total.estimate)) {
+        return 1;
+      }
+      printf("%s, triest: %llu edges streamed through %d reservoirs of %.0f edges, %.0f us\n", name,
+        result.total.samples, options.threads, options.memory / RESERVOIR_EDGE_BYTES / options.threads, result.time);
+    } else {
+      result = estimateTriangles(table, options);
+      printf("%s, %s: %llu %s in %d rounds, %.0f us", name, sampleMethodName(options.method),
+        result.total.samples, (options.method == SAMPLE_DOULION) ? "sparsifications" : "wedges", result.rounds,
+        result.time);
+      if (!result.converged) {
+        printf(" (stopped at +-%.2f%% instead of +-%.2f%%)", 100 * result.reached, 100 * options.error);
+      }
+      printf("\n");
+    }
+
+    // The exact counts, to check the intervals against.
+    uint *triangles = NULL;
+    double total = -1, exactTime = 0;
+    if (exact) {
+      triangles = (uint *) malloc(((table.size > 0) ? table.size : 1) * sizeof(uint));
+      double start = nowMicros();
+      total = exactTriangles(table, options.threads, triangles);
+      exactTime = nowMicros() - start;
+      printf("Exact count: %.0f us, %.1fx the estimate.\n", exactTime,
+        (result.time > 0) ? exactTime / result.time : 0);
+    }
+
+    printEstimate("triangles", result.total, total);
+    writeEstimate(file, name, options, -1, result.total, result, total, exactTime);
+    for (uint i = 0; i < result.top; i++) {
+      char what[64];
+      uint v = result.vertices[i];
+      if (table.rowIndex != NULL) {
+        snprintf(what, sizeof(what), "vertex %u (degree %u)", v + 1, table.rowIndex[v + 1] - table.rowIndex[v]);
+      } else {
+        snprintf(what, sizeof(what), "vertex %u", v + 1);
+      }
+      double vertexExact = (exact && v < table.size) ? (double) triangles[v] : -1;
+      printEstimate(what, result.vertex[i], vertexExact);
+      writeEstimate(file, name, options, v, result.vertex[i], result, vertexExact, exactTime);
+    }
+    printf("\n");
+
+    free(triangles);
+    freeSampleResult(&result);
+    if (table.rowIndex != NULL) {
+      freeCSR(table);
+    }
+    free(name);
+  }
+
+  if (file != NULL) {
+    fclose(file);
+  }
+  return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * batch.c
+ *
+ * Counts the triangles of every graph of a manifest in one process, on one pool of
+ * workers (see headers/pool.h): the small graphs side by side, a worker each, and the
+ * large ones with the whole pool.
+ *
+ * Usage: ./batch [-t threads] [-L nonzeros] [-o output] <manifest>
+ *   manifest: one graph per line, a .mtx file, a .csr snapshot or a generator spec.
+ *             Empty lines and lines starting with # are skipped.
+ *   -t: default: the number of cpus.
+ *   -L: the nonzeros above which a graph is counted by the whole pool (default: 2^20).
+ *   -o: one row per graph, in the order of the manifest (default: stats/batch.csv).
+ *
+ * Authors: Antonios Antoniou - 9482 - aantonii@ece.auth.gr
+ *          Efthymios Grigorakis - 9694 - eegrigor@ece.auth.gr
+ *
+ * 2021 Aristotle University of Thessaloniki
+ * Parallel and Distributed Systems.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "headers/csr.h"
+#include "headers/bench.h"
+#include "headers/pool.h"
+
+
+static void printUsage(char *program) {
+  printf("Usage: %s [-t threads] [-L nonzeros] [-o output] <manifest>\n", program);
+}
+
+
+int main(int argc, char **argv) {
+  int threads = sysconf(_SC_NPROCESSORS_ONLN);
+  uint large = POOL_LARGE_NONZEROS;
+  char *outputName = "stats/batch.csv";
+
+  int option;
+  while ((option = getopt(argc, argv, "t:L:o:")) != -1) {
+    switch (option) {
+      case 't': threads = atoi(optarg); break;
+      case 'L': large = strtoul(optarg, NULL, 10); break;
+      case 'o': outputName = optarg; break;
+      default:
+        printUsage(argv[0]);
+        return 1;
+    }
+  }
+  if (optind != argc - 1) {
+    printUsage(argv[0]);
+    return 1;
+  }
+  threads = (threads < 1) ? 1 : threads;
+
+  int count;
+  char **graphs = readManifest(argv[optind], &count);
+  if (graphs == NULL) {
+    return 1;
+  }
+
+  double start = nowMicros();
+  pool_result *results = countGraphs(graphs, count, threads, large);
+  double time = nowMicros() - start;
+
+  int failed = 0, shared = 0;
+  unsigned long long triangles = 0, nonzeros = 0;
+  for (int i = 0; i < count; i++) {
+    failed += !results[i].loaded;
+    shared += results[i].shared;
+    triangles += results[i].triangles;
+    nonzeros += results[i].nonzeros;
+  }
+
+  printf("\n%d graphs (%d counted by the whole pool, %d couldn't be read) in %.0f us using %d threads: "
+    "%.1f graphs/s, %llu nonzeros, %llu triangles.\n", count, shared, failed, time, threads,
+    (time > 0) ? count / (time / 1e6) : 0, nonzeros, triangles);
+
+  int written = writePoolResults(outputName, results, count);
+
+  free(results);
+  freeManifest(graphs, count);
+  return (written && failed == 0) ? 0 : 1;
+}
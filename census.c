@@ -0,0 +1,171 @@
+/*
+ * census.c
+ *
+ * The triangle census of a directed graph: the triangles of every type (cycles,
+ * feed-forward loops, ...), in all and per vertex. See headers/directed.h.
+ *
+ * Usage: ./census [-t threads] [-o csv] [-v] <graph.mtx>
+ *   graph: a .mtx file. The entries of a general file are directed edges, row -> column.
+ *   -t: default: the number of cpus.
+ *   -o: one row per vertex, 1-based, with its triangles of every type (default: stats/census.csv).
+ *   -v: checks that the types of every vertex add up to its triangles in the undirected
+ *       graph, counted on their own, and prints how long those took. Exits with 2 if not.
+ *
+ * Authors: Antonios Antoniou - 9482 - aantonii@ece.auth.gr
+ *          Efthymios Grigorakis - 9694 - eegrigor@ece.auth.gr
+ *
+ * 2021 Aristotle University of Thessaloniki
+ * Parallel and Distributed Systems.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "headers/csr.h"
+#include "headers/mmio.h"
+#include "headers/helpers.h"
+#include "headers/bench.h"
+#include "headers/sampling.h"
+#include "headers/directed.h"
+
+
+// The graph without directions: every row the union of the successors and the predecessors.
+static csr underlyingGraph(directed_graph graph) {
+  csr out = graph.out, in = graph.in;
+  uint size = out.size;
+  uint capacity = out.rowIndex[size] + in.rowIndex[size];
+
+  csr table;
+  table.size = size;
+  table.rowIndex = (uint *) calloc(size + 1, sizeof(uint));
+  table.colIndex = (uint *) malloc(((capacity > 0) ? capacity : 1) * sizeof(uint));
+  table.values = (int *) malloc(((capacity > 0) ? capacity : 1) * sizeof(int));
+
+  uint position = 0;
+  for (uint row = 0; row < size; row++) {
+    uint i = out.rowIndex[row], iEnd = out.rowIndex[row + 1];
+    uint j = in.rowIndex[row], jEnd = in.rowIndex[row + 1];
+    while (i < iEnd || j < jEnd) {
+      uint column;
+      if (j == jEnd || (i < iEnd && out.colIndex[i] <= in.colIndex[j])) {
+        column = out.colIndex[i++];
+        j += (j < jEnd && in.colIndex[j] == column);
+      } else {
+        column = in.colIndex[j++];
+      }
+      table.values[position] = 1;
+      table.colIndex[position++] = column;
+    }
+    table.rowIndex[row + 1] = position;
+  }
+
+  return table;
+}
+
+
+static int writeCensus(char *path, census_result result, uint size) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    printf("Couldn't write %s\n", path);
+    return 0;
+  }
+
+  fprintf(file, "vertex");
+  for (int type = 0; type < DIRECTED_TYPES; type++) {
+    fprintf(file, "\t%s", directedTypeName(type));
+  }
+  fprintf(file, "\n");
+
+  for (uint v = 0; v < size; v++) {
+    fprintf(file, "%u", v + 1);
+    for (int type = 0; type < DIRECTED_TYPES; type++) {
+      fprintf(file, "\t%u", result.vertices[(size_t) v * DIRECTED_TYPES + type]);
+    }
+    fprintf(file, "\n");
+  }
+
+  fclose(file);
+  return 1;
+}
+
+
+static void printUsage(char *program) {
+  printf("Usage: %s [-t threads] [-o csv] [-v] <graph.mtx>\n", program);
+}
+
+
+int main(int argc, char **argv) {
+  int threads = sysconf(_SC_NPROCESSORS_ONLN);
+  char *csvName = "stats/census.csv";
+  int verify = 0;
+
+  int option;
+  while ((option = getopt(argc, argv, "t:o:v")) != -1) {
+    switch (option) {
+      case 't': threads = atoi(optarg); break;
+      case 'o': csvName = optarg; break;
+      case 'v': verify = 1; break;
+      default:
+        printUsage(argv[0]);
+        return 1;
+    }
+  }
+  if (optind != argc - 1) {
+    printUsage(argv[0]);
+    return 1;
+  }
+  threads = (threads < 1) ? 1 : threads;
+
+  directed_graph graph = readDirectedMtx(argv[optind]);
+  if (graph.out.rowIndex == NULL) {
+    return 1;
+  }
+  uint size = graph.out.size;
+
+  census_result result = directedCensus(graph, threads);
+
+  unsigned long long triangles = 0;
+  for (int type = 0; type < DIRECTED_TYPES; type++) {
+    triangles += result.totals[type];
+  }
+  printf("%u edges, %llu of them reciprocal pairs. %llu triangles in %.0f us using %d threads:\n",
+    graph.out.rowIndex[size], result.reciprocal, triangles, result.time, threads);
+  for (int type = 0; type < DIRECTED_TYPES; type++) {
+    printf("%6s %14llu\n", directedTypeName(type), result.totals[type]);
+  }
+
+  int status = 0;
+  if (verify) {
+    csr undirected = underlyingGraph(graph);
+    uint *reference = (uint *) malloc(((size > 0) ? size : 1) * sizeof(uint));
+    double start = nowMicros();
+    unsigned long long expected = exactTriangles(undirected, threads, reference);
+    double time = nowMicros() - start;
+
+    uint mismatches = 0;
+    for (uint v = 0; v < size; v++) {
+      uint sum = 0;
+      for (int type = 0; type < DIRECTED_TYPES; type++) {
+        sum += result.vertices[(size_t) v * DIRECTED_TYPES + type];
+      }
+      mismatches += (sum != reference[v]);
+    }
+
+    if (expected == triangles && mismatches == 0) {
+      printf("Verified: %llu undirected triangles, counted in %.0f us.\n", expected, time);
+    } else {
+      printf("MISMATCH: %llu undirected triangles, %u vertices differ.\n", expected, mismatches);
+      status = 2;
+    }
+    free(reference);
+    freeCSR(undirected);
+  }
+
+  int written = writeCensus(csvName, result, size);
+
+  freeCensusResult(&result);
+  freeDirectedGraph(&graph);
+  return status ? status : (written ? 0 : 1);
+}
@@ -0,0 +1,199 @@
+/*
+ * cliques.c
+ *
+ * Counts the k-cliques of a graph, globally and per vertex (see headers/clique.h), timed
+ * like the backends of tricount, into the same results.
+ *
+ * Usage: ./cliques [options] <graph>
+ *   graph: a .mtx file, a .csr snapshot or a generator spec, like tricount takes.
+ *   -k: the size of the cliques, 3 to 16 (default: 4).
+ *   -O: the ordering, degeneracy or degree (default: degeneracy).
+ *   -t: default: the number of cpus.
+ *   -w: warmup repetitions, that aren't measured (default: 1).
+ *   -n: measured repetitions (default: 5).
+ *   -v: checks the counts of every vertex: for k = 3 against the triangles without self
+ *       loops, otherwise against a count with the other ordering. Exits with 2 if they differ.
+ *   -o: also writes the cliques of every vertex there, 1-based.
+ *   -c: the tidy CSV file (default: stats/cliques.csv).
+ *   -j: the JSON file, with every measured time (default: stats/cliques.json).
+ *
+ * Authors: Antonios Antoniou - 9482 - aantonii@ece.auth.gr
+ *          Efthymios Grigorakis - 9694 - eegrigor@ece.auth.gr
+ *
+ * 2021 Aristotle University of Thessaloniki
+ * Parallel and Distributed Systems.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "headers/csr.h"
+#include "headers/mmio.h"
+#include "headers/helpers.h"
+#include "headers/bench.h"
+#include "headers/generator.h"
+#include "headers/verify.h"
+#include "headers/sampling.h"
+#include "headers/clique.h"
+
+
+static int writeCounts(char *path, uint *counts, uint size) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    printf("Couldn't write %s\n", path);
+    return 0;
+  }
+
+  fprintf(file, "vertex\tcliques\n");
+  for (uint v = 0; v < size; v++) {
+    fprintf(file, "%u\t%u\n", v + 1, counts[v]);
+  }
+
+  fclose(file);
+  return 1;
+}
+
+
+static void printUsage(char *program) {
+  printf("Usage: %s [-k 3..%d] [-O degeneracy|degree] [-t threads] [-w warmups] [-n reps] [-v] "
+    "[-o counts] [-c csv] [-j json] <graph>\n", program, CLIQUE_MAX_K);
+}
+
+
+int main(int argc, char **argv) {
+  int k = 4;
+  int ordering = CLIQUE_DEGENERACY;
+  int threads = sysconf(_SC_NPROCESSORS_ONLN);
+  int warmups = 1;
+  int reps = 5;
+  int verify = 0;
+  char *countsName = NULL;
+  char *csvName = "stats/cliques.csv";
+  char *jsonName = "stats/cliques.json";
+
+  int option;
+  while ((option = getopt(argc, argv, "k:O:t:w:n:vo:c:j:")) != -1) {
+    switch (option) {
+      case 'k': k = atoi(optarg); break;
+      case 'O':
+        ordering = parseCliqueOrdering(optarg);
+        if (ordering < 0) {
+          printf("Unknown ordering %s\n", optarg);
+          printUsage(argv[0]);
+          return 1;
+        }
+        break;
+      case 't': threads = atoi(optarg); break;
+      case 'w': warmups = atoi(optarg); break;
+      case 'n': reps = atoi(optarg); break;
+      case 'v': verify = 1; break;
+      case 'o': countsName = optarg; break;
+      case 'c': csvName = optarg; break;
+      case 'j': jsonName = optarg; break;
+      default:
+        printUsage(argv[0]);
+        return 1;
+    }
+  }
+  if (optind != argc - 1 || k < 3 || k > CLIQUE_MAX_K) {
+    printUsage(argv[0]);
+    return 1;
+  }
+  threads = (threads < 1) ? 1 : threads;
+  warmups = (warmups < 0) ? 0 : warmups;
+  reps = (reps < 1) ? 1 : reps;
+
+  char *name = graphName(argv[optind]);
+  csr table = loadGraph(argv[optind]);
+  if (table.rowIndex == NULL) {
+    return 1;
+  }
+
+  char backend[64], label[64];
+  snprintf(backend, sizeof(backend), "clique%d-%s", k, cliqueOrderingName(ordering));
+  snprintf(label, sizeof(label), "k%d%s%d", k, (ordering == CLIQUE_DEGREE) ? "deg" : "core", threads);
+
+  bench_result result;
+  memset(&result, 0, sizeof(result));
+  result.graph = name;
+  result.backend = backend;
+  result.label = label;
+  result.threads = threads;
+  result.warmups = warmups;
+  result.times = (double *) malloc(reps * sizeof(double));
+  result.intersections = 0;
+  result.ipc = -1;
+  result.missesPerEdge = -1;
+  result.verified = VERIFY_NONE;
+  result.peakHeap = -1;
+  result.peakRSS = -1;
+  result.retained = -1;
+  result.bytesPerEdge = -1;
+
+  uint *counts = NULL;
+  for (int rep = 0; rep < warmups + reps; rep++) {
+    unsigned long long total;
+    double start = nowMicros();
+    uint *cliques = countCliques(table, k, ordering, threads, &total);
+    double time = nowMicros() - start;
+
+    if (rep >= warmups) {
+      result.times[rep - warmups] = time;
+    }
+    // The first measured repetition is kept, as in tricount.
+    if (rep == warmups) {
+      counts = cliques;
+      result.triangles = total;
+    } else {
+      free(cliques);
+    }
+  }
+  result.stats = computeStats(result.times, reps);
+  result.checksum = summarizeTriangles(counts, table.size).checksum;
+
+  printf("%s on %s: %llu %d-cliques, checksum %016llx, median %.0f us, using %d threads",
+    backend, name, result.triangles, k, result.checksum, result.stats.median, threads);
+
+  if (verify) {
+    uint *reference;
+    unsigned long long expected;
+    if (k == 3) {
+      reference = (uint *) malloc(((table.size > 0) ? table.size : 1) * sizeof(uint));
+      expected = exactTriangles(table, threads, reference);
+    } else {
+      int other = (ordering == CLIQUE_DEGREE) ? CLIQUE_DEGENERACY : CLIQUE_DEGREE;
+      reference = countCliques(table, k, other, threads, &expected);
+    }
+
+    verify_result check = verifyTriangles(counts, reference, NULL, table.size);
+    result.verified = (check.status == VERIFY_OK && expected == result.triangles) ? VERIFY_OK : VERIFY_MISMATCH;
+    if (result.verified == VERIFY_OK) {
+      printf(", verified");
+    } else {
+      printf(" MISMATCH: %llu expected, %u vertices differ", expected, check.mismatches);
+      if (check.mismatches > 0) {
+        printf(", first %u (%u instead of %u)", check.first, counts[check.first], reference[check.first]);
+      }
+    }
+    free(reference);
+  }
+  printf("\n");
+
+  int written = (countsName == NULL) || writeCounts(countsName, counts, table.size);
+
+  bench_meta meta = readBenchMeta();
+  writeResultsCSV(csvName, &result, 1, meta);
+  writeResultsJSON(jsonName, &result, 1, meta);
+
+  free(counts);
+  free(result.times);
+  freeCSR(table);
+  free(name);
+
+  if (result.verified == VERIFY_MISMATCH) {
+    return 2;
+  }
+  return written ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+/*
+ * backend_cilk.c
+ * Parallel implementation of the algorithm using openCilk.
+ * Only compiled in when building with the openCilk compiler (-DWITH_CILK).
+ */
+
+#ifdef WITH_CILK
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <cilk/cilk.h>
+#include <cilk/cilk_api.h>
+
+#include "../headers/mmio.h"
+#include "../headers/csr.h"
+#include "../headers/csr_arg.h"
+#include "../headers/helpers.h"
+#include "../headers/numa_helpers.h"
+#include "../headers/edge_split.h"
+#include "../headers/backends.h"
+#include "../headers/trace.h"
+#include "../headers/progress.h"
+
+
+// The Cilk runtime takes the number of workers as a string.
+static void setCilkWorkers(int max_threads) {
+  char workers[16];
+  snprintf(workers, sizeof(workers), "%d", max_threads);
+  __cilkrts_set_param("nworkers", workers);
+  __cilkrts_init();
+}
+
+
+// plan is NULL, unless we're running in NUMA mode. Cilk decides which worker runs each
+// iteration, so the worker that picks up partition i pins itself to the cpu planned for i
+// and reads the replica of the table of that node.
+uint *countTrianglesCilk(csr table, int max_threads, numa_plan *plan) {
+  PROGRESS("Threads: %d\n", max_threads);  
+  setCilkWorkers(max_threads);
+
+  uint size = table.size;
+
+  double start = traceStart();
+  csr_arg *cilk_csr = makeThreadArguments(table, max_threads);
+  traceRecord("partition", TRACE_MAIN, start);
+
+  cilk_for (int i = 0; i < max_threads; i++) {
+    PROGRESS("cilk_for thread: %d\n", i);
+    int index = cilk_csr[i].id;
+    csr source = table;
+    if (plan != NULL) {
+      pinThread(plan->cpus[index]);
+      source = numaTable(plan, index);
+    }
+
+    double begin = traceStart();
+    cilk_csr[index].table = hadamardSingleStep(source, cilk_csr[index].start, cilk_csr[index].end);
+    traceRecord("hadamard", __cilkrts_get_worker_number(), begin);
+    PROGRESS("thread end: %d\n", i);
+  }
+
+  // Make a table of the triangles each thread will count for each respective csr_args element.
+  // countTriangles() allocates each of them.
+  uint **trianglesPerThread = (uint **) malloc(max_threads * sizeof(uint *));
+  
+  cilk_for (int i = 0; i < max_threads; i++) {
+    int index = cilk_csr[i].id;
+    double begin = traceStart();
+    trianglesPerThread[index] = countTriangles(cilk_csr[index].table);
+    traceRecord("count", __cilkrts_get_worker_number(), begin);
+  }
+
+  // Stitch all the board together. Use the 'start' notation to put each
+  // element in the designated place. 
+  start = traceStart();
+  uint *triangles = (uint *) calloc(size, sizeof(uint));
+  for (int i = 0; i < max_threads; i++) {
+    uint threadStart = cilk_csr[i].start;
+    uint threadSize = cilk_csr[i].table.size;
+
+    for (uint j = 0; j < threadSize; j++) {
+      triangles[threadStart + j] = trianglesPerThread[i][j];
+    }
+  }
+  traceRecord("stitch", TRACE_MAIN, start);
+
+  // for (uint i = 0; i < size; i++) {
+  //   printf(" %u ", triangles[i]);
+  // }
+
+  // Everything but the result, so that the repetitions don't pile up.
+  for (int i = 0; i < max_threads; i++) {
+    free(trianglesPerThread[i]);
+  }
+  free(trianglesPerThread);
+  freeThreadArguments(cilk_csr, max_threads);
+
+  return triangles;
+}
+
+
+// The edge-parallel mode. cilk_for splits the task range recursively and
+// the work stealing balances the pieces of the hub rows.
+uint *countTrianglesEdgesCilk(csr table, int max_threads, numa_plan *plan) {
+  setCilkWorkers(max_threads);
+
+  double start = traceStart();
+  edge_tasks tasks = makeEdgeTasks(table, max_threads);
+  traceRecord("tasks", TRACE_MAIN, start);
+  uint *sums = (uint *) calloc(table.size, sizeof(uint));
+
+  // Without pinning we don't know which node a worker is on, so replicas
+  // are only used for the row partition of countTrianglesCilk().
+  csr source = (plan != NULL) ? numaTable(plan, 0) : table;
+
+  // Every task is its own event, on the worker that stole it.
+  cilk_for (uint i = 0; i < tasks.count; i++) {
+    double begin = traceStart();
+    runEdgeTask(source, tasks.tasks[i], sums);
+    traceRecord("edges", __cilkrts_get_worker_number(), begin);
+  }
+
+  free(tasks.tasks);
+  start = traceStart();
+  uint *triangles = halveSums(sums, table.size);
+  traceRecord("halve", TRACE_MAIN, start);
+  return triangles;
+}
+
+#endif
@@ -0,0 +1,123 @@
+/*
+ * backend_openmp.c
+ * Parallel implementation of the algorithm using openMP.
+ * Only compiled in when the compiler supports openMP (-fopenmp).
+ */
+
+#ifdef _OPENMP
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+
+#include "../headers/mmio.h"
+#include "../headers/csr.h"
+#include "../headers/csr_arg.h"
+#include "../headers/helpers.h"
+#include "../headers/numa_helpers.h"
+#include "../headers/edge_split.h"
+#include "../headers/backends.h"
+#include "../headers/trace.h"
+#include "../headers/progress.h"
+
+
+// plan is NULL, unless we're running in NUMA mode. Then every thread is pinned
+// and reads the replica of the table that lives on its own node.
+uint *countTrianglesOMP(csr table, int MAX_THREADS, numa_plan *plan) {
+  uint size = table.size;
+
+  omp_set_num_threads(MAX_THREADS);
+  double start = traceStart();
+  csr_arg *omp_csr = makeThreadArguments(table, MAX_THREADS);
+  traceRecord("partition", TRACE_MAIN, start);
+
+  #pragma omp parallel 
+  {
+    int id = omp_get_thread_num();
+    PROGRESS("thread: %d\n", id);
+    csr source = table;
+    if (plan != NULL) {
+      pinThread(plan->cpus[id]);
+      source = numaTable(plan, id);
+    }
+    double begin = traceStart();
+    omp_csr[id].table = hadamardSingleStep(source, omp_csr[id].start, omp_csr[id].end);
+    traceRecord("hadamard", id, begin);
+    PROGRESS("thread end: %d\n", id);
+  }
+
+ // Make a table of the triangles each thread will count for each respective csr_args element.
+  // countTriangles() allocates each of them.
+  uint **trianglesPerThread = (uint **) malloc(MAX_THREADS * sizeof(uint *));
+
+  #pragma omp parallel
+  {
+    int id = omp_get_thread_num();
+    double begin = traceStart();
+    trianglesPerThread[id] = countTriangles(omp_csr[id].table);
+    traceRecord("count", id, begin);
+  }
+
+  // Stitch all the board together. Use the 'start' notation to put each
+  // element in the designated place. 
+  start = traceStart();
+  uint *triangles = (uint *) calloc(size, sizeof(uint));
+  for (int i = 0; i < MAX_THREADS; i++) {
+    uint threadStart = omp_csr[i].start;
+    uint threadSize = omp_csr[i].table.size;
+
+    for (uint j = 0; j < threadSize; j++) {
+      triangles[threadStart + j] = trianglesPerThread[i][j];
+    }
+  }
+  traceRecord("stitch", TRACE_MAIN, start);
+
+  // for (uint i = 0; i < size; i++) {
+  //   printf(" %u ", triangles[i]);
+  // }
+
+  // Everything but the result, so that the repetitions don't pile up.
+  for (int i = 0; i < MAX_THREADS; i++) {
+    free(trianglesPerThread[i]);
+  }
+  free(trianglesPerThread);
+  freeThreadArguments(omp_csr, MAX_THREADS);
+
+  return triangles;
+}
+
+
+// The edge-parallel mode. The tasks are cut by makeEdgeTasks() and handed out
+// dynamically, so the threads that finish early keep taking the pieces of the hub rows.
+uint *countTrianglesEdgesOMP(csr table, int MAX_THREADS, numa_plan *plan) {
+  omp_set_num_threads(MAX_THREADS);
+  double start = traceStart();
+  edge_tasks tasks = makeEdgeTasks(table, MAX_THREADS);
+  traceRecord("tasks", TRACE_MAIN, start);
+  uint *sums = (uint *) calloc(table.size, sizeof(uint));
+
+  #pragma omp parallel
+  {
+    int id = omp_get_thread_num();
+    csr source = table;
+    if (plan != NULL) {
+      pinThread(plan->cpus[id]);
+      source = numaTable(plan, id);
+    }
+
+    double begin = traceStart();
+    #pragma omp for schedule(dynamic, 1) nowait
+    for (uint i = 0; i < tasks.count; i++) {
+      runEdgeTask(source, tasks.tasks[i], sums);
+    }
+    traceRecord("edges", id, begin);
+  }
+
+  free(tasks.tasks);
+  start = traceStart();
+  uint *triangles = halveSums(sums, table.size);
+  traceRecord("halve", TRACE_MAIN, start);
+  return triangles;
+}
+
+#endif
@@ -1,45 +1,42 @@
 /*
- * pthreads.c 
- *
- * Convert a square N x N matrix into the CSR format, made for sparse matrices:
- * https://en.wikipedia.org/wiki/Sparse_matrix#Compressed_sparse_column_(CSC_or_CCS)
- * Then return its square in CSR format and perform the Hadamard 
- * (element-wise) operation: A (Hadamard) A^2.
- * 
- * -- Parallel implementation of the algorithm using pthreads. --
- * 
- * Authors: Antonios Antoniou - 9482 - aantonii@ece.auth.gr
- *          Efthymios Grigorakis - 9694 - eegrigor@ece.auth.gr
- *    
- * 2021 Aristotle University of Thessaloniki
- * Parallel and Distributed Systems.
+ * backend_pthreads.c
+ * Parallel implementation of the algorithm using pthreads.
+ * Each thread gets a sub-table of rows from makeThreadArguments().
  */
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
 #include <pthread.h>
 
-#include "headers/csr.h"
-#include "headers/csr_arg.h"
-#include "headers/mmio.h"
-#include "headers/helpers.h"
-#include "headers/data_arg.h"
+#include "../headers/mmio.h"
+#include "../headers/csr.h"
+#include "../headers/csr_arg.h"
+#include "../headers/helpers.h"
+#include "../headers/numa_helpers.h"
+#include "../headers/backends.h"
+#include "../headers/trace.h"
+#include "../headers/progress.h"
 
 
 // Utilized to be given to the void functions used by pthread. 
 // @param csrarg: the csr_arg struct that's used in the other two parallel algorithms.
 // @param original: contains the full, original CSR table.
 // @param triangles: the result of the algorithm.
+// @param cpu: the cpu the thread is pinned to in NUMA mode. -1 leaves it unpinned.
+// @param id: the number of the thread, for the phase timers.
 typedef struct {
   csr original;
   csr_arg csrarg;
   uint *triangles; 
+  int cpu;
+  int id;
 } pthreads_arg;
 
 
 void *countTrianglesVoid(void *C) {
   pthreads_arg *C_arg = (pthreads_arg *) C;
+  pinThread(C_arg->cpu);
+  double start = traceStart();
 
   uint size = C_arg->csrarg.table.size;
 
@@ -56,11 +53,15 @@ void *countTrianglesVoid(void *C) {
         : C_arg->triangles[i] + C_arg->csrarg.table.values[j];
 		}
 	}
+
+  traceRecord("count", C_arg->id, start);
 }
 
 
 void *hadamardSingleStepVoid(void *csrarg) {
   pthreads_arg *arg = (pthreads_arg *) csrarg;
+  pinThread(arg->cpu);
+  double begin = traceStart();
 
   uint start = arg->csrarg.start;
   uint end = arg->csrarg.end;
@@ -104,13 +105,19 @@ void *hadamardSingleStepVoid(void *csrarg) {
   arg->csrarg.table.values = newValues;
   arg->csrarg.table.rowIndex = newRowIndex;
   arg->csrarg.table.colIndex = newColIndex;
+
+  traceRecord("hadamard", arg->id, begin);
 }
 
 
-uint countTrianglesPthread(csr table, int MAX_THREADS) {
+// plan is NULL, unless we're running in NUMA mode. Then every thread is pinned
+// and reads the replica of the table that lives on its own node.
+uint *countTrianglesPthread(csr table, int MAX_THREADS, numa_plan *plan) {
   uint size = table.size;
 
+  double start = traceStart();
   csr_arg *pthread_csr = makeThreadArguments(table, MAX_THREADS);
+  traceRecord("partition", TRACE_MAIN, start);
   pthread_t threads[MAX_THREADS];
 
   // Initialize the sub-arrays and give them to the new pthreads_arg struct.
@@ -118,34 +125,29 @@ uint countTrianglesPthread(csr table, int MAX_THREADS) {
 
   for (int i = 0 ; i < MAX_THREADS ; i++) {
     arg[i].triangles = (uint *) calloc(pthread_csr[i].table.size, sizeof(uint));
-    arg[i].original = table ; 
+    arg[i].original = (plan != NULL) ? numaTable(plan, i) : table; 
     arg[i].csrarg = pthread_csr[i];
+    arg[i].cpu = (plan != NULL) ? plan->cpus[i] : -1;
+    arg[i].id = i;
   }
 
   for (int i = 0; i < MAX_THREADS; i++) {
-    printf("thread: %d\n", i);
+    PROGRESS("thread: %d\n", i);
     pthread_create(&threads[i], NULL, hadamardSingleStepVoid, (void *) &arg[i]);
   }
 
   for(int i = 0 ; i < MAX_THREADS; i++) {
     pthread_join(threads[i], NULL);
-    printf("thread end: %d\n", i);
+    PROGRESS("thread end: %d\n", i);
   }
 
  // Make a table of the triangles each thread will count for each respective csr_args element.
   uint **trianglesPerThread = (uint **) malloc(MAX_THREADS * sizeof(uint *));
-  uint totalSize = 0;
 
   for (int i = 0; i < MAX_THREADS; i++) {
-    uint partialSize = arg[i].csrarg.table.size * sizeof(uint);
-    totalSize += partialSize;
-
-    trianglesPerThread[i] = (uint *) calloc(partialSize, sizeof(uint));
+    trianglesPerThread[i] = (uint *) calloc(arg[i].csrarg.table.size, sizeof(uint));
   }
 
-  // Realloc the table to avoid going off bounds.
-  trianglesPerThread = (uint **) realloc(trianglesPerThread, totalSize);
-
   for (int i = 0; i < MAX_THREADS; i++) {
     pthread_create(&threads[i], NULL, countTrianglesVoid, (void *) &arg[i]);
   }
@@ -154,6 +156,7 @@ uint countTrianglesPthread(csr table, int MAX_THREADS) {
     pthread_join(threads[i], NULL);
   }
 
+  start = traceStart();
   for (int i = 0; i < MAX_THREADS; i++) {
     uint threadStart = arg[i].csrarg.start;
     uint threadSize = arg[i].csrarg.table.size;
@@ -174,88 +177,20 @@ uint countTrianglesPthread(csr table, int MAX_THREADS) {
       triangles[threadStart + j] = trianglesPerThread[i][j];
     }
   }
+  traceRecord("stitch", TRACE_MAIN, start);
 
   // for (uint i = 0; i < size; i++) {
   //   printf(" %u ", triangles[i]);
   // }
 
-  return triangles;
-}
-
-
-data_arg measureTimePthread(csr mtx, char *filename, int MAX_THREADS) {
-  struct timeval stop, start;
-
-  gettimeofday(&start, NULL);
-  uint *triangles = countTrianglesPthread(mtx, MAX_THREADS);
-  gettimeofday(&stop, NULL);
-  
-  uint timediff = (stop.tv_sec - start.tv_sec) * 1000000 + stop.tv_usec - start.tv_usec;
-  
-  printf("\npthread took %u us for file %s, using %d threads.\n\n", 
-    timediff, filename, MAX_THREADS);
-
-  data_arg data = {timediff, triangles};
-  return data;
-}
-
-
-int main(int argc, char **argv) {
-  int M, N, nz;
-  MM_typecode *t;
-
-  char *filenames[5] = {
-    "tables/belgium_osm.mtx",
-    "tables/dblp-2010.mtx",
-    "tables/NACA0015.mtx",
-    "tables/mycielskian13.mtx",
-    "tables/com-Youtube.mtx"
-  };
-
-  int num_threads[3] = {2, 4, 8};
-
-  int files_num = 5;
-  int thread_num = 3;
-  int reps = 12;
-
-  // Select the number of threads.
-  int thread_index = atoi(argv[1]);
-  // Select the matrix to be read.
-  int file = atoi(argv[2]);
-
-  FILE *statsFile = fopen("stats/data.csv", "a");
-
-  // Set the title, depending on the number of threads selected.
-  // Then print it, if this is the first file for that number.
-  char pth[5] = "pthN";
-  pth[3] = num_threads[thread_index] + '0';
-  if (file == 0) {
-    fprintf(statsFile, "\n%s", pth);
-  }
-
-  csr mtx = readmtx_dynamic(filenames[file], t, N, M, nz);
-  csr *mtx_addr = &mtx;
-
-  unsigned long totalTime = 0;
-  unsigned long *time_addr = &totalTime;
-
-  for (int rep = 0; rep < reps; rep++) {
-    data_arg data = measureTimePthread(mtx, filenames[file], num_threads[thread_index]);
-    data_arg *data_addr = &data;
-
-    if (rep > 1) {
-      totalTime += data.time;
-    }
-    remove(data_addr);
+  // Everything but the result, so that the repetitions don't pile up.
+  for (int i = 0; i < MAX_THREADS; i++) {
+    freeCSR(arg[i].csrarg.table);
+    free(arg[i].triangles);
+    free(trianglesPerThread[i]);
   }
+  free(trianglesPerThread);
+  freeThreadArguments(pthread_csr, MAX_THREADS);
 
-  uint meanTime = totalTime / (reps - 2);
-
-  remove(time_addr);
-  remove(mtx_addr);
-
-  fprintf(statsFile, "\t%u", meanTime);
-  fclose(statsFile);
-
-  return 0;
-}
\ No newline at end of file
+  return triangles;
+}
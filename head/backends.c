@@ -0,0 +1,60 @@
+/*
+ * backends.c
+ * The list of every backend the driver can run. See headers/backends.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../headers/mmio.h"
+#include "../headers/csr.h"
+#include "../headers/helpers.h"
+#include "../headers/numa_helpers.h"
+#include "../headers/edge_split.h"
+#include "../headers/backends.h"
+#include "../headers/trace.h"
+
+
+// Serial version of the algorithm. The table is processed as a single sub-table of rows.
+uint *countTrianglesSerial(csr table, int threads, numa_plan *plan) {
+  double start = traceStart();
+  csr C = hadamardSingleStep(table, 0, table.size);
+  traceRecord("hadamard", 0, start);
+
+  start = traceStart();
+  uint *triangles = countTriangles(C);
+  traceRecord("count", 0, start);
+
+  freeCSR(C);
+  return triangles;
+}
+
+
+// New engines only need to be added here.
+backend backends[] = {
+  {"serial", "seq", 0, countTrianglesSerial},
+  {"pthreads", "pth", 1, countTrianglesPthread},
+  {"pthreads-edge", "pthe", 1, countTrianglesEdges},
+#ifdef _OPENMP
+  {"openmp", "omp", 1, countTrianglesOMP},
+  {"openmp-edge", "ompe", 1, countTrianglesEdgesOMP},
+#endif
+#ifdef WITH_CILK
+  {"cilk", "cilk", 1, countTrianglesCilk},
+  {"cilk-edge", "cilke", 1, countTrianglesEdgesCilk},
+#endif
+};
+
+int backends_num = sizeof(backends) / sizeof(backend);
+
+
+// Returns NULL if there is no backend with that name in this build.
+backend *findBackend(char *name) {
+  for (int i = 0; i < backends_num; i++) {
+    if (strcmp(backends[i].name, name) == 0) {
+      return &backends[i];
+    }
+  }
+  return NULL;
+}
@@ -0,0 +1,360 @@
+/*
+ * bench.c
+ * The benchmark harness. See headers/bench.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../headers/bench.h"
+#include "../headers/verify.h"
+
+// Passed by the Makefile, so the results say how the binary was built.
+#ifndef BUILD_FLAGS
+#define BUILD_FLAGS "unknown"
+#endif
+
+#if defined(__clang__)
+#define COMPILER_VERSION __VERSION__
+#elif defined(__GNUC__)
+#define COMPILER_VERSION "gcc " __VERSION__
+#else
+#define COMPILER_VERSION "unknown"
+#endif
+
+
+// The time in us, from a clock that never jumps back.
+double nowMicros() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+
+static int compareDoubles(const void *a, const void *b) {
+  double x = *(const double *) a;
+  double y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+
+// The value below which a fraction p of the sorted samples lie, with linear interpolation.
+static double percentile(double *sorted, int count, double p) {
+  double position = p * (count - 1);
+  int below = (int) position;
+  int above = (below + 1 < count) ? below + 1 : below;
+
+  return sorted[below] + (position - below) * (sorted[above] - sorted[below]);
+}
+
+
+time_stats computeStats(double *times, int count) {
+  time_stats stats = {0, 0, 0, 0, 0, count};
+  if (count == 0) {
+    return stats;
+  }
+
+  double *sorted = (double *) malloc(count * sizeof(double));
+  memcpy(sorted, times, count * sizeof(double));
+  qsort(sorted, count, sizeof(double), compareDoubles);
+
+  double sum = 0;
+  for (int i = 0; i < count; i++) {
+    sum += sorted[i];
+  }
+  stats.mean = sum / count;
+
+  double squares = 0;
+  for (int i = 0; i < count; i++) {
+    squares += (sorted[i] - stats.mean) * (sorted[i] - stats.mean);
+  }
+  // The sample standard deviation.
+  stats.stddev = (count > 1) ? sqrt(squares / (count - 1)) : 0;
+
+  stats.min = sorted[0];
+  stats.median = percentile(sorted, count, 0.5);
+  stats.p95 = percentile(sorted, count, 0.95);
+
+  free(sorted);
+  return stats;
+}
+
+
+bench_meta readBenchMeta() {
+  bench_meta meta;
+
+  if (gethostname(meta.host, sizeof(meta.host)) != 0) {
+    strcpy(meta.host, "unknown");
+  }
+  snprintf(meta.compiler, sizeof(meta.compiler), "%s", COMPILER_VERSION);
+  snprintf(meta.flags, sizeof(meta.flags), "%s", BUILD_FLAGS);
+
+  time_t now = time(NULL);
+  strftime(meta.date, sizeof(meta.date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+  meta.cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return meta;
+}
+
+
+// "tables/com-Youtube.mtx" -> "com-Youtube". The caller frees the result.
+char *graphName(char *path) {
+  char *base = strrchr(path, '/');
+  base = (base != NULL) ? base + 1 : path;
+
+  char *name = strdup(base);
+  char *extension = strrchr(name, '.');
+  if (extension != NULL && extension != name) {
+    *extension = '\0';
+  }
+
+  return name;
+}
+
+
+static const char *verifiedName(int verified) {
+  return (verified == VERIFY_OK) ? "ok" : (verified == VERIFY_MISMATCH) ? "mismatch" : "NA";
+}
+
+
+// One row per result. Tab separated, like stats/data.csv, with the metadata
+// repeated in every row so that each row can be read on its own.
+void writeResultsCSV(char *path, bench_result *results, int count, bench_meta meta) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    printf("Couldn't write %s\n", path);
+    return;
+  }
+
+  fprintf(file, "graph\tbackend\tlabel\tthreads\twarmups\treps\tmin_us\tmedian_us\tmean_us\tp95_us\tstddev_us"
+    "\tintersections_per_s\tipc\tllc_misses_per_edge\ttriangles\tchecksum\tverified"
+    "\tpeak_heap_bytes\tpeak_rss_bytes\tretained_bytes_per_rep\theap_bytes_per_edge\thost\tcompiler\tflags\tdate\n");
+
+  for (int i = 0; i < count; i++) {
+    time_stats s = results[i].stats;
+    // Runs that were skipped have no row.
+    if (s.samples == 0) {
+      continue;
+    }
+    fprintf(file, "%s\t%s\t%s\t%d\t%d\t%d\t%.1f\t%.1f\t%.1f\t%.1f\t%.1f\t%.0f\t",
+      results[i].graph, results[i].backend, results[i].label, results[i].threads,
+      results[i].warmups, s.samples, s.min, s.median, s.mean, s.p95, s.stddev, results[i].intersections);
+
+    // NA when the counters weren't on.
+    if (results[i].ipc >= 0) {
+      fprintf(file, "%.3f\t%.4f", results[i].ipc, results[i].missesPerEdge);
+    } else {
+      fprintf(file, "NA\tNA");
+    }
+    fprintf(file, "\t%llu\t%016llx\t%s", results[i].triangles, results[i].checksum,
+      verifiedName(results[i].verified));
+
+    // NA when the memory wasn't accounted.
+    if (results[i].peakHeap >= 0) {
+      fprintf(file, "\t%lld\t%lld\t%lld\t%.2f", results[i].peakHeap, results[i].peakRSS,
+        results[i].retained, results[i].bytesPerEdge);
+    } else {
+      fprintf(file, "\tNA\tNA\tNA\tNA");
+    }
+    fprintf(file, "\t%s\t%s\t%s\t%s\n", meta.host, meta.compiler, meta.flags, meta.date);
+  }
+
+  fclose(file);
+}
+
+
+// Escapes the characters JSON doesn't allow in strings. Our strings are names and
+// compiler versions, so quotes and backslashes are all we expect.
+static void writeJSONString(FILE *file, char *string) {
+  fputc('"', file);
+  for (char *c = string; *c != '\0'; c++) {
+    if (*c == '"' || *c == '\\') {
+      fputc('\\', file);
+    }
+    if ((unsigned char) *c >= 0x20) {
+      fputc(*c, file);
+    }
+  }
+  fputc('"', file);
+}
+
+
+void writeResultsJSON(char *path, bench_result *results, int count, bench_meta meta) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    printf("Couldn't write %s\n", path);
+    return;
+  }
+
+  fprintf(file, "{\n  \"meta\": {\n    \"host\": ");
+  writeJSONString(file, meta.host);
+  fprintf(file, ",\n    \"compiler\": ");
+  writeJSONString(file, meta.compiler);
+  fprintf(file, ",\n    \"flags\": ");
+  writeJSONString(file, meta.flags);
+  fprintf(file, ",\n    \"date\": ");
+  writeJSONString(file, meta.date);
+  fprintf(file, ",\n    \"cpus\": %ld\n  },\n  \"results\": [", meta.cpus);
+
+  int written = 0;
+  for (int i = 0; i < count; i++) {
+    time_stats s = results[i].stats;
+    if (s.samples == 0) {
+      continue;
+    }
+
+    fprintf(file, "%s\n    {\"graph\": ", (written++ == 0) ? "" : ",");
+    writeJSONString(file, results[i].graph);
+    fprintf(file, ", \"backend\": ");
+    writeJSONString(file, results[i].backend);
+    fprintf(file, ", \"label\": ");
+    writeJSONString(file, results[i].label);
+    fprintf(file, ", \"threads\": %d, \"warmups\": %d, \"reps\": %d,\n", results[i].threads,
+      results[i].warmups, s.samples);
+    fprintf(file, "     \"min_us\": %.1f, \"median_us\": %.1f, \"mean_us\": %.1f, \"p95_us\": %.1f, \"stddev_us\": %.1f,\n",
+      s.min, s.median, s.mean, s.p95, s.stddev);
+    fprintf(file, "     \"intersections_per_s\": %.0f, ", results[i].intersections);
+    if (results[i].ipc >= 0) {
+      fprintf(file, "\"ipc\": %.3f, \"llc_misses_per_edge\": %.4f,\n", results[i].ipc, results[i].missesPerEdge);
+    } else {
+      fprintf(file, "\"ipc\": null, \"llc_misses_per_edge\": null,\n");
+    }
+    fprintf(file, "     \"triangles\": %llu, \"checksum\": \"%016llx\", \"verified\": \"%s\",\n",
+      results[i].triangles, results[i].checksum, verifiedName(results[i].verified));
+    if (results[i].peakHeap >= 0) {
+      fprintf(file, "     \"peak_heap_bytes\": %lld, \"peak_rss_bytes\": %lld, \"retained_bytes_per_rep\": %lld,"
+        " \"heap_bytes_per_edge\": %.2f,\n", results[i].peakHeap, results[i].peakRSS, results[i].retained,
+        results[i].bytesPerEdge);
+    } else {
+      fprintf(file, "     \"peak_heap_bytes\": null, \"peak_rss_bytes\": null, \"retained_bytes_per_rep\": null,"
+        " \"heap_bytes_per_edge\": null,\n");
+    }
+
+    fprintf(file, "     \"times_us\": [");
+    for (int j = 0; j < s.samples; j++) {
+      fprintf(file, "%s%.1f", (j == 0) ? "" : ", ", results[i].times[j]);
+    }
+    fprintf(file, "]}");
+  }
+
+  fprintf(file, "\n  ]\n}\n");
+  fclose(file);
+}
+
+
+// Where the value of key starts in the object [object, end). NULL if it isn't there.
+static char *findJSONKey(char *object, char *end, const char *key) {
+  char pattern[64];
+  snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+
+  char *found = strstr(object, pattern);
+  if (found == NULL || found >= end) {
+    return NULL;
+  }
+  found += strlen(pattern);
+  while (*found == ' ') {
+    found++;
+  }
+  return found;
+}
+
+
+// A copy of the string value at value, without the escapes writeJSONString() added.
+static char *readJSONString(char *value) {
+  if (value == NULL || *value != '"') {
+    return strdup("");
+  }
+
+  char *string = (char *) malloc(strlen(value) + 1);
+  int length = 0;
+  for (char *c = value + 1; *c != '\0' && *c != '"'; c++) {
+    if (*c == '\\' && c[1] != '\0') {
+      c++;
+    }
+    string[length++] = *c;
+  }
+  string[length] = '\0';
+  return string;
+}
+
+
+// Reads back the results of writeResultsJSON(): the names, the threads and every
+// measured time of each run, with their statistics. Only reads our own format.
+// Returns NULL if the file can't be read, and sets count to the number of runs.
+bench_result *readResultsJSON(char *path, int *count) {
+  *count = 0;
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    printf("Couldn't read %s\n", path);
+    return NULL;
+  }
+
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char *text = (char *) malloc(length + 1);
+  length = fread(text, 1, length, file);
+  text[length] = '\0';
+  fclose(file);
+
+  // Every run is an object that starts with its graph.
+  int capacity = 0;
+  for (char *object = strstr(text, "\"graph\":"); object != NULL; object = strstr(object + 1, "\"graph\":")) {
+    capacity++;
+  }
+  bench_result *results = (bench_result *) calloc((capacity > 0) ? capacity : 1, sizeof(bench_result));
+
+  for (char *object = strstr(text, "\"graph\":"); object != NULL; ) {
+    char *next = strstr(object + 1, "\"graph\":");
+    char *end = (next != NULL) ? next : text + length;
+
+    bench_result *result = &results[*count];
+    result->graph = readJSONString(findJSONKey(object, end, "graph"));
+    result->backend = readJSONString(findJSONKey(object, end, "backend"));
+    result->label = readJSONString(findJSONKey(object, end, "label"));
+    char *threads = findJSONKey(object, end, "threads");
+    result->threads = (threads != NULL) ? atoi(threads) : 1;
+    char *warmups = findJSONKey(object, end, "warmups");
+    result->warmups = (warmups != NULL) ? atoi(warmups) : 0;
+
+    char *times = findJSONKey(object, end, "times_us");
+    int samples = 0;
+    if (times != NULL && *times == '[') {
+      for (char *c = times; c < end && *c != ']'; c++) {
+        samples += (*c == ',');
+      }
+      samples++;
+      result->times = (double *) malloc(samples * sizeof(double));
+
+      char *c = times + 1;
+      samples = 0;
+      while (c < end && *c != ']') {
+        char *after;
+        double time = strtod(c, &after);
+        if (after == c) {
+          break;
+        }
+        result->times[samples++] = time;
+        c = after;
+        while (*c == ',' || *c == ' ') {
+          c++;
+        }
+      }
+    }
+    result->stats = computeStats(result->times, samples);
+    result->ipc = -1;
+    result->missesPerEdge = -1;
+    result->verified = VERIFY_NONE;
+    result->peakHeap = -1;
+
+    (*count)++;
+    object = next;
+  }
+
+  free(text);
+  return results;
+}
@@ -0,0 +1,301 @@
+/*
+ * clique.c
+ * k-clique counting on the oriented graph. See headers/clique.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../headers/csr.h"
+#include "../headers/trace.h"
+#include "../headers/clique.h"
+
+// The oriented graph: the out-neighbors of every vertex, sorted like the table's rows.
+typedef struct {
+  uint size;
+  uint *rowIndex;
+  uint *colIndex;
+  uint maxOut;
+} clique_dag;
+
+// What the recursion of a thread needs: k, the chosen vertices and a buffer per level.
+typedef struct {
+  clique_dag *dag;
+  int k;
+  uint stack[CLIQUE_MAX_K];
+  uint *scratch;
+  uint *counts;
+} clique_search;
+
+
+int parseCliqueOrdering(char *name) {
+  if (strcmp(name, "degeneracy") == 0) {
+    return CLIQUE_DEGENERACY;
+  }
+  if (strcmp(name, "degree") == 0) {
+    return CLIQUE_DEGREE;
+  }
+  return -1;
+}
+
+
+const char *cliqueOrderingName(int ordering) {
+  return (ordering == CLIQUE_DEGREE) ? "degree" : "degeneracy";
+}
+
+
+static uint degreeOf(csr table, uint vertex) {
+  uint degree = 0;
+  for (uint i = table.rowIndex[vertex]; i < table.rowIndex[vertex + 1]; i++) {
+    degree += (table.colIndex[i] != vertex);
+  }
+  return degree;
+}
+
+
+// The order the cores peel the vertices in (Batagelj and Zaversnik): always the vertex
+// of lowest remaining degree next, kept in buckets by degree.
+static uint *degeneracyRanks(csr table) {
+  uint size = table.size;
+  uint *degree = (uint *) malloc(size * sizeof(uint));
+  uint maxDegree = 0;
+  for (uint v = 0; v < size; v++) {
+    degree[v] = degreeOf(table, v);
+    maxDegree = (degree[v] > maxDegree) ? degree[v] : maxDegree;
+  }
+
+  // The vertices sorted by degree, where every bucket starts, and where every vertex is.
+  uint *bucket = (uint *) calloc(maxDegree + 2, sizeof(uint));
+  uint *sorted = (uint *) malloc(size * sizeof(uint));
+  uint *position = (uint *) malloc(size * sizeof(uint));
+  for (uint v = 0; v < size; v++) {
+    bucket[degree[v] + 1]++;
+  }
+  for (uint d = 0; d <= maxDegree; d++) {
+    bucket[d + 1] += bucket[d];
+  }
+  for (uint v = 0; v < size; v++) {
+    position[v] = bucket[degree[v]]++;
+    sorted[position[v]] = v;
+  }
+  for (uint d = maxDegree + 1; d > 0; d--) {
+    bucket[d] = bucket[d - 1];
+  }
+  bucket[0] = 0;
+
+  uint *rank = (uint *) malloc(size * sizeof(uint));
+  for (uint i = 0; i < size; i++) {
+    uint v = sorted[i];
+    rank[v] = i;
+
+    // Every neighbor still to peel loses a degree: it swaps with the first of its bucket,
+    // which then starts one later.
+    for (uint j = table.rowIndex[v]; j < table.rowIndex[v + 1]; j++) {
+      uint u = table.colIndex[j];
+      if (u == v || degree[u] <= degree[v]) {
+        continue;
+      }
+      uint first = bucket[degree[u]];
+      uint w = sorted[first];
+      if (w != u) {
+        sorted[position[u]] = w;
+        position[w] = position[u];
+        sorted[first] = u;
+        position[u] = first;
+      }
+      bucket[degree[u]]++;
+      degree[u]--;
+    }
+  }
+
+  free(degree);
+  free(bucket);
+  free(sorted);
+  free(position);
+  return rank;
+}
+
+
+// Whether the edge (u, v) goes from u to v.
+static int before(uint *rank, uint *degree, uint u, uint v) {
+  if (rank != NULL) {
+    return rank[u] < rank[v];
+  }
+  return degree[u] < degree[v] || (degree[u] == degree[v] && u < v);
+}
+
+
+static clique_dag orient(csr table, int ordering, int threads) {
+  uint size = table.size;
+  uint *rank = NULL;
+  uint *degree = NULL;
+  if (ordering == CLIQUE_DEGENERACY) {
+    rank = degeneracyRanks(table);
+  } else {
+    degree = (uint *) malloc(size * sizeof(uint));
+    #pragma omp parallel for schedule(dynamic, 1024) num_threads(threads)
+    for (uint v = 0; v < size; v++) {
+      degree[v] = degreeOf(table, v);
+    }
+  }
+
+  clique_dag dag;
+  dag.size = size;
+  dag.rowIndex = (uint *) calloc(size + 1, sizeof(uint));
+  #pragma omp parallel for schedule(dynamic, 1024) num_threads(threads)
+  for (uint u = 0; u < size; u++) {
+    uint out = 0;
+    for (uint i = table.rowIndex[u]; i < table.rowIndex[u + 1]; i++) {
+      uint v = table.colIndex[i];
+      out += (v != u && before(rank, degree, u, v));
+    }
+    dag.rowIndex[u + 1] = out;
+  }
+
+  dag.maxOut = 0;
+  for (uint u = 0; u < size; u++) {
+    dag.maxOut = (dag.rowIndex[u + 1] > dag.maxOut) ? dag.rowIndex[u + 1] : dag.maxOut;
+    dag.rowIndex[u + 1] += dag.rowIndex[u];
+  }
+
+  dag.colIndex = (uint *) malloc(((dag.rowIndex[size] > 0) ? dag.rowIndex[size] : 1) * sizeof(uint));
+  #pragma omp parallel for schedule(dynamic, 1024) num_threads(threads)
+  for (uint u = 0; u < size; u++) {
+    uint position = dag.rowIndex[u];
+    for (uint i = table.rowIndex[u]; i < table.rowIndex[u + 1]; i++) {
+      uint v = table.colIndex[i];
+      if (v != u && before(rank, degree, u, v)) {
+        dag.colIndex[position++] = v;
+      }
+    }
+  }
+
+  free(rank);
+  free(degree);
+  return dag;
+}
+
+
+// The cliques that extend the level chosen vertices with candidates. Every one found is
+// counted at each of its vertices.
+static unsigned long long expand(clique_search *search, int level, uint *candidates, uint size) {
+  if (level == search->k - 1) {
+    for (uint i = 0; i < size; i++) {
+      __atomic_add_fetch(&search->counts[candidates[i]], 1, __ATOMIC_RELAXED);
+    }
+    for (int l = 0; l < level; l++) {
+      __atomic_add_fetch(&search->counts[search->stack[l]], size, __ATOMIC_RELAXED);
+    }
+    return size;
+  }
+
+  clique_dag *dag = search->dag;
+  uint *next = &search->scratch[(level - 1) * dag->maxOut];
+  unsigned long long found = 0;
+
+  for (uint c = 0; c < size; c++) {
+    uint v = candidates[c];
+    uint *out = &dag->colIndex[dag->rowIndex[v]];
+    uint outSize = dag->rowIndex[v + 1] - dag->rowIndex[v];
+
+    // The candidates that v points to too, since they're above it in the order.
+    uint i = 0, j = 0, nextSize = 0;
+    while (i < size && j < outSize) {
+      if (candidates[i] == out[j]) {
+        next[nextSize++] = candidates[i];
+        i++;
+        j++;
+      } else if (candidates[i] < out[j]) {
+        i++;
+      } else {
+        j++;
+      }
+    }
+
+    // A clique needs k - level - 1 more vertices after v.
+    if (nextSize >= (uint) (search->k - level - 1)) {
+      search->stack[level] = v;
+      found += expand(search, level + 1, next, nextSize);
+    }
+  }
+
+  return found;
+}
+
+
+// A vertex with its out-degree, so that sorting needs no state outside the pair.
+typedef struct {
+  uint degree;
+  uint vertex;
+} ranked_vertex;
+
+// The larger out-degree first, then the smaller vertex.
+static int compareOutDegree(const void *a, const void *b) {
+  const ranked_vertex *x = (const ranked_vertex *) a, *y = (const ranked_vertex *) b;
+  if (x->degree != y->degree) {
+    return (x->degree < y->degree) - (x->degree > y->degree);
+  }
+  return (x->vertex > y->vertex) - (x->vertex < y->vertex);
+}
+
+
+// The k-cliques of every vertex. total gets their number. NULL if k is out of range.
+uint *countCliques(csr table, int k, int ordering, int threads, unsigned long long *total) {
+  if (k < 3 || k > CLIQUE_MAX_K) {
+    return NULL;
+  }
+  threads = (threads < 1) ? 1 : threads;
+  uint size = table.size;
+
+  double start = traceStart();
+  clique_dag dag = orient(table, ordering, threads);
+  traceRecord("orient", TRACE_MAIN, start);
+
+  // The biggest top-level vertices first, so that no thread ends up with one at the end.
+  start = traceStart();
+  ranked_vertex *ranked = (ranked_vertex *) malloc(((size > 0) ? size : 1) * sizeof(ranked_vertex));
+  for (uint v = 0; v < size; v++) {
+    ranked[v].degree = dag.rowIndex[v + 1] - dag.rowIndex[v];
+    ranked[v].vertex = v;
+  }
+  qsort(ranked, size, sizeof(ranked_vertex), compareOutDegree);
+  uint *order = (uint *) malloc(((size > 0) ? size : 1) * sizeof(uint));
+  for (uint v = 0; v < size; v++) {
+    order[v] = ranked[v].vertex;
+  }
+  free(ranked);
+
+  uint *counts = (uint *) calloc((size > 0) ? size : 1, sizeof(uint));
+  unsigned long long found = 0;
+
+  #pragma omp parallel num_threads(threads) reduction(+:found)
+  {
+    clique_search search;
+    search.dag = &dag;
+    search.k = k;
+    search.counts = counts;
+    search.scratch = (uint *) malloc(((dag.maxOut > 0) ? dag.maxOut : 1) * (k - 1) * sizeof(uint));
+
+    #pragma omp for schedule(dynamic, 1)
+    for (uint i = 0; i < size; i++) {
+      uint u = order[i];
+      uint outSize = dag.rowIndex[u + 1] - dag.rowIndex[u];
+      if (outSize >= (uint) (k - 1)) {
+        search.stack[0] = u;
+        found += expand(&search, 1, &dag.colIndex[dag.rowIndex[u]], outSize);
+      }
+    }
+
+    free(search.scratch);
+  }
+  traceRecord("count", TRACE_MAIN, start);
+
+  free(order);
+  free(dag.rowIndex);
+  free(dag.colIndex);
+  if (total != NULL) {
+    *total = found;
+  }
+  return counts;
+}
@@ -0,0 +1,113 @@
+/*
+ * counters.c
+ * Per-thread hardware counters. See headers/counters.h.
+ *
+ * Every thread opens one group of counters, so that they are all read at once and
+ * cover the same instructions. If the group had to share the PMU with other events,
+ * the kernel only ran it part of the time, and the counts are scaled up accordingly.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "../headers/counters.h"
+
+int counters_enabled = 0;
+
+const char *counter_names[COUNTERS_NUM] = {"cycles", "instructions", "llc-misses", "branch-misses"};
+
+static const unsigned long long counter_configs[COUNTERS_NUM] = {
+  PERF_COUNT_HW_CPU_CYCLES,
+  PERF_COUNT_HW_INSTRUCTIONS,
+  PERF_COUNT_HW_CACHE_MISSES,
+  PERF_COUNT_HW_BRANCH_MISSES
+};
+
+// The file descriptors of the calling thread. -1 until it first reads them.
+static __thread int counter_fds[COUNTERS_NUM] = {-1, -1, -1, -1};
+static pthread_key_t counters_key;
+
+
+static int openCounter(unsigned long long config, int group) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  // This thread, on any cpu.
+  return syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+
+// Called when a thread that opened counters exits.
+static void closeCounters(void *fds) {
+  int *thread_fds = (int *) fds;
+  for (int i = COUNTERS_NUM - 1; i >= 0; i--) {
+    if (thread_fds[i] >= 0) {
+      close(thread_fds[i]);
+      thread_fds[i] = -1;
+    }
+  }
+}
+
+
+static int openCounters() {
+  for (int i = 0; i < COUNTERS_NUM; i++) {
+    counter_fds[i] = openCounter(counter_configs[i], (i == 0) ? -1 : counter_fds[0]);
+    if (counter_fds[i] < 0) {
+      closeCounters(counter_fds);
+      return 0;
+    }
+  }
+
+  pthread_setspecific(counters_key, counter_fds);
+  ioctl(counter_fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return 1;
+}
+
+
+// Checks that this machine lets us count. Returns 1 if it does.
+int countersEnable() {
+  pthread_key_create(&counters_key, closeCounters);
+
+  if (!openCounters()) {
+    printf("Hardware counters aren't available. Check /proc/sys/kernel/perf_event_paranoid "
+      "(and that the machine exposes a PMU). Reporting times only.\n");
+    counters_enabled = 0;
+    return 0;
+  }
+
+  counters_enabled = 1;
+  return 1;
+}
+
+
+// The counts of the calling thread so far. Returns 0 if they can't be read.
+int countersRead(long long *values) {
+  if (!counters_enabled || (counter_fds[0] < 0 && !openCounters())) {
+    return 0;
+  }
+
+  // nr, time enabled, time running, then one value per counter.
+  unsigned long long data[3 + COUNTERS_NUM];
+  if (read(counter_fds[0], data, sizeof(data)) != sizeof(data) || data[0] != COUNTERS_NUM) {
+    return 0;
+  }
+
+  double scale = (data[2] > 0) ? (double) data[1] / data[2] : 1;
+  for (int i = 0; i < COUNTERS_NUM; i++) {
+    values[i] = (long long) (data[3 + i] * scale);
+  }
+
+  return 1;
+}
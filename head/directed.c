@@ -0,0 +1,364 @@
+/*
+ * directed.c
+ * Directed graphs from .mtx files and their triangle census. See headers/directed.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../headers/csr.h"
+#include "../headers/mmio.h"
+#include "../headers/helpers.h"
+#include "../headers/bench.h"
+#include "../headers/trace.h"
+#include "../headers/intersect.h"
+#include "../headers/directed.h"
+
+// Which way the edge of an entry of the union goes, from its row to its column or back.
+#define DIRECTED_FORWARD 1
+#define DIRECTED_BACKWARD 2
+#define DIRECTED_BOTH 3
+
+// The union of out and in: every neighbor once, with the way its edge goes.
+typedef struct {
+  uint size;
+  uint *rowIndex;
+  uint *colIndex;
+  unsigned char *direction;
+} census_table;
+
+
+static const char *typeNames[DIRECTED_TYPES] = { "030T", "030C", "120D", "120U", "120C", "210", "300" };
+
+const char *directedTypeName(int type) {
+  return (type >= 0 && type < DIRECTED_TYPES) ? typeNames[type] : "unknown";
+}
+
+
+static csr emptyCSR(uint size, uint nonzeros) {
+  csr table;
+  table.size = size;
+  table.rowIndex = (uint *) calloc(size + 1, sizeof(uint));
+  table.colIndex = (uint *) malloc(((nonzeros > 0) ? nonzeros : 1) * sizeof(uint));
+  table.values = (int *) malloc(((nonzeros > 0) ? nonzeros : 1) * sizeof(int));
+  for (uint i = 0; i < nonzeros; i++) {
+    table.values[i] = 1;
+  }
+  return table;
+}
+
+
+// The rows of table become the columns. The rows of the result are sorted.
+static csr transposeCSR(csr table) {
+  uint size = table.size;
+  uint nonzeros = table.rowIndex[size];
+  csr result = emptyCSR(size, nonzeros);
+
+  for (uint i = 0; i < nonzeros; i++) {
+    result.rowIndex[table.colIndex[i] + 1]++;
+  }
+  for (uint row = 0; row < size; row++) {
+    result.rowIndex[row + 1] += result.rowIndex[row];
+  }
+
+  uint *position = (uint *) malloc(((size > 0) ? size : 1) * sizeof(uint));
+  memcpy(position, result.rowIndex, size * sizeof(uint));
+  for (uint row = 0; row < size; row++) {
+    for (uint i = table.rowIndex[row]; i < table.rowIndex[row + 1]; i++) {
+      result.colIndex[position[table.colIndex[i]]++] = row;
+    }
+  }
+
+  free(position);
+  return result;
+}
+
+
+// Drops the repeated columns of the sorted rows, in place.
+static void dedupeRows(csr *table) {
+  uint position = 0;
+  uint start = 0;
+  for (uint row = 0; row < table->size; row++) {
+    uint end = table->rowIndex[row + 1];
+    for (uint i = start; i < end; i++) {
+      if (i == start || table->colIndex[i] != table->colIndex[i - 1]) {
+        table->colIndex[position++] = table->colIndex[i];
+      }
+    }
+    start = end;
+    table->rowIndex[row + 1] = position;
+  }
+}
+
+
+// Every entry is an edge from its row to its column, both ways in a symmetric or skew file.
+// Both tables are empty if the file can't be read.
+directed_graph readDirectedMtx(char *path) {
+  directed_graph graph;
+  memset(&graph, 0, sizeof(graph));
+
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    printf("Couldn't read %s\n", path);
+    return graph;
+  }
+
+  MM_typecode t;
+  int M, N, nz;
+  if (mm_read_banner(file, &t) != 0 || mm_read_mtx_crd_size(file, &M, &N, &nz) != 0 || M != N) {
+    printf("Error. Couldn't process the .mtx file!");
+    fclose(file);
+    return graph;
+  }
+  int mirror = mm_is_symmetric(t) || mm_is_skew(t) || mm_is_hermitian(t);
+  printf("\n%s: %d vertices, %d entries, %s\n", path, N, nz, mirror ? "symmetric" : "general");
+
+  // The edges by their source, in the order of the file.
+  uint size = N;
+  uint capacity = (mirror ? 2 : 1) * (uint) nz;
+  uint *source = (uint *) malloc(((capacity > 0) ? capacity : 1) * sizeof(uint));
+  uint *target = (uint *) malloc(((capacity > 0) ? capacity : 1) * sizeof(uint));
+  uint edges = 0;
+
+  char line[256];
+  int read = 0;
+  while (read < nz && fgets(line, sizeof(line), file) != NULL) {
+    uint u, v;
+    if (line[0] == '%' || sscanf(line, "%u %u", &u, &v) != 2) {
+      continue;
+    }
+    read++;
+    if (u == v || u < 1 || v < 1 || u > size || v > size) {
+      continue;
+    }
+    source[edges] = u - 1;
+    target[edges++] = v - 1;
+    if (mirror) {
+      source[edges] = v - 1;
+      target[edges++] = u - 1;
+    }
+  }
+  fclose(file);
+
+  csr bySource = emptyCSR(size, edges);
+  for (uint e = 0; e < edges; e++) {
+    bySource.rowIndex[source[e] + 1]++;
+  }
+  for (uint row = 0; row < size; row++) {
+    bySource.rowIndex[row + 1] += bySource.rowIndex[row];
+  }
+  uint *position = (uint *) malloc(((size > 0) ? size : 1) * sizeof(uint));
+  memcpy(position, bySource.rowIndex, size * sizeof(uint));
+  for (uint e = 0; e < edges; e++) {
+    bySource.colIndex[position[source[e]]++] = target[e];
+  }
+  free(position);
+  free(source);
+  free(target);
+
+  // Transposing twice sorts the rows.
+  csr byTarget = transposeCSR(bySource);
+  freeCSR(bySource);
+  graph.out = transposeCSR(byTarget);
+  freeCSR(byTarget);
+  dedupeRows(&graph.out);
+  graph.in = transposeCSR(graph.out);
+  return graph;
+}
+
+
+// Merges out and in by row, in two passes: the size of every row, then the rows.
+static census_table unionOf(directed_graph graph, int threads) {
+  census_table table;
+  uint size = graph.out.size;
+  table.size = size;
+  table.rowIndex = (uint *) calloc(size + 1, sizeof(uint));
+  csr out = graph.out, in = graph.in;
+
+  for (int pass = 0; pass < 2; pass++) {
+    #pragma omp parallel for schedule(dynamic, 1024) num_threads(threads)
+    for (uint row = 0; row < size; row++) {
+      uint i = out.rowIndex[row], iEnd = out.rowIndex[row + 1];
+      uint j = in.rowIndex[row], jEnd = in.rowIndex[row + 1];
+      uint position = (pass == 0) ? 0 : table.rowIndex[row];
+
+      while (i < iEnd || j < jEnd) {
+        uint column;
+        unsigned char direction;
+        if (j == jEnd || (i < iEnd && out.colIndex[i] < in.colIndex[j])) {
+          column = out.colIndex[i++];
+          direction = DIRECTED_FORWARD;
+        } else if (i == iEnd || in.colIndex[j] < out.colIndex[i]) {
+          column = in.colIndex[j++];
+          direction = DIRECTED_BACKWARD;
+        } else {
+          column = out.colIndex[i++];
+          j++;
+          direction = DIRECTED_BOTH;
+        }
+        if (pass == 1) {
+          table.colIndex[position] = column;
+          table.direction[position] = direction;
+        }
+        position++;
+      }
+
+      if (pass == 0) {
+        table.rowIndex[row + 1] = position;
+      }
+    }
+
+    if (pass == 0) {
+      for (uint row = 0; row < size; row++) {
+        table.rowIndex[row + 1] += table.rowIndex[row];
+      }
+      uint nonzeros = table.rowIndex[size];
+      table.colIndex = (uint *) malloc(((nonzeros > 0) ? nonzeros : 1) * sizeof(uint));
+      table.direction = (unsigned char *) malloc((nonzeros > 0) ? nonzeros : 1);
+    }
+  }
+
+  return table;
+}
+
+
+// The type of the triangle u < v < w from the directions of (u, v), (u, w) and (v, w).
+static int triadType(int uv, int uw, int vw) {
+  int both = (uv == DIRECTED_BOTH) + (uw == DIRECTED_BOTH) + (vw == DIRECTED_BOTH);
+  if (both == 3) {
+    return DIRECTED_300;
+  }
+  if (both == 2) {
+    return DIRECTED_210;
+  }
+
+  // The edges every vertex sends within the triangle.
+  int outU = (uv & DIRECTED_FORWARD) + (uw & DIRECTED_FORWARD);
+  int outV = ((uv & DIRECTED_BACKWARD) >> 1) + (vw & DIRECTED_FORWARD);
+  int outW = ((uw & DIRECTED_BACKWARD) >> 1) + ((vw & DIRECTED_BACKWARD) >> 1);
+  if (both == 0) {
+    return (outU == 1 && outV == 1 && outW == 1) ? DIRECTED_030C : DIRECTED_030T;
+  }
+
+  // One reciprocal edge: the type depends on what the third vertex sends to the other two.
+  int third = (uv == DIRECTED_BOTH) ? outW : (uw == DIRECTED_BOTH) ? outV : outU;
+  return (third == 2) ? DIRECTED_120D : (third == 0) ? DIRECTED_120U : DIRECTED_120C;
+}
+
+
+// The position of the first column of [low, high) not below value.
+static uint lowerBound(uint *columns, uint low, uint high, uint value) {
+  while (low < high) {
+    uint middle = low + (high - low) / 2;
+    if (columns[middle] < value) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+
+static void countTriad(census_table *table, uint *vertices, unsigned long long *totals, uint u, uint i,
+    uint a, uint b) {
+  uint v = table->colIndex[i], w = table->colIndex[a];
+  int type = triadType(table->direction[i], table->direction[a], table->direction[b]);
+  totals[type]++;
+  __atomic_add_fetch(&vertices[(size_t) u * DIRECTED_TYPES + type], 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&vertices[(size_t) v * DIRECTED_TYPES + type], 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&vertices[(size_t) w * DIRECTED_TYPES + type], 1, __ATOMIC_RELAXED);
+}
+
+
+census_result directedCensus(directed_graph graph, int threads) {
+  census_result result;
+  memset(&result, 0, sizeof(result));
+  threads = (threads < 1) ? 1 : threads;
+
+  double start = nowMicros();
+  double begin = traceStart();
+  census_table table = unionOf(graph, threads);
+  traceRecord("union", TRACE_MAIN, begin);
+
+  uint size = table.size;
+  uint *columns = table.colIndex;
+  result.vertices = (uint *) calloc(((size > 0) ? size : 1) * (size_t) DIRECTED_TYPES, sizeof(uint));
+  unsigned long long totals[DIRECTED_TYPES] = {0};
+  unsigned long long reciprocal = 0;
+
+  begin = traceStart();
+  #pragma omp parallel for schedule(dynamic, 64) num_threads(threads) reduction(+:totals[:DIRECTED_TYPES], reciprocal)
+  for (uint u = 0; u < size; u++) {
+    uint end = table.rowIndex[u + 1];
+    for (uint i = lowerBound(columns, table.rowIndex[u], end, u + 1); i < end; i++) {
+      uint v = columns[i];
+      reciprocal += (table.direction[i] == DIRECTED_BOTH);
+
+      // The w above v in both rows: after v in the row of u, above v in the row of v.
+      uint a = i + 1;
+      uint bEnd = table.rowIndex[v + 1];
+      uint b = lowerBound(columns, table.rowIndex[v], bEnd, v + 1);
+
+      if (bEnd - b > INTERSECT_GALLOP_RATIO * (end - a)) {
+        for (; a < end; a++) {
+          b = lowerBound(columns, b, bEnd, columns[a]);
+          if (b == bEnd) {
+            break;
+          }
+          if (columns[b] == columns[a]) {
+            countTriad(&table, result.vertices, totals, u, i, a, b);
+          }
+        }
+      } else if (end - a > INTERSECT_GALLOP_RATIO * (bEnd - b)) {
+        for (; b < bEnd; b++) {
+          a = lowerBound(columns, a, end, columns[b]);
+          if (a == end) {
+            break;
+          }
+          if (columns[a] == columns[b]) {
+            countTriad(&table, result.vertices, totals, u, i, a, b);
+          }
+        }
+      } else {
+        while (a < end && b < bEnd) {
+          if (columns[a] < columns[b]) {
+            a++;
+          } else if (columns[a] > columns[b]) {
+            b++;
+          } else {
+            countTriad(&table, result.vertices, totals, u, i, a, b);
+            a++;
+            b++;
+          }
+        }
+      }
+    }
+  }
+  traceRecord("census", TRACE_MAIN, begin);
+
+  memcpy(result.totals, totals, sizeof(totals));
+  result.reciprocal = reciprocal;
+  result.time = nowMicros() - start;
+
+  free(table.rowIndex);
+  free(table.colIndex);
+  free(table.direction);
+  return result;
+}
+
+
+void freeDirectedGraph(directed_graph *graph) {
+  if (graph->out.rowIndex != NULL) {
+    freeCSR(graph->out);
+    freeCSR(graph->in);
+  }
+  memset(graph, 0, sizeof(directed_graph));
+}
+
+
+void freeCensusResult(census_result *result) {
+  free(result->vertices);
+  memset(result, 0, sizeof(census_result));
+}
@@ -0,0 +1,431 @@
+/*
+ * dynamic.c
+ * Incremental triangle counts under edge insertions and deletions. See headers/dynamic.h.
+ *
+ * The changed edges of a batch are kept as sorted 64-bit keys (u << 32 | v, u < v), so
+ * finding out whether another edge of a triangle is in the batch, and before which
+ * edge, is a binary search.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../headers/csr.h"
+#include "../headers/trace.h"
+#include "../headers/dynamic.h"
+
+typedef unsigned long long edge_key;
+
+// An update of the batch, after its endpoints were sorted.
+typedef struct {
+  edge_key key;
+  uint order;
+  int insert;
+} keyed_update;
+
+// One end of a changed edge: the block of source gets target added or removed.
+typedef struct {
+  uint source;
+  uint target;
+  int insert;
+} block_change;
+
+
+static edge_key edgeKey(uint u, uint v) {
+  return (u < v) ? ((edge_key) u << 32) | v : ((edge_key) v << 32) | u;
+}
+
+
+// The position of key in the sorted keys. -1 if it isn't there.
+static long findKey(edge_key *keys, uint count, edge_key key) {
+  long low = 0, high = (long) count - 1;
+  while (low <= high) {
+    long middle = (low + high) / 2;
+    if (keys[middle] == key) {
+      return middle;
+    }
+    if (keys[middle] < key) {
+      low = middle + 1;
+    } else {
+      high = middle - 1;
+    }
+  }
+  return -1;
+}
+
+
+// Whether the triangle (u, v, w) is counted by the changed edge at position index:
+// neither of its two other edges may be an earlier changed edge of the batch.
+static int countedHere(edge_key *keys, uint count, long index, uint u, uint v, uint w) {
+  long first = findKey(keys, count, edgeKey(u, w));
+  long second = findKey(keys, count, edgeKey(v, w));
+  return !(first >= 0 && first < index) && !(second >= 0 && second < index);
+}
+
+
+static int compareUpdates(const void *a, const void *b) {
+  const keyed_update *x = (const keyed_update *) a;
+  const keyed_update *y = (const keyed_update *) b;
+  if (x->key != y->key) {
+    return (x->key > y->key) - (x->key < y->key);
+  }
+  return (x->order > y->order) - (x->order < y->order);
+}
+
+
+static int compareChanges(const void *a, const void *b) {
+  const block_change *x = (const block_change *) a;
+  const block_change *y = (const block_change *) b;
+  if (x->source != y->source) {
+    return (x->source > y->source) - (x->source < y->source);
+  }
+  return (x->target > y->target) - (x->target < y->target);
+}
+
+
+// Makes room for the vertices up to size. The new ones have no neighbors.
+static void growVertices(dynamic_graph *graph, uint size) {
+  if (size <= graph->size) {
+    return;
+  }
+
+  if (size > graph->allocated) {
+    uint allocated = (graph->allocated > 0) ? graph->allocated : 16;
+    while (allocated < size) {
+      allocated *= 2;
+    }
+    graph->neighbors = (uint **) realloc(graph->neighbors, allocated * sizeof(uint *));
+    graph->degree = (uint *) realloc(graph->degree, allocated * sizeof(uint));
+    graph->capacity = (uint *) realloc(graph->capacity, allocated * sizeof(uint));
+    graph->triangles = (uint *) realloc(graph->triangles, allocated * sizeof(uint));
+    graph->allocated = allocated;
+  }
+
+  for (uint i = graph->size; i < size; i++) {
+    graph->neighbors[i] = NULL;
+    graph->degree[i] = 0;
+    graph->capacity[i] = 0;
+    graph->triangles[i] = 0;
+  }
+  graph->size = size;
+}
+
+
+// The triangles of every edge u < v, found from it, each once (w > v): the common
+// neighbors of u and v are merged out of their sorted blocks.
+uint *dynamicRecount(dynamic_graph *graph, int threads) {
+  uint size = graph->size;
+  uint *triangles = (uint *) calloc((size > 0) ? size : 1, sizeof(uint));
+
+  #pragma omp parallel for schedule(dynamic, 64) num_threads(threads)
+  for (uint u = 0; u < size; u++) {
+    uint *a = graph->neighbors[u];
+    uint sizeA = graph->degree[u];
+
+    for (uint k = 0; k < sizeA; k++) {
+      uint v = a[k];
+      if (v <= u) {
+        continue;
+      }
+
+      uint *b = graph->neighbors[v];
+      uint sizeB = graph->degree[v];
+      uint i = k + 1, j = 0;
+      while (i < sizeA && j < sizeB) {
+        if (a[i] == b[j]) {
+          __atomic_add_fetch(&triangles[u], 1, __ATOMIC_RELAXED);
+          __atomic_add_fetch(&triangles[v], 1, __ATOMIC_RELAXED);
+          __atomic_add_fetch(&triangles[a[i]], 1, __ATOMIC_RELAXED);
+          i++;
+          j++;
+        } else if (a[i] < b[j]) {
+          i++;
+        } else {
+          j++;
+        }
+      }
+    }
+  }
+
+  return triangles;
+}
+
+
+// Copies the table into sorted blocks, without its self loops, and counts its triangles.
+dynamic_graph dynamicFromCSR(csr table, int threads) {
+  dynamic_graph graph;
+  memset(&graph, 0, sizeof(graph));
+  growVertices(&graph, table.size);
+
+  #pragma omp parallel for schedule(dynamic, 256) num_threads(threads)
+  for (uint row = 0; row < table.size; row++) {
+    uint start = table.rowIndex[row];
+    uint degree = table.rowIndex[row + 1] - start;
+    graph.neighbors[row] = (uint *) malloc(((degree > 0) ? degree : 1) * sizeof(uint));
+    graph.capacity[row] = (degree > 0) ? degree : 1;
+
+    uint kept = 0;
+    for (uint i = 0; i < degree; i++) {
+      uint column = table.colIndex[start + i];
+      if (column != row && (kept == 0 || column != graph.neighbors[row][kept - 1])) {
+        graph.neighbors[row][kept++] = column;
+      }
+    }
+    graph.degree[row] = kept;
+  }
+
+  unsigned long long sum = 0;
+  for (uint row = 0; row < graph.size; row++) {
+    graph.edges += graph.degree[row];
+  }
+  graph.edges /= 2;
+
+  free(graph.triangles);
+  graph.triangles = dynamicRecount(&graph, threads);
+  for (uint row = 0; row < graph.size; row++) {
+    sum += graph.triangles[row];
+  }
+  graph.total = sum / 3;
+
+  // dynamicRecount() only allocated size counts. Keep room for the vertices to come.
+  graph.triangles = (uint *) realloc(graph.triangles, graph.allocated * sizeof(uint));
+  return graph;
+}
+
+
+int dynamicHasEdge(dynamic_graph *graph, uint u, uint v) {
+  if (u >= graph->size || v >= graph->size || u == v) {
+    return 0;
+  }
+
+  // Search the shorter block.
+  if (graph->degree[v] < graph->degree[u]) {
+    uint w = u; u = v; v = w;
+  }
+  uint *block = graph->neighbors[u];
+  long low = 0, high = (long) graph->degree[u] - 1;
+  while (low <= high) {
+    long middle = (low + high) / 2;
+    if (block[middle] == v) {
+      return 1;
+    }
+    if (block[middle] < v) {
+      low = middle + 1;
+    } else {
+      high = middle - 1;
+    }
+  }
+  return 0;
+}
+
+
+// Adds sign to the counts of every triangle of the changed edges, that the edge counts.
+// Returns the change of the total.
+static long long countChanged(dynamic_graph *graph, edge_key *keys, uint count, int sign, int threads) {
+  long long change = 0;
+
+  #pragma omp parallel for schedule(dynamic, 16) num_threads(threads) reduction(+:change)
+  for (uint e = 0; e < count; e++) {
+    uint u = (uint) (keys[e] >> 32);
+    uint v = (uint) keys[e];
+    uint *a = graph->neighbors[u];
+    uint *b = graph->neighbors[v];
+    uint sizeA = graph->degree[u];
+    uint sizeB = graph->degree[v];
+
+    uint i = 0, j = 0;
+    while (i < sizeA && j < sizeB) {
+      if (a[i] == b[j]) {
+        uint w = a[i];
+        if (countedHere(keys, count, e, u, v, w)) {
+          __atomic_add_fetch(&graph->triangles[u], (uint) sign, __ATOMIC_RELAXED);
+          __atomic_add_fetch(&graph->triangles[v], (uint) sign, __ATOMIC_RELAXED);
+          __atomic_add_fetch(&graph->triangles[w], (uint) sign, __ATOMIC_RELAXED);
+          change += sign;
+        }
+        i++;
+        j++;
+      } else if (a[i] < b[j]) {
+        i++;
+      } else {
+        j++;
+      }
+    }
+  }
+
+  return change;
+}
+
+
+// Rebuilds the block of every vertex the batch touches, once, merging in its changes.
+// The changes are sorted by source, then target.
+static void applyChanges(dynamic_graph *graph, block_change *changes, uint count, int threads) {
+  // The first change of every source.
+  uint *firsts = (uint *) malloc((count + 1) * sizeof(uint));
+  uint sources = 0;
+  for (uint c = 0; c < count; c++) {
+    if (c == 0 || changes[c].source != changes[c - 1].source) {
+      firsts[sources++] = c;
+    }
+  }
+  firsts[sources] = count;
+
+  #pragma omp parallel for schedule(dynamic, 16) num_threads(threads)
+  for (uint s = 0; s < sources; s++) {
+    uint vertex = changes[firsts[s]].source;
+    uint *old = graph->neighbors[vertex];
+    uint degree = graph->degree[vertex];
+
+    uint inserts = 0;
+    for (uint c = firsts[s]; c < firsts[s + 1]; c++) {
+      inserts += changes[c].insert;
+    }
+    uint capacity = graph->capacity[vertex];
+    while (capacity < degree + inserts) {
+      capacity = (capacity > 0) ? 2 * capacity : 4;
+    }
+
+    // Merge the old block with the changes into a new one.
+    uint *block = (uint *) malloc(capacity * sizeof(uint));
+    uint kept = 0, i = 0;
+    for (uint c = firsts[s]; c < firsts[s + 1]; c++) {
+      uint target = changes[c].target;
+      while (i < degree && old[i] < target) {
+        block[kept++] = old[i++];
+      }
+      if (changes[c].insert) {
+        block[kept++] = target;
+      } else if (i < degree && old[i] == target) {
+        i++;
+      }
+    }
+    while (i < degree) {
+      block[kept++] = old[i++];
+    }
+
+    free(old);
+    graph->neighbors[vertex] = block;
+    graph->degree[vertex] = kept;
+    graph->capacity[vertex] = capacity;
+  }
+
+  free(firsts);
+}
+
+
+// Applies a batch of updates and updates the counts of the triangles they change.
+batch_result dynamicUpdate(dynamic_graph *graph, edge_update *updates, uint count, int threads) {
+  batch_result result = {0, 0, 0, 0};
+
+  // The last update of every edge, without the self loops.
+  keyed_update *keyed = (keyed_update *) malloc(((count > 0) ? count : 1) * sizeof(keyed_update));
+  uint valid = 0;
+  uint largest = 0;
+  for (uint i = 0; i < count; i++) {
+    if (updates[i].u == updates[i].v) {
+      continue;
+    }
+    keyed[valid].key = edgeKey(updates[i].u, updates[i].v);
+    keyed[valid].order = i;
+    keyed[valid].insert = updates[i].insert;
+    valid++;
+    largest = (updates[i].u > largest) ? updates[i].u : largest;
+    largest = (updates[i].v > largest) ? updates[i].v : largest;
+  }
+  qsort(keyed, valid, sizeof(keyed_update), compareUpdates);
+  if (valid > 0) {
+    growVertices(graph, largest + 1);
+  }
+
+  // Only the ones that change the graph. Both lists stay sorted by key.
+  edge_key *deleted = (edge_key *) malloc(((valid > 0) ? valid : 1) * sizeof(edge_key));
+  edge_key *inserted = (edge_key *) malloc(((valid > 0) ? valid : 1) * sizeof(edge_key));
+  for (uint i = 0; i < valid; i++) {
+    if (i + 1 < valid && keyed[i + 1].key == keyed[i].key) {
+      continue;
+    }
+    int present = dynamicHasEdge(graph, (uint) (keyed[i].key >> 32), (uint) keyed[i].key);
+    if (keyed[i].insert && !present) {
+      inserted[result.inserted++] = keyed[i].key;
+    } else if (!keyed[i].insert && present) {
+      deleted[result.deleted++] = keyed[i].key;
+    }
+  }
+  result.ignored = count - result.inserted - result.deleted;
+  free(keyed);
+
+  // 1. The triangles of the deleted edges, in the old graph.
+  double start = traceStart();
+  result.change += countChanged(graph, deleted, result.deleted, -1, threads);
+  traceRecord("lost", TRACE_MAIN, start);
+
+  // 2. Both ends of every changed edge, sorted by block.
+  start = traceStart();
+  uint changes_num = 2 * (result.deleted + result.inserted);
+  block_change *changes = (block_change *) malloc(((changes_num > 0) ? changes_num : 1) * sizeof(block_change));
+  uint c = 0;
+  for (uint i = 0; i < result.deleted; i++) {
+    uint u = (uint) (deleted[i] >> 32), v = (uint) deleted[i];
+    block_change forward = {u, v, 0}, backward = {v, u, 0};
+    changes[c++] = forward;
+    changes[c++] = backward;
+  }
+  for (uint i = 0; i < result.inserted; i++) {
+    uint u = (uint) (inserted[i] >> 32), v = (uint) inserted[i];
+    block_change forward = {u, v, 1}, backward = {v, u, 1};
+    changes[c++] = forward;
+    changes[c++] = backward;
+  }
+  qsort(changes, changes_num, sizeof(block_change), compareChanges);
+  applyChanges(graph, changes, changes_num, threads);
+  graph->edges += result.inserted;
+  graph->edges -= result.deleted;
+  free(changes);
+  traceRecord("apply", TRACE_MAIN, start);
+
+  // 3. The triangles of the inserted edges, in the new graph.
+  start = traceStart();
+  result.change += countChanged(graph, inserted, result.inserted, 1, threads);
+  traceRecord("new", TRACE_MAIN, start);
+
+  graph->total += result.change;
+  free(deleted);
+  free(inserted);
+  return result;
+}
+
+
+// The graph as a table the backends can count, for checking the counts.
+csr dynamicToCSR(dynamic_graph *graph) {
+  uint *rowIndex = (uint *) malloc((graph->size + 1) * sizeof(uint));
+  rowIndex[0] = 0;
+  for (uint row = 0; row < graph->size; row++) {
+    rowIndex[row + 1] = rowIndex[row] + graph->degree[row];
+  }
+
+  uint nonzeros = rowIndex[graph->size];
+  uint *colIndex = (uint *) malloc(((nonzeros > 0) ? nonzeros : 1) * sizeof(uint));
+  int *values = (int *) malloc(((nonzeros > 0) ? nonzeros : 1) * sizeof(int));
+  for (uint row = 0; row < graph->size; row++) {
+    memcpy(&colIndex[rowIndex[row]], graph->neighbors[row], graph->degree[row] * sizeof(uint));
+  }
+  for (uint i = 0; i < nonzeros; i++) {
+    values[i] = 1;
+  }
+
+  csr table = {graph->size, values, colIndex, rowIndex};
+  return table;
+}
+
+
+void freeDynamicGraph(dynamic_graph *graph) {
+  for (uint i = 0; i < graph->size; i++) {
+    free(graph->neighbors[i]);
+  }
+  free(graph->neighbors);
+  free(graph->degree);
+  free(graph->capacity);
+  free(graph->triangles);
+  memset(graph, 0, sizeof(dynamic_graph));
+}
@@ -0,0 +1,207 @@
+/*
+ * edge_split.c
+ * Edge-parallel execution mode for power-law graphs. See headers/edge_split.h.
+ *
+ * The work of dot(row, column) is about deg(row) + deg(column) comparisons, so a
+ * row's total work grows with the degrees of its neighbors. We walk the nonzeros
+ * in order and cut a new task every time the accumulated work reaches the
+ * threshold. Light rows get grouped together, heavy rows get split into several
+ * tasks that each cover a disjoint range of neighbors.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "../headers/mmio.h"
+#include "../headers/csr.h"
+#include "../headers/helpers.h"
+#include "../headers/numa_helpers.h"
+#include "../headers/edge_split.h"
+#include "../headers/trace.h"
+#include "../headers/progress.h"
+
+
+// The work of the dot product for the nonzero at index, inside row.
+static unsigned long edgeWork(csr table, uint row, uint index) {
+  uint column = table.colIndex[index];
+  return (table.rowIndex[row+1] - table.rowIndex[row]) +
+    (table.rowIndex[column+1] - table.rowIndex[column]);
+}
+
+
+// Cuts the table into tasks. The threshold adapts to the degree distribution:
+// it's the total work divided by the number of tasks we want. Light rows get grouped
+// in the same task, and only the rows whose work is above the average task (the hubs)
+// get spread between several tasks, as many as they need.
+edge_tasks makeEdgeTasks(csr table, int threads) {
+  uint size = table.size;
+  uint nonzeros = table.rowIndex[size];
+
+  unsigned long totalWork = 0;
+  for (uint row = 0; row < size; row++) {
+    for (uint index = table.rowIndex[row]; index < table.rowIndex[row+1]; index++) {
+      totalWork += edgeWork(table, row, index);
+    }
+  }
+
+  edge_tasks result;
+  result.threshold = totalWork / (threads * TASKS_PER_THREAD) + 1;
+  result.splitRows = 0;
+  result.count = 0;
+
+  // There can't be more tasks than nonzeros. Shrink when we're done.
+  uint capacity = threads * TASKS_PER_THREAD * 2 + 1;
+  result.tasks = (edge_task *) malloc(capacity * sizeof(edge_task));
+
+  unsigned long work = 0;
+  uint first = 0;
+  uint firstRow = 0;
+  int rowWasCut = 0;
+
+  for (uint row = 0; row < size; row++) {
+    for (uint index = table.rowIndex[row]; index < table.rowIndex[row+1]; index++) {
+      work += edgeWork(table, row, index);
+
+      if (work >= result.threshold) {
+        if (result.count == capacity) {
+          capacity *= 2;
+          result.tasks = (edge_task *) realloc(result.tasks, capacity * sizeof(edge_task));
+        }
+
+        edge_task task = {first, index + 1, firstRow};
+        result.tasks[result.count++] = task;
+
+        // The task ended inside the row, so the rest of it goes to the next one.
+        if (index + 1 < table.rowIndex[row+1] && !rowWasCut) {
+          result.splitRows++;
+          rowWasCut = 1;
+        }
+
+        work = 0;
+        first = index + 1;
+        firstRow = (index + 1 < table.rowIndex[row+1]) ? row : row + 1;
+      }
+    }
+    rowWasCut = 0;
+  }
+
+  // Whatever is left becomes the last task.
+  if (first < nonzeros) {
+    if (result.count == capacity) {
+      capacity++;
+      result.tasks = (edge_task *) realloc(result.tasks, capacity * sizeof(edge_task));
+    }
+    edge_task task = {first, nonzeros, firstRow};
+    result.tasks[result.count++] = task;
+  }
+
+  // Skip the empty rows the first row of a task might be pointing at.
+  for (uint i = 0; i < result.count; i++) {
+    while (table.rowIndex[result.tasks[i].row + 1] <= result.tasks[i].first) {
+      result.tasks[i].row++;
+    }
+  }
+
+  PROGRESS("edge tasks: %u\tthreshold: %lu\tsplit rows: %u\n",
+    result.count, result.threshold, result.splitRows);
+
+  return result;
+}
+
+
+// Adds dot(row, column) for every nonzero of the task to sums[row]. Only the first
+// and the last row of a task can be shared with another task, so we keep a private
+// sum for the current row and publish it with one atomic add when the row changes.
+void runEdgeTask(csr table, edge_task task, uint *sums) {
+  uint row = task.row;
+  uint partial = 0;
+
+  for (uint index = task.first; index < task.last; index++) {
+    while (index >= table.rowIndex[row+1]) {
+      if (partial > 0) {
+        __atomic_fetch_add(&sums[row], partial, __ATOMIC_RELAXED);
+      }
+      partial = 0;
+      row++;
+    }
+
+    partial += dot(table, row, table.colIndex[index]);
+  }
+
+  if (partial > 0) {
+    __atomic_fetch_add(&sums[row], partial, __ATOMIC_RELAXED);
+  }
+}
+
+
+// Turns the row sums of A (Hadamard) A^2 into triangle counts, in place.
+uint *halveSums(uint *sums, uint size) {
+  for (uint i = 0; i < size; i++) {
+    sums[i] /= 2;
+  }
+  return sums;
+}
+
+
+// Given to every pthread of the edge-parallel mode.
+// @param next: The shared index of the next task to be picked up.
+typedef struct {
+  csr table;
+  edge_tasks *tasks;
+  uint *next;
+  uint *sums;
+  int cpu;
+  int id;
+} edge_arg;
+
+
+void *runEdgeTasksVoid(void *edge) {
+  edge_arg *arg = (edge_arg *) edge;
+  pinThread(arg->cpu);
+  double start = traceStart();
+
+  // Take the next task until none are left.
+  uint task = __atomic_fetch_add(arg->next, 1, __ATOMIC_RELAXED);
+  while (task < arg->tasks->count) {
+    runEdgeTask(arg->table, arg->tasks->tasks[task], arg->sums);
+    task = __atomic_fetch_add(arg->next, 1, __ATOMIC_RELAXED);
+  }
+
+  traceRecord("edges", arg->id, start);
+  return NULL;
+}
+
+
+// The pthreads implementation of the edge-parallel mode. plan is NULL unless
+// we're in NUMA mode, in which case every thread is pinned and reads its node's replica.
+uint *countTrianglesEdges(csr table, int threads, numa_plan *plan) {
+  double start = traceStart();
+  edge_tasks tasks = makeEdgeTasks(table, threads);
+  traceRecord("tasks", TRACE_MAIN, start);
+  uint *sums = (uint *) calloc(table.size, sizeof(uint));
+  uint next = 0;
+
+  pthread_t workers[threads];
+  edge_arg arg[threads];
+
+  for (int i = 0; i < threads; i++) {
+    arg[i].table = (plan != NULL) ? numaTable(plan, i) : table;
+    arg[i].tasks = &tasks;
+    arg[i].next = &next;
+    arg[i].sums = sums;
+    arg[i].cpu = (plan != NULL) ? plan->cpus[i] : -1;
+    arg[i].id = i;
+    pthread_create(&workers[i], NULL, runEdgeTasksVoid, (void *) &arg[i]);
+  }
+
+  for (int i = 0; i < threads; i++) {
+    pthread_join(workers[i], NULL);
+  }
+
+  free(tasks.tasks);
+  start = traceStart();
+  uint *triangles = halveSums(sums, table.size);
+  traceRecord("halve", TRACE_MAIN, start);
+  return triangles;
+}
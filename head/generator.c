@@ -0,0 +1,486 @@
+/*
+ * generator.c
+ * Parallel synthetic graph generator and binary snapshots. See headers/generator.h.
+ *
+ * The graph is built in four parallel passes over the threads' ranges:
+ * 1. Draw the edges. Edge i only depends on (seed, i), through a counter based
+ *    generator (splitmix64), so any number of threads draws the same list.
+ * 2. Count the degree of every vertex, in both directions.
+ * 3. Scatter the edges into their rows and sort every row.
+ * 4. Drop the duplicates and compact the rows into the final CSR table.
+ * No dense matrix is ever allocated, so the memory is O(edges).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../headers/csr.h"
+#include "../headers/mmio.h"
+#include "../headers/helpers.h"
+#include "../headers/generator.h"
+#include "../headers/progress.h"
+
+// One undirected edge, as drawn. Self loops are marked with row == column.
+typedef struct {
+  uint row;
+  uint column;
+} edge;
+
+// Given to every thread of the generator.
+// @param phase: The pass to run on [start, end) of the edges, or of the rows.
+typedef struct {
+  graph_spec spec;
+  uint size;
+  unsigned long long edges_num;
+  edge *edges;
+  uint *degree;
+  uint *cursor;
+  uint *rowIndex;
+  uint *colIndex;
+  uint *unique;
+  unsigned long long start;
+  unsigned long long end;
+  uint rowStart;
+  uint rowEnd;
+  int phase;
+} generator_arg;
+
+
+// The i-th number of the stream of seed. Counter based, so the streams can be split freely.
+unsigned long long splitmix64(unsigned long long seed, unsigned long long i) {
+  unsigned long long z = seed * 0x9E3779B97F4A7C15ULL + (i + 1) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+
+// A uniform number in [0, 1).
+static double uniform(unsigned long long seed, unsigned long long i) {
+  return (splitmix64(seed, i) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
+// Picks one quadrant of the adjacency matrix per level of the recursion.
+static edge rmatEdge(graph_spec spec, unsigned long long i) {
+  edge e = {0, 0};
+  for (uint level = 0; level < spec.scale; level++) {
+    double p = uniform(spec.seed, i * spec.scale + level);
+    uint bit = 1u << level;
+
+    if (p >= RMAT_A + RMAT_B + RMAT_C) {
+      e.row |= bit;
+      e.column |= bit;
+    } else if (p >= RMAT_A + RMAT_B) {
+      e.row |= bit;
+    } else if (p >= RMAT_A) {
+      e.column |= bit;
+    }
+  }
+  return e;
+}
+
+
+static edge uniformEdge(graph_spec spec, uint size, unsigned long long i) {
+  edge e;
+  e.row = splitmix64(spec.seed, 2 * i) % size;
+  e.column = splitmix64(spec.seed, 2 * i + 1) % size;
+  return e;
+}
+
+
+// The sides of the meshes, so that they have about 2^scale vertices: 2^(scale / dimensions)
+// rounded to the nearest side, not down, or grid3d:20 would only have 2^18.
+static uint gridSide(graph_spec spec) {
+  uint dimensions = (spec.kind == GRAPH_GRID2D) ? 2 : 3;
+  uint side = (uint) round(pow(2, spec.scale / (double) dimensions));
+  return (side < 2) ? 2 : side;
+}
+
+
+// The neighbors of vertex v towards the larger indices: the +x, +y (and +z) steps
+// and the diagonals between them, so that every cell is cut into triangles.
+// Returns how many there are.
+static int gridNeighbors(graph_spec spec, uint side, uint v, uint *neighbors) {
+  int count = 0;
+
+  if (spec.kind == GRAPH_GRID2D) {
+    uint x = v % side, y = v / side;
+    if (x + 1 < side) neighbors[count++] = v + 1;
+    if (y + 1 < side) neighbors[count++] = v + side;
+    if (x + 1 < side && y + 1 < side) neighbors[count++] = v + side + 1;
+    return count;
+  }
+
+  uint plane = side * side;
+  uint x = v % side, y = (v / side) % side, z = v / plane;
+  if (x + 1 < side) neighbors[count++] = v + 1;
+  if (y + 1 < side) neighbors[count++] = v + side;
+  if (z + 1 < side) neighbors[count++] = v + plane;
+  if (x + 1 < side && y + 1 < side) neighbors[count++] = v + side + 1;
+  if (x + 1 < side && z + 1 < side) neighbors[count++] = v + plane + 1;
+  if (y + 1 < side && z + 1 < side) neighbors[count++] = v + plane + side;
+  return count;
+}
+
+
+static int compareColumns(const void *a, const void *b) {
+  uint x = *(const uint *) a;
+  uint y = *(const uint *) b;
+  return (x > y) - (x < y);
+}
+
+
+void *generatorPassVoid(void *generator) {
+  generator_arg *arg = (generator_arg *) generator;
+
+  if (arg->phase == 0) {
+    // Meshes are drawn per vertex and don't need the edge list.
+    for (unsigned long long i = arg->start; i < arg->end; i++) {
+      edge e = (arg->spec.kind == GRAPH_RMAT) ? rmatEdge(arg->spec, i) : uniformEdge(arg->spec, arg->size, i);
+      arg->edges[i] = e;
+    }
+  }
+  else if (arg->phase == 1) {
+    for (unsigned long long i = arg->start; i < arg->end; i++) {
+      edge e = arg->edges[i];
+      if (e.row != e.column) {
+        __atomic_fetch_add(&arg->degree[e.row], 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&arg->degree[e.column], 1, __ATOMIC_RELAXED);
+      }
+    }
+  }
+  else if (arg->phase == 2) {
+    for (unsigned long long i = arg->start; i < arg->end; i++) {
+      edge e = arg->edges[i];
+      if (e.row != e.column) {
+        uint slot = __atomic_fetch_add(&arg->cursor[e.row], 1, __ATOMIC_RELAXED);
+        arg->colIndex[slot] = e.column;
+        slot = __atomic_fetch_add(&arg->cursor[e.column], 1, __ATOMIC_RELAXED);
+        arg->colIndex[slot] = e.row;
+      }
+    }
+  }
+  else {
+    // Sort every row of the range and move its distinct columns to its front.
+    for (uint row = arg->rowStart; row < arg->rowEnd; row++) {
+      uint *columns = &arg->colIndex[arg->rowIndex[row]];
+      uint length = arg->rowIndex[row + 1] - arg->rowIndex[row];
+      qsort(columns, length, sizeof(uint), compareColumns);
+
+      uint distinct = 0;
+      for (uint j = 0; j < length; j++) {
+        if (distinct == 0 || columns[j] != columns[distinct - 1]) {
+          columns[distinct++] = columns[j];
+        }
+      }
+      arg->unique[row] = distinct;
+    }
+  }
+
+  return NULL;
+}
+
+
+// Runs one pass on every thread. The edges are split evenly, the rows by their number of entries.
+static void runPass(generator_arg *arg, int threads, int phase) {
+  pthread_t workers[threads];
+  generator_arg args[threads];
+  unsigned long long total = (arg->rowIndex != NULL) ? arg->rowIndex[arg->size] : 0;
+  uint row = 0;
+
+  for (int i = 0; i < threads; i++) {
+    args[i] = *arg;
+    args[i].phase = phase;
+    args[i].start = arg->edges_num * i / threads;
+    args[i].end = arg->edges_num * (i + 1) / threads;
+
+    args[i].rowStart = row;
+    if (phase == 3) {
+      unsigned long long target = total * (i + 1) / threads;
+      while (row < arg->size && (i == threads - 1 || arg->rowIndex[row] < target)) {
+        row++;
+      }
+    }
+    args[i].rowEnd = row;
+
+    pthread_create(&workers[i], NULL, generatorPassVoid, (void *) &args[i]);
+  }
+
+  for (int i = 0; i < threads; i++) {
+    pthread_join(workers[i], NULL);
+  }
+}
+
+
+// The edges of the meshes, straight from the coordinates. Serial: it is a single cheap pass.
+// NULL if the mesh doesn't fit in the CSR indices.
+static edge *gridEdges(graph_spec spec, uint *size, unsigned long long *edges_num) {
+  unsigned long long side = gridSide(spec);
+  // The steps along every axis and a diagonal of every face, from gridNeighbors().
+  unsigned long long vertices, edges_max;
+  if (spec.kind == GRAPH_GRID2D) {
+    vertices = side * side;
+    edges_max = 2 * side * (side - 1) + (side - 1) * (side - 1);
+  } else {
+    vertices = side * side * side;
+    edges_max = 3 * side * side * (side - 1) + 3 * side * (side - 1) * (side - 1);
+  }
+  if (vertices >= 0xFFFFFFFFULL || edges_max * 2 > 0xFFFFFFFFULL) {
+    printf("%llu vertices and 2 * %llu edges don't fit in the CSR indices.\n", vertices, edges_max);
+    return NULL;
+  }
+  *size = (uint) vertices;
+
+  uint neighbors[6];
+  edge *edges = (edge *) malloc(edges_max * sizeof(edge));
+  unsigned long long count = 0;
+  for (uint v = 0; v < *size; v++) {
+    int n = gridNeighbors(spec, side, v, neighbors);
+    for (int j = 0; j < n; j++) {
+      edges[count].row = v;
+      edges[count].column = neighbors[j];
+      count++;
+    }
+  }
+
+  *edges_num = count;
+  return edges;
+}
+
+
+// "rmat:20", "er:18:8:42", "grid2d:20", ...
+int isGraphSpec(char *name) {
+  return strncmp(name, "rmat:", 5) == 0 || strncmp(name, "er:", 3) == 0 ||
+    strncmp(name, "grid2d:", 7) == 0 || strncmp(name, "grid3d:", 7) == 0;
+}
+
+
+// Returns 0 if the spec can't be read.
+int parseGraphSpec(char *name, graph_spec *spec) {
+  char kind[16];
+  unsigned int scale, edgeFactor = 16;
+  unsigned long long seed = 1;
+
+  int fields = sscanf(name, "%15[^:]:%u:%u:%llu", kind, &scale, &edgeFactor, &seed);
+  if (fields < 2 || scale < 1 || scale > 31 || edgeFactor < 1) {
+    printf("Couldn't read the graph spec %s. Use kind:scale[:edgefactor[:seed]].\n", name);
+    return 0;
+  }
+
+  if (strcmp(kind, "rmat") == 0) spec->kind = GRAPH_RMAT;
+  else if (strcmp(kind, "er") == 0) spec->kind = GRAPH_ER;
+  else if (strcmp(kind, "grid2d") == 0) spec->kind = GRAPH_GRID2D;
+  else if (strcmp(kind, "grid3d") == 0) spec->kind = GRAPH_GRID3D;
+  else {
+    printf("Unknown graph kind %s. Use rmat, er, grid2d or grid3d.\n", kind);
+    return 0;
+  }
+
+  spec->scale = scale;
+  spec->edgeFactor = edgeFactor;
+  spec->seed = seed;
+  return 1;
+}
+
+
+// The spec back as a string, with every field filled in.
+void formatGraphSpec(graph_spec spec, char *name, size_t length) {
+  const char *kinds[4] = {"rmat", "er", "grid2d", "grid3d"};
+  snprintf(name, length, "%s:%u:%u:%llu", kinds[spec.kind], spec.scale, spec.edgeFactor, spec.seed);
+}
+
+
+// Builds the symmetric CSR table of the graph, with sorted rows and every value 1,
+// like readmtx_dynamic() returns. The table is empty if it would overflow the uint indices.
+csr generateGraph(graph_spec spec, int threads) {
+  csr empty = {0, NULL, NULL, NULL};
+  generator_arg arg;
+  memset(&arg, 0, sizeof(arg));
+  arg.spec = spec;
+
+  if (spec.kind == GRAPH_GRID2D || spec.kind == GRAPH_GRID3D) {
+    arg.edges = gridEdges(spec, &arg.size, &arg.edges_num);
+    if (arg.edges == NULL) {
+      return empty;
+    }
+  } else {
+    arg.size = 1u << spec.scale;
+    arg.edges_num = (unsigned long long) spec.edgeFactor << spec.scale;
+    if (arg.edges_num * 2 > 0xFFFFFFFFULL) {
+      printf("2 * %llu edges don't fit in the CSR indices.\n", arg.edges_num);
+      return empty;
+    }
+    arg.edges = (edge *) malloc(arg.edges_num * sizeof(edge));
+    runPass(&arg, threads, 0);
+  }
+
+  arg.degree = (uint *) calloc(arg.size, sizeof(uint));
+  runPass(&arg, threads, 1);
+
+  // Every row starts where the previous one ends. The cursors fill the rows.
+  arg.rowIndex = (uint *) malloc((arg.size + 1) * sizeof(uint));
+  arg.cursor = (uint *) malloc(arg.size * sizeof(uint));
+  arg.rowIndex[0] = 0;
+  for (uint row = 0; row < arg.size; row++) {
+    arg.rowIndex[row + 1] = arg.rowIndex[row] + arg.degree[row];
+    arg.cursor[row] = arg.rowIndex[row];
+  }
+
+  arg.colIndex = (uint *) malloc(arg.rowIndex[arg.size] * sizeof(uint));
+  runPass(&arg, threads, 2);
+  free(arg.edges);
+  free(arg.cursor);
+  arg.edges_num = 0;
+
+  arg.unique = arg.degree;
+  runPass(&arg, threads, 3);
+
+  // Squeeze out the duplicates.
+  uint *rowIndex = (uint *) malloc((arg.size + 1) * sizeof(uint));
+  rowIndex[0] = 0;
+  for (uint row = 0; row < arg.size; row++) {
+    rowIndex[row + 1] = rowIndex[row] + arg.unique[row];
+  }
+
+  uint nonzeros = rowIndex[arg.size];
+  uint *colIndex = (uint *) malloc(nonzeros * sizeof(uint));
+  int *values = (int *) malloc(nonzeros * sizeof(int));
+  for (uint row = 0; row < arg.size; row++) {
+    memcpy(&colIndex[rowIndex[row]], &arg.colIndex[arg.rowIndex[row]], arg.unique[row] * sizeof(uint));
+  }
+  for (uint i = 0; i < nonzeros; i++) {
+    values[i] = 1;
+  }
+
+  free(arg.colIndex);
+  free(arg.rowIndex);
+  free(arg.degree);
+
+  PROGRESS("\ngenerated: %u vertices\t%u nonzeros\n", arg.size, nonzeros);
+  csr table = {arg.size, values, colIndex, rowIndex};
+  return table;
+}
+
+
+// Snapshots end in .csr.
+int isSnapshot(char *path) {
+  char *extension = strrchr(path, '.');
+  return extension != NULL && strcmp(extension, ".csr") == 0;
+}
+
+
+// The header (magic, version, size, nonzeros), then rowIndex and colIndex as they are in memory.
+// The values are all 1, so they aren't stored. Returns 0 if the file can't be written.
+int writeSnapshot(char *path, csr table) {
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    printf("Couldn't write %s\n", path);
+    return 0;
+  }
+
+  uint header[4] = {SNAPSHOT_MAGIC, SNAPSHOT_VERSION, table.size, table.rowIndex[table.size]};
+  int written = fwrite(header, sizeof(uint), 4, file) == 4 &&
+    fwrite(table.rowIndex, sizeof(uint), table.size + 1, file) == table.size + 1 &&
+    fwrite(table.colIndex, sizeof(uint), header[3], file) == header[3];
+
+  fclose(file);
+  return written;
+}
+
+
+csr readSnapshot(char *path) {
+  csr table = {0, NULL, NULL, NULL};
+  FILE *file = fopen(path, "rb");
+  uint header[4];
+
+  if (file == NULL || fread(header, sizeof(uint), 4, file) != 4 ||
+    header[0] != SNAPSHOT_MAGIC || header[1] != SNAPSHOT_VERSION)
+  {
+    printf("Error. %s isn't a snapshot!", path);
+    if (file != NULL) {
+      fclose(file);
+    }
+    return table;
+  }
+
+  uint size = header[2];
+  uint nonzeros = header[3];
+  uint *rowIndex = (uint *) malloc((size + 1) * sizeof(uint));
+  uint *colIndex = (uint *) malloc(nonzeros * sizeof(uint));
+  int *values = (int *) malloc(nonzeros * sizeof(int));
+
+  if (fread(rowIndex, sizeof(uint), size + 1, file) != size + 1 ||
+    fread(colIndex, sizeof(uint), nonzeros, file) != nonzeros)
+  {
+    printf("Error. %s is truncated!", path);
+    free(rowIndex);
+    free(colIndex);
+    free(values);
+    fclose(file);
+    return table;
+  }
+  fclose(file);
+
+  for (uint i = 0; i < nonzeros; i++) {
+    values[i] = 1;
+  }
+
+  PROGRESS("\nsnapshot: %u vertices\t%u nonzeros\n", size, nonzeros);
+  table.size = size;
+  table.values = values;
+  table.colIndex = colIndex;
+  table.rowIndex = rowIndex;
+  return table;
+}
+
+
+// A symmetric pattern file with the lower triangle, ordered by column, so that the
+// pipelined mode can count it while it's being read.
+int writeMatrixMarket(char *path, csr table) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    printf("Couldn't write %s\n", path);
+    return 0;
+  }
+
+  fprintf(file, "%%%%MatrixMarket matrix coordinate pattern symmetric\n");
+  fprintf(file, "%u %u %u\n", table.size, table.size, table.rowIndex[table.size] / 2);
+  for (uint row = 0; row < table.size; row++) {
+    for (uint j = table.rowIndex[row]; j < table.rowIndex[row + 1]; j++) {
+      if (table.colIndex[j] > row) {
+        fprintf(file, "%u %u\n", table.colIndex[j] + 1, row + 1);
+      }
+    }
+  }
+
+  fclose(file);
+  return 1;
+}
+
+
+// Any graph the tools take: a .mtx file, a snapshot, or the spec of a generated graph.
+// An empty table if it can't be read.
+csr loadGraph(char *graph) {
+  csr empty = {0, NULL, NULL, NULL};
+  graph_spec spec;
+
+  if (isGraphSpec(graph)) {
+    return parseGraphSpec(graph, &spec) ? generateGraph(spec, sysconf(_SC_NPROCESSORS_ONLN)) : empty;
+  }
+  if (isSnapshot(graph)) {
+    return readSnapshot(graph);
+  }
+  if (access(graph, R_OK) != 0) {
+    printf("Couldn't read %s\n", graph);
+    return empty;
+  }
+
+  int M = 0, N = 0, nz = 0;
+  MM_typecode *t = NULL;
+  return readmtx_dynamic(graph, t, N, M, nz);
+}
@@ -10,6 +10,7 @@
 #include "../headers/csr.h"
 #include "../headers/csr_arg.h"
 #include "../headers/helpers.h"
+#include "../headers/progress.h"
 
 
 // Reads an mtx file and returns the CSR format by making a 2D array of non-symmetric 
@@ -21,7 +22,7 @@ csr readmtx_dynamic(char *mtx, MM_typecode *t, int N, int M, int nz) {
 	int banner = mm_read_banner(matrixFile, &t);
 	int result = mm_read_mtx_crd_size(matrixFile, &M, &N, &nz);
 
-	printf("\nbanner: %d\tresult: %d\tnonzeros: %d\tM: %d\tN: %d\n",
+	PROGRESS("\nbanner: %d\tresult: %d\tnonzeros: %d\tM: %d\tN: %d\n",
 		banner, result, nz, M, N);
  
 	// Display error messages and abort, if the matrix isn't square or hasn't been read properly.
@@ -76,7 +77,7 @@ csr readmtx_dynamic(char *mtx, MM_typecode *t, int N, int M, int nz) {
   }
 
   // Put the scanned values in a CSR structure.
-  uint *rowIndex = (uint *) calloc(N, sizeof(uint));
+  uint *rowIndex = (uint *) calloc(N + 1, sizeof(uint));
   uint *colIndex = (uint *) calloc(nonzeros, sizeof(uint));
 
   for (uint row = 0; row < N; row++) {
@@ -95,13 +96,20 @@ csr readmtx_dynamic(char *mtx, MM_typecode *t, int N, int M, int nz) {
     }
   }
 
+  for (int i = 0; i < N; i++) {
+    free(valuesByRow[i]);
+  }
+  free(valuesByRow);
+  fclose(matrixFile);
+
   csr csr_mtx = {N, values, colIndex, rowIndex};
   return csr_mtx;
 }
 
 
 // Creates a csr_arg array, depending on the number of threads and the CSR table.
-csr_arg *makeThreadArguments(csr table, int max_threads) {
+// Quiet, for the callers that aren't backends.
+csr_arg *splitRows(csr table, int max_threads) {
   // Make a table of csr_arg structs. Each of them corresponds to a thread.
   uint size = table.size;
   uint nonzeros = table.rowIndex[size];
@@ -110,9 +118,6 @@ csr_arg *makeThreadArguments(csr table, int max_threads) {
   uint interval = nonzeros / max_threads;
   csr_arg *csr_args = (csr_arg *) malloc(max_threads * sizeof(csr_arg));
 
-  // Placeholder for the total size of the csr_args array.
-  uint totalSize = 0;
-  
   for (int i = 0; i < max_threads; i++) {
     // The starting and ending rows of each csr_arg. The first "max_threads-1" structures share equal
     // number of nonzero values and the last one gets the remaining rows.
@@ -130,32 +135,52 @@ csr_arg *makeThreadArguments(csr table, int max_threads) {
 
     uint partialSize = end - start;
 
-    printf("start = %u\tend = %u\tsize = %u\n", start, end, partialSize);
-    uint nonzeros = table.rowIndex[end] - table.rowIndex[start];
-    printf("nonzeros = %u\n", nonzeros);
-
-    // Initialize every attribute of each csr_args element, then add its size to 
-    // the totalSize placeholder. Will be used to realloc() exactly that much memory.
+    // Initialize every attribute of each csr_args element. The sub-table itself is
+    // left empty: hadamardSingleStep() makes it, so there's nothing to allocate yet.
     csr_args[i].table.size = partialSize;
-    csr_args[i].table.rowIndex = (uint *) malloc((partialSize+1) * sizeof(uint));
-    csr_args[i].table.colIndex = (uint *) malloc(nonzeros * sizeof(uint));
-    csr_args[i].table.values = (int *) malloc(nonzeros * sizeof(int));
+    csr_args[i].table.rowIndex = NULL;
+    csr_args[i].table.colIndex = NULL;
+    csr_args[i].table.values = NULL;
     csr_args[i].id = i;
     csr_args[i].start = start;
     csr_args[i].end = end;
+  }
 
-    uint individualSize = sizeof(int) + 3 * sizeof(uint) +
-      (size + 1) * sizeof(uint) + nonzeros * sizeof(uint) + nonzeros * sizeof(int);
+  return csr_args;
+}
 
-    totalSize += individualSize;
-  }
 
-  csr_args = (csr_arg *) realloc(csr_args, totalSize);
+// splitRows(), printing every slice.
+csr_arg *makeThreadArguments(csr table, int max_threads) {
+  csr_arg *csr_args = splitRows(table, max_threads);
+
+  for (int i = 0; i < max_threads; i++) {
+    uint start = csr_args[i].start, end = csr_args[i].end;
+    PROGRESS("start = %u\tend = %u\tsize = %u\n", start, end, end - start);
+    PROGRESS("nonzeros = %u\n", table.rowIndex[end] - table.rowIndex[start]);
+  }
 
   return csr_args;
 }
 
 
+// Frees the arrays of a CSR table.
+void freeCSR(csr table) {
+  free(table.values);
+  free(table.colIndex);
+  free(table.rowIndex);
+}
+
+
+// Frees the sub-tables of a csr_arg array and the array itself.
+void freeThreadArguments(csr_arg *csr_args, int max_threads) {
+  for (int i = 0; i < max_threads; i++) {
+    freeCSR(csr_args[i].table);
+  }
+  free(csr_args);
+}
+
+
 csr hadamardSingleStep(csr table, uint start, uint end) {
   uint size = end - start;
   
@@ -211,6 +236,9 @@ int dot(csr table, uint row, uint column) {
   // Leaves a trace of the last match. The next iteratio will start from
   // the nexr position to get rid of unnecessary comparisons.
   uint lastMatch = colStart - 1;
+  // The first column of the next row, where the scan of a row can stop (see 3. below).
+  // The last row has none, and a table can end right after its last nonzero.
+  uint nextColumn = (colEnd < table.rowIndex[table.size]) ? table.colIndex[colEnd] : UINT_MAX;
 
   /**
    * 1. If table.colIndex[i] == table.colIndex[j] then we have a match. 
@@ -231,7 +259,7 @@ int dot(csr table, uint row, uint column) {
       else if (table.colIndex[i] > table.colIndex[j]) {
         lastMatch = j;
       }
-      else if (table.colIndex[i] > table.colIndex[colEnd]) {
+      else if (table.colIndex[i] > nextColumn) {
         break;
       }
     }
@@ -0,0 +1,194 @@
+/*
+ * intersect.c
+ * Sorted list intersection kernels. See headers/intersect.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "../headers/csr.h"
+#include "../headers/intersect.h"
+
+
+// The position of the first column of row above value, by binary search.
+uint firstAbove(csr table, uint row, uint value) {
+  uint low = table.rowIndex[row], high = table.rowIndex[row + 1];
+  while (low < high) {
+    uint middle = low + (high - low) / 2;
+    if (table.colIndex[middle] <= value) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+
+uint intersectMerge(uint *a, uint sizeA, uint *b, uint sizeB) {
+  uint i = 0, j = 0, common = 0;
+
+  while (i < sizeA && j < sizeB) {
+    if (a[i] == b[j]) {
+      common++;
+      i++;
+      j++;
+    } else if (a[i] < b[j]) {
+      i++;
+    } else {
+      j++;
+    }
+  }
+
+  return common;
+}
+
+
+// The first index of list, from start on, whose element isn't smaller than value.
+// Doubles the step until it overshoots, then binary searches the last step.
+static uint gallop(uint *list, uint start, uint size, uint value) {
+  uint step = 1;
+  uint low = start;
+  uint high = start;
+
+  while (high < size && list[high] < value) {
+    low = high + 1;
+    high = start + step;
+    step *= 2;
+  }
+  high = (high < size) ? high : size;
+
+  while (low < high) {
+    uint middle = low + (high - low) / 2;
+    if (list[middle] < value) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  return low;
+}
+
+
+uint intersectGalloping(uint *a, uint sizeA, uint *b, uint sizeB) {
+  // Search the elements of the short list in the long one.
+  if (sizeA > sizeB) {
+    uint *list = a; a = b; b = list;
+    uint size = sizeA; sizeA = sizeB; sizeB = size;
+  }
+
+  uint common = 0;
+  uint j = 0;
+  for (uint i = 0; i < sizeA && j < sizeB; i++) {
+    j = gallop(b, j, sizeB, a[i]);
+    if (j < sizeB && b[j] == a[i]) {
+      common++;
+      j++;
+    }
+  }
+
+  return common;
+}
+
+
+uint intersectSIMD(uint *a, uint sizeA, uint *b, uint sizeB) {
+  uint i = 0, j = 0, common = 0;
+
+#ifdef __SSE2__
+  // Compare 4 elements of a with the 4 elements of b and their 3 rotations. The elements
+  // are distinct, so every match sets exactly one lane. Then move past the block that
+  // ends first (or both).
+  while (i + 4 <= sizeA && j + 4 <= sizeB) {
+    __m128i blockA = _mm_loadu_si128((__m128i *) &a[i]);
+    __m128i blockB = _mm_loadu_si128((__m128i *) &b[j]);
+
+    __m128i matches = _mm_cmpeq_epi32(blockA, blockB);
+    matches = _mm_or_si128(matches, _mm_cmpeq_epi32(blockA, _mm_shuffle_epi32(blockB, 0x39)));
+    matches = _mm_or_si128(matches, _mm_cmpeq_epi32(blockA, _mm_shuffle_epi32(blockB, 0x4E)));
+    matches = _mm_or_si128(matches, _mm_cmpeq_epi32(blockA, _mm_shuffle_epi32(blockB, 0x93)));
+    common += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(matches)));
+
+    uint lastA = a[i + 3];
+    uint lastB = b[j + 3];
+    i += (lastA <= lastB) ? 4 : 0;
+    j += (lastB <= lastA) ? 4 : 0;
+  }
+#endif
+
+  // The tails, with the scalar merge.
+  return common + intersectMerge(&a[i], sizeA - i, &b[j], sizeB - j);
+}
+
+
+// The table of the hash kernel, grown as needed and kept by every thread.
+static __thread uint *hash_table = NULL;
+static __thread uint hash_capacity = 0;
+
+#define HASH_EMPTY 0xFFFFFFFFu
+
+
+uint intersectHash(uint *a, uint sizeA, uint *b, uint sizeB) {
+  if (sizeA > sizeB) {
+    uint *list = a; a = b; b = list;
+    uint size = sizeA; sizeA = sizeB; sizeB = size;
+  }
+  if (sizeA == 0) {
+    return 0;
+  }
+
+  // At most half full, so that the probes stay short.
+  uint capacity = 16;
+  while (capacity < 2 * sizeA) {
+    capacity *= 2;
+  }
+  if (capacity > hash_capacity) {
+    free(hash_table);
+    hash_table = (uint *) malloc(capacity * sizeof(uint));
+    hash_capacity = capacity;
+  }
+
+  uint mask = capacity - 1;
+  for (uint k = 0; k < capacity; k++) {
+    hash_table[k] = HASH_EMPTY;
+  }
+  for (uint i = 0; i < sizeA; i++) {
+    uint slot = (a[i] * 0x9E3779B1u) & mask;
+    while (hash_table[slot] != HASH_EMPTY) {
+      slot = (slot + 1) & mask;
+    }
+    hash_table[slot] = a[i];
+  }
+
+  uint common = 0;
+  for (uint j = 0; j < sizeB; j++) {
+    uint slot = (b[j] * 0x9E3779B1u) & mask;
+    while (hash_table[slot] != HASH_EMPTY) {
+      if (hash_table[slot] == b[j]) {
+        common++;
+        break;
+      }
+      slot = (slot + 1) & mask;
+    }
+  }
+
+  return common;
+}
+
+
+uint intersectAdaptive(uint *a, uint sizeA, uint *b, uint sizeB) {
+  uint shorter = (sizeA < sizeB) ? sizeA : sizeB;
+  uint longer = (sizeA < sizeB) ? sizeB : sizeA;
+
+  if ((unsigned long) shorter * INTERSECT_GALLOP_RATIO <= longer) {
+    return intersectGalloping(a, sizeA, b, sizeB);
+  }
+  if (shorter >= INTERSECT_SIMD_MIN) {
+    return intersectSIMD(a, sizeA, b, sizeB);
+  }
+  return intersectMerge(a, sizeA, b, sizeB);
+}
@@ -0,0 +1,235 @@
+/*
+ * libtricount.c
+ * The C API of the library. See headers/libtricount.h.
+ *
+ * A handle keeps the CSR table the backends take. A wrapped table points to the arrays
+ * of the caller. Only its values, all 1, are allocated, since dot() multiplies them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../headers/csr.h"
+#include "../headers/mmio.h"
+#include "../headers/helpers.h"
+#include "../headers/backends.h"
+#include "../headers/generator.h"
+#include "../headers/subset.h"
+#include "../headers/libtricount.h"
+
+struct tricount_graph {
+  csr table;
+  // 1 if the row and column arrays are ours to free.
+  int owned;
+};
+
+
+int tricountVersion() {
+  return TRICOUNT_API_VERSION;
+}
+
+
+const char *tricountError(int error) {
+  switch (error) {
+    case TRICOUNT_OK: return "ok";
+    case TRICOUNT_ERROR_ARGUMENT: return "invalid argument";
+    case TRICOUNT_ERROR_BACKEND: return "no such backend in this build";
+    case TRICOUNT_ERROR_MEMORY: return "out of memory";
+    default: return "unknown error";
+  }
+}
+
+
+// Fills names with up to max backend names. Returns how many this build has.
+int tricountBackends(const char **names, int max) {
+  for (int i = 0; i < backends_num && i < max; i++) {
+    names[i] = backends[i].name;
+  }
+  return backends_num;
+}
+
+
+// A .mtx file, a .csr snapshot or a generator spec, like the graphs of tricount.
+tricount_graph *tricountLoad(const char *path) {
+  if (path == NULL) {
+    return NULL;
+  }
+
+  csr table = loadGraph((char *) path);
+  if (table.rowIndex == NULL) {
+    return NULL;
+  }
+
+  tricount_graph *graph = (tricount_graph *) malloc(sizeof(tricount_graph));
+  if (graph == NULL) {
+    freeCSR(table);
+    return NULL;
+  }
+  graph->table = table;
+  graph->owned = 1;
+  return graph;
+}
+
+
+// Uses the arrays of the caller as they are. Returns NULL if they aren't a valid table:
+// rowIndex must start at 0 and never decrease, and every row must have sorted columns
+// below vertices.
+tricount_graph *tricountWrap(unsigned int vertices, const unsigned int *rowIndex, const unsigned int *colIndex) {
+  if (rowIndex == NULL || (colIndex == NULL && vertices > 0 && rowIndex[vertices] > 0) || rowIndex[0] != 0) {
+    return NULL;
+  }
+  for (uint row = 0; row < vertices; row++) {
+    if (rowIndex[row + 1] < rowIndex[row]) {
+      return NULL;
+    }
+    for (uint i = rowIndex[row]; i < rowIndex[row + 1]; i++) {
+      if (colIndex[i] >= vertices || (i > rowIndex[row] && colIndex[i] <= colIndex[i - 1])) {
+        return NULL;
+      }
+    }
+  }
+
+  uint nonzeros = rowIndex[vertices];
+  tricount_graph *graph = (tricount_graph *) malloc(sizeof(tricount_graph));
+  int *values = (int *) malloc((nonzeros > 0 ? nonzeros : 1) * sizeof(int));
+  if (graph == NULL || values == NULL) {
+    free(graph);
+    free(values);
+    return NULL;
+  }
+  for (uint i = 0; i < nonzeros; i++) {
+    values[i] = 1;
+  }
+
+  // The backends never write to the table, so the arrays can stay const for the caller.
+  csr table = {vertices, values, (uint *) colIndex, (uint *) rowIndex};
+  graph->table = table;
+  graph->owned = 0;
+  return graph;
+}
+
+
+void tricountFree(tricount_graph *graph) {
+  if (graph == NULL) {
+    return;
+  }
+
+  if (graph->owned) {
+    freeCSR(graph->table);
+  } else {
+    free(graph->table.values);
+  }
+  free(graph);
+}
+
+
+unsigned int tricountVertices(const tricount_graph *graph) {
+  return (graph != NULL) ? graph->table.size : 0;
+}
+
+
+unsigned long long tricountNonzeros(const tricount_graph *graph) {
+  return (graph != NULL) ? graph->table.rowIndex[graph->table.size] : 0;
+}
+
+
+// The fastest backend of this build, every cpu, and rows.
+void tricountDefaultOptions(tricount_options *options) {
+  options->backend = (findBackend("openmp") != NULL) ? "openmp" : "pthreads";
+  options->threads = 0;
+  options->mode = TRICOUNT_ROWS;
+}
+
+
+// Counts the triangles of every vertex into triangles (tricountVertices() of them) and
+// their total into total. Either one can be NULL. options can be NULL for the defaults.
+int tricountCount(tricount_graph *graph, const tricount_options *options, unsigned int *triangles,
+  unsigned long long *total)
+{
+  if (graph == NULL) {
+    return TRICOUNT_ERROR_ARGUMENT;
+  }
+
+  tricount_options chosen;
+  tricountDefaultOptions(&chosen);
+  if (options != NULL) {
+    chosen.backend = (options->backend != NULL) ? options->backend : chosen.backend;
+    chosen.threads = options->threads;
+    chosen.mode = options->mode;
+  }
+  if (chosen.threads < 0 || (chosen.mode != TRICOUNT_ROWS && chosen.mode != TRICOUNT_EDGES)) {
+    return TRICOUNT_ERROR_ARGUMENT;
+  }
+  if (chosen.threads == 0) {
+    chosen.threads = sysconf(_SC_NPROCESSORS_ONLN);
+    chosen.threads = (chosen.threads < 1) ? 1 : chosen.threads;
+  }
+
+  // The edge mode of a backend is its -edge variant.
+  char name[64];
+  snprintf(name, sizeof(name), (chosen.mode == TRICOUNT_EDGES) ? "%s-edge" : "%s", chosen.backend);
+  backend *engine = findBackend(name);
+  if (engine == NULL) {
+    return TRICOUNT_ERROR_BACKEND;
+  }
+
+  uint size = graph->table.size;
+  if (size == 0) {
+    if (total != NULL) {
+      *total = 0;
+    }
+    return TRICOUNT_OK;
+  }
+
+  uint *counts = engine->count(graph->table, chosen.threads, NULL);
+  if (counts == NULL) {
+    return TRICOUNT_ERROR_MEMORY;
+  }
+
+  unsigned long long sum = 0;
+  for (uint i = 0; i < size; i++) {
+    sum += counts[i];
+  }
+  if (triangles != NULL) {
+    memcpy(triangles, counts, size * sizeof(uint));
+  }
+  if (total != NULL) {
+    *total = sum / 3;
+  }
+
+  free(counts);
+  return TRICOUNT_OK;
+}
+
+
+// Counts the triangles of the count vertices given (0-based) into triangles, in their
+// order, reading only their rows and those of their neighbors (see headers/subset.h).
+// Only the threads of options are used.
+int tricountCountSubset(tricount_graph *graph, const tricount_options *options,
+  const unsigned int *vertices, unsigned int count, unsigned int *triangles)
+{
+  if (graph == NULL || (count > 0 && (vertices == NULL || triangles == NULL))) {
+    return TRICOUNT_ERROR_ARGUMENT;
+  }
+  int threads = (options != NULL) ? options->threads : 0;
+  if (threads < 0) {
+    return TRICOUNT_ERROR_ARGUMENT;
+  }
+  if (threads == 0) {
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = (threads < 1) ? 1 : threads;
+  }
+  if (count == 0) {
+    return TRICOUNT_OK;
+  }
+
+  uint *counts = countSubsetTriangles(graph->table, (uint *) vertices, count, threads);
+  if (counts == NULL) {
+    return TRICOUNT_ERROR_ARGUMENT;
+  }
+  memcpy(triangles, counts, count * sizeof(uint));
+  free(counts);
+  return TRICOUNT_OK;
+}
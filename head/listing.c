@@ -0,0 +1,226 @@
+/*
+ * listing.c
+ * Triangle listing into a file per worker. See headers/listing.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <aio.h>
+#include <pthread.h>
+
+#include "../headers/csr.h"
+#include "../headers/bench.h"
+#include "../headers/intersect.h"
+#include "../headers/listing.h"
+
+// The longest a triangle gets: three uint32 in text, with the spaces and the newline.
+#define LISTING_MAX_ENTRY 33
+
+typedef struct {
+  csr table;
+  int format;
+  uint *next;
+
+  int fd;
+  char *buffers[2];
+  size_t used;
+  int current;
+  struct aiocb pending;
+  int inFlight;
+  off_t offset;
+
+  unsigned long long triangles;
+  int failed;
+} listing_worker;
+
+
+void listingFileName(char *name, size_t length, char *prefix, int format, int worker) {
+  snprintf(name, length, "%s.%d.%s", prefix, worker, (format == LISTING_TEXT) ? "txt" : "bin");
+}
+
+
+// Waits for the write in flight, if any.
+static void waitWrite(listing_worker *worker) {
+  if (!worker->inFlight) {
+    return;
+  }
+
+  const struct aiocb *list[1] = { &worker->pending };
+  while (aio_error(&worker->pending) == EINPROGRESS) {
+    aio_suspend(list, 1, NULL);
+  }
+  if (aio_return(&worker->pending) != (ssize_t) worker->pending.aio_nbytes) {
+    worker->failed = 1;
+  }
+  worker->inFlight = 0;
+}
+
+
+// Starts writing the current buffer and moves on to the other one, once it's written.
+static void flushBuffer(listing_worker *worker) {
+  waitWrite(worker);
+  if (worker->used == 0 || worker->failed) {
+    worker->used = 0;
+    return;
+  }
+
+  memset(&worker->pending, 0, sizeof(struct aiocb));
+  worker->pending.aio_fildes = worker->fd;
+  worker->pending.aio_buf = worker->buffers[worker->current];
+  worker->pending.aio_nbytes = worker->used;
+  worker->pending.aio_offset = worker->offset;
+  if (aio_write(&worker->pending) != 0) {
+    worker->failed = 1;
+  } else {
+    worker->inFlight = 1;
+  }
+
+  worker->offset += worker->used;
+  worker->current ^= 1;
+  worker->used = 0;
+}
+
+
+// The digits of number, backwards, then in order.
+static char *appendNumber(char *out, uint number) {
+  char digits[10];
+  int count = 0;
+  do {
+    digits[count++] = '0' + number % 10;
+    number /= 10;
+  } while (number > 0);
+  while (count > 0) {
+    *out++ = digits[--count];
+  }
+  return out;
+}
+
+
+static void emitTriangle(listing_worker *worker, uint u, uint v, uint w) {
+  if (worker->used + LISTING_MAX_ENTRY > LISTING_BUFFER_BYTES) {
+    flushBuffer(worker);
+  }
+
+  char *out = worker->buffers[worker->current] + worker->used;
+  if (worker->format == LISTING_TEXT) {
+    char *end = appendNumber(out, u + 1);
+    *end++ = ' ';
+    end = appendNumber(end, v + 1);
+    *end++ = ' ';
+    end = appendNumber(end, w + 1);
+    *end++ = '\n';
+    worker->used += end - out;
+  } else {
+    uint triangle[3] = { u, v, w };
+    memcpy(out, triangle, sizeof(triangle));
+    worker->used += sizeof(triangle);
+  }
+  worker->triangles++;
+}
+
+
+static void listRow(listing_worker *worker, uint u) {
+  csr table = worker->table;
+  uint end = table.rowIndex[u + 1];
+
+  for (uint i = firstAbove(table, u, u); i < end; i++) {
+    uint v = table.colIndex[i];
+    // The w above v in both rows: after v in the row of u, above v in the row of v.
+    uint a = i + 1;
+    uint b = firstAbove(table, v, v), bEnd = table.rowIndex[v + 1];
+    while (a < end && b < bEnd) {
+      uint x = table.colIndex[a], y = table.colIndex[b];
+      if (x < y) {
+        a++;
+      } else if (x > y) {
+        b++;
+      } else {
+        emitTriangle(worker, u, v, x);
+        a++;
+        b++;
+      }
+    }
+  }
+}
+
+
+static void *listRowsVoid(void *arg) {
+  listing_worker *worker = (listing_worker *) arg;
+  uint size = worker->table.size;
+
+  while (!worker->failed) {
+    uint start = __atomic_fetch_add(worker->next, LISTING_BLOCK_ROWS, __ATOMIC_RELAXED);
+    if (start >= size) {
+      break;
+    }
+    uint end = (start + LISTING_BLOCK_ROWS < size) ? start + LISTING_BLOCK_ROWS : size;
+    for (uint u = start; u < end; u++) {
+      listRow(worker, u);
+    }
+  }
+
+  flushBuffer(worker);
+  waitWrite(worker);
+  return NULL;
+}
+
+
+listing_result listTriangles(csr table, char *prefix, int format, int threads) {
+  listing_result result;
+  memset(&result, 0, sizeof(result));
+  threads = (threads < 1) ? 1 : threads;
+
+  listing_worker *workers = (listing_worker *) calloc(threads, sizeof(listing_worker));
+  pthread_t *ids = (pthread_t *) malloc(threads * sizeof(pthread_t));
+  uint next = 0;
+  int opened = 0;
+
+  double start = nowMicros();
+  for (int i = 0; i < threads; i++) {
+    char name[1024];
+    listingFileName(name, sizeof(name), prefix, format, i);
+    workers[i].fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (workers[i].fd < 0) {
+      printf("Couldn't write %s\n", name);
+      break;
+    }
+    opened++;
+    workers[i].table = table;
+    workers[i].format = format;
+    workers[i].next = &next;
+    workers[i].buffers[0] = (char *) malloc(LISTING_BUFFER_BYTES);
+    workers[i].buffers[1] = (char *) malloc(LISTING_BUFFER_BYTES);
+  }
+
+  if (opened == threads) {
+    for (int i = 0; i < threads; i++) {
+      pthread_create(&ids[i], NULL, listRowsVoid, (void *) &workers[i]);
+    }
+    for (int i = 0; i < threads; i++) {
+      pthread_join(ids[i], NULL);
+    }
+  }
+
+  int failed = (opened < threads);
+  for (int i = 0; i < opened; i++) {
+    result.triangles += workers[i].triangles;
+    result.bytes += workers[i].offset;
+    failed |= workers[i].failed;
+    close(workers[i].fd);
+    free(workers[i].buffers[0]);
+    free(workers[i].buffers[1]);
+  }
+  result.time = nowMicros() - start;
+  result.files = failed ? 0 : threads;
+  if (failed && opened == threads) {
+    printf("Couldn't write every triangle under %s\n", prefix);
+  }
+
+  free(workers);
+  free(ids);
+  return result;
+}
@@ -0,0 +1,217 @@
+/*
+ * memory.c
+ * The wrapped allocator and the heap accounting. See headers/memory.h.
+ *
+ * With glibc, the program defines malloc(), calloc(), realloc(), free() and the aligned
+ * allocators itself and passes them on to glibc's own (__libc_malloc() and the rest),
+ * which the C library supports for replacing its allocator. The size of every block is
+ * what malloc_usable_size() says, so freeing needs no header in front of it.
+ * The live and the peak heap are shared atomics. What a phase allocates is kept per
+ * thread, like the hardware counters.
+ *
+ * Without glibc nothing is wrapped, and only the peak resident set size is measured.
+ * Neither in the library (TRICOUNT_LIBRARY), which must not replace the allocator of
+ * the process that loads it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/resource.h>
+
+#if defined(__GLIBC__) && !defined(TRICOUNT_LIBRARY)
+#define MEMORY_WRAP
+#include <malloc.h>
+#endif
+
+#include "../headers/memory.h"
+
+int memory_enabled = 0;
+
+static long long heap_live = 0;
+static long long heap_peak = 0;
+
+// What the calling thread allocated and holds (allocated minus freed, by this thread),
+// the most it held since its phase started, and both at the start of the phase.
+static __thread long long thread_allocated = 0;
+static __thread long long thread_held = 0;
+static __thread long long thread_high = 0;
+static __thread long long phase_allocated = 0;
+static __thread long long phase_held = 0;
+
+
+#ifdef MEMORY_WRAP
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *pointer, size_t size);
+extern void *__libc_memalign(size_t alignment, size_t size);
+extern void *__libc_valloc(size_t size);
+extern void *__libc_pvalloc(size_t size);
+extern void __libc_free(void *pointer);
+
+
+static void *countAllocation(void *pointer) {
+  if (!memory_enabled || pointer == NULL) {
+    return pointer;
+  }
+
+  long long size = malloc_usable_size(pointer);
+  thread_allocated += size;
+  thread_held += size;
+  thread_high = (thread_held > thread_high) ? thread_held : thread_high;
+
+  long long live = __atomic_add_fetch(&heap_live, size, __ATOMIC_RELAXED);
+  long long peak = __atomic_load_n(&heap_peak, __ATOMIC_RELAXED);
+  while (live > peak &&
+    !__atomic_compare_exchange_n(&heap_peak, &peak, live, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+  }
+  return pointer;
+}
+
+
+static void countFree(void *pointer) {
+  if (!memory_enabled || pointer == NULL) {
+    return;
+  }
+
+  long long size = malloc_usable_size(pointer);
+  thread_held -= size;
+  __atomic_sub_fetch(&heap_live, size, __ATOMIC_RELAXED);
+}
+
+
+void *malloc(size_t size) {
+  return countAllocation(__libc_malloc(size));
+}
+
+
+void *calloc(size_t count, size_t size) {
+  return countAllocation(__libc_calloc(count, size));
+}
+
+
+void *realloc(void *pointer, size_t size) {
+  countFree(pointer);
+  void *moved = __libc_realloc(pointer, size);
+
+  // A failed realloc() leaves the old block where it was. A size of 0 frees it.
+  if (moved == NULL && size > 0) {
+    countAllocation(pointer);
+  }
+  return countAllocation(moved);
+}
+
+
+void free(void *pointer) {
+  countFree(pointer);
+  __libc_free(pointer);
+}
+
+
+void *memalign(size_t alignment, size_t size) {
+  return countAllocation(__libc_memalign(alignment, size));
+}
+
+
+void *aligned_alloc(size_t alignment, size_t size) {
+  return countAllocation(__libc_memalign(alignment, size));
+}
+
+
+int posix_memalign(void **pointer, size_t alignment, size_t size) {
+  if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0) {
+    return EINVAL;
+  }
+
+  void *block = countAllocation(__libc_memalign(alignment, size));
+  if (block == NULL) {
+    return ENOMEM;
+  }
+  *pointer = block;
+  return 0;
+}
+
+
+void *valloc(size_t size) {
+  return countAllocation(__libc_valloc(size));
+}
+
+
+void *pvalloc(size_t size) {
+  return countAllocation(__libc_pvalloc(size));
+}
+
+#endif
+
+
+void memoryEnable() {
+  memory_enabled = 1;
+}
+
+
+// The start of a phase of the calling thread.
+void memoryPhaseStart() {
+  phase_allocated = thread_allocated;
+  phase_held = thread_held;
+  thread_high = thread_held;
+}
+
+
+// The usage of the calling thread since memoryPhaseStart().
+memory_usage memoryPhaseEnd() {
+  memory_usage usage;
+  usage.allocated = thread_allocated - phase_allocated;
+  usage.retained = thread_held - phase_held;
+  usage.peak = thread_high - phase_held;
+  return usage;
+}
+
+
+// Starts the peaks of the heap and of the resident set over, from what is in use now.
+// Writing 5 to clear_refs resets the VmHWM of the process (Linux 4.0 and later).
+void memoryResetPeak() {
+  __atomic_store_n(&heap_peak, __atomic_load_n(&heap_live, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+
+  FILE *file = fopen("/proc/self/clear_refs", "w");
+  if (file != NULL) {
+    fputs("5", file);
+    fclose(file);
+  }
+}
+
+
+long long memoryLive() {
+  return __atomic_load_n(&heap_live, __ATOMIC_RELAXED);
+}
+
+
+long long memoryPeak() {
+  return __atomic_load_n(&heap_peak, __ATOMIC_RELAXED);
+}
+
+
+// The peak resident set size in bytes, since the last memoryResetPeak() when the kernel
+// allows resetting it. getrusage() only has the peak of the whole process.
+long long memoryPeakRSS() {
+  FILE *file = fopen("/proc/self/status", "r");
+  if (file != NULL) {
+    char line[256];
+    long long kilobytes = -1;
+    while (fgets(line, sizeof(line), file) != NULL) {
+      if (strncmp(line, "VmHWM:", 6) == 0) {
+        kilobytes = atoll(&line[6]);
+        break;
+      }
+    }
+    fclose(file);
+    if (kilobytes >= 0) {
+      return kilobytes * 1024;
+    }
+  }
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return (long long) usage.ru_maxrss * 1024;
+}
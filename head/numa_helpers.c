@@ -0,0 +1,457 @@
+/*
+ * numa_helpers.c
+ * NUMA mode for the parallel algorithms. See headers/numa_helpers.h.
+ *
+ * readmtx_dynamic() builds the whole CSR on the main thread, so every page ends
+ * up on the node of that thread. Here we re-create the arrays with each worker
+ * writing (first touching) the rows it will later process, so the pages of
+ * every partition land on the node of the worker that reads them.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+
+#include "../headers/csr.h"
+#include "../headers/csr_arg.h"
+#include "../headers/numa_helpers.h"
+
+#define NODE_PATH "/sys/devices/system/node"
+#define MAX_NODES 256
+
+
+// Reads a sysfs cpu list ("0-3,8,10-11") and marks every cpu in it as a member of node.
+static void parseCpuList(char *list, int *cpuNode, int cpus, int node) {
+  char *token = strtok(list, ",\n");
+
+  while (token != NULL) {
+    int first, last;
+    if (sscanf(token, "%d-%d", &first, &last) != 2) {
+      first = last = atoi(token);
+    }
+
+    for (int cpu = first; cpu <= last && cpu < cpus; cpu++) {
+      cpuNode[cpu] = node;
+    }
+    token = strtok(NULL, ",\n");
+  }
+}
+
+
+// Finds the NUMA nodes and the cpus of each one. Machines without
+// /sys/devices/system/node are treated as a single node.
+numa_topology readTopology() {
+  numa_topology topology;
+  topology.cpus = sysconf(_SC_NPROCESSORS_CONF);
+  topology.cpuNode = (int *) calloc(topology.cpus, sizeof(int));
+  topology.nodes = 1;
+
+  for (int node = 0; node < MAX_NODES; node++) {
+    char path[128];
+    snprintf(path, sizeof(path), NODE_PATH "/node%d/cpulist", node);
+
+    FILE *cpulist = fopen(path, "r");
+    if (cpulist == NULL) {
+      continue;
+    }
+
+    char list[4096];
+    if (fgets(list, sizeof(list), cpulist) != NULL) {
+      parseCpuList(list, topology.cpuNode, topology.cpus, node);
+    }
+    fclose(cpulist);
+
+    if (node + 1 > topology.nodes) {
+      topology.nodes = node + 1;
+    }
+  }
+
+  return topology;
+}
+
+
+// Assigns a cpu to every worker. The affinity can be:
+// "none" (or NULL): no pinning, all workers are considered to be on node 0.
+// "compact": fill the cpus of node 0 first, then node 1 and so on.
+// "scatter": distribute the workers round-robin between the nodes.
+// A comma separated list of cpus ("0,8,1,9"), used in that order.
+numa_plan makeNumaPlan(int threads, char *affinity, int replicate) {
+  numa_plan plan;
+  plan.topology = readTopology();
+  plan.threads = threads;
+  plan.cpus = (int *) malloc(threads * sizeof(int));
+  plan.nodes = (int *) calloc(threads, sizeof(int));
+  plan.replicate = replicate;
+  plan.replicas = NULL;
+
+  int cpus = plan.topology.cpus;
+  int nodes = plan.topology.nodes;
+
+  // The cpus sorted by node. nodeStart[n] is the first cpu of node n in that order.
+  int *order = (int *) malloc(cpus * sizeof(int));
+  int *nodeStart = (int *) calloc(nodes + 1, sizeof(int));
+  int placed = 0;
+  for (int node = 0; node < nodes; node++) {
+    nodeStart[node] = placed;
+    for (int cpu = 0; cpu < cpus; cpu++) {
+      if (plan.topology.cpuNode[cpu] == node) {
+        order[placed++] = cpu;
+      }
+    }
+  }
+  nodeStart[nodes] = placed;
+
+  for (int i = 0; i < threads; i++) {
+    if (affinity == NULL || strcmp(affinity, "none") == 0) {
+      plan.cpus[i] = -1;
+    }
+    else if (strcmp(affinity, "compact") == 0) {
+      plan.cpus[i] = order[i % cpus];
+    }
+    else if (strcmp(affinity, "scatter") == 0) {
+      // Skip the nodes that have memory but no cpus.
+      int node = i % nodes;
+      while (nodeStart[node + 1] == nodeStart[node]) {
+        node = (node + 1) % nodes;
+      }
+      int nodeCpus = nodeStart[node + 1] - nodeStart[node];
+      plan.cpus[i] = order[nodeStart[node] + (i / nodes) % nodeCpus];
+    }
+    else {
+      // An explicit list. Count the entries, then pick the (i mod count)-th one.
+      char *copy = strdup(affinity);
+      int count = 0;
+      int chosen = -1;
+      int wanted = -1;
+
+      for (char *c = copy; *c != '\0'; c++) {
+        count += (*c == ',');
+      }
+      count++;
+      wanted = i % count;
+
+      char *token = strtok(copy, ",");
+      for (int j = 0; token != NULL; j++, token = strtok(NULL, ",")) {
+        if (j == wanted) {
+          chosen = atoi(token);
+          break;
+        }
+      }
+      free(copy);
+
+      plan.cpus[i] = (chosen >= 0 && chosen < cpus) ? chosen : -1;
+    }
+
+    plan.nodes[i] = (plan.cpus[i] >= 0) ? plan.topology.cpuNode[plan.cpus[i]] : 0;
+  }
+
+  free(order);
+  free(nodeStart);
+
+  printf("NUMA: %d node(s), %d cpu(s), affinity = %s, replicate = %d\n",
+    nodes, cpus, (affinity == NULL) ? "none" : affinity, replicate);
+  for (int i = 0; i < threads; i++) {
+    printf("worker %d -> cpu %d (node %d)\n", i, plan.cpus[i], plan.nodes[i]);
+  }
+
+  return plan;
+}
+
+
+// Pins the calling thread to a single cpu. Does nothing for cpu < 0.
+int pinThread(int cpu) {
+  if (cpu < 0) {
+    return 0;
+  }
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+
+  return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
+}
+
+
+// Used by the worker threads that place the arrays in memory.
+// @param source: The table that's copied.
+// @param target: The table that's written. Its arrays are already allocated but untouched.
+// @param start, end: The rows this worker writes.
+// @param cpu: The cpu the worker is pinned to before writing.
+typedef struct {
+  csr source;
+  csr target;
+  uint start;
+  uint end;
+  int cpu;
+} touch_arg;
+
+
+void *touchRowsVoid(void *touch) {
+  touch_arg *arg = (touch_arg *) touch;
+  pinThread(arg->cpu);
+
+  uint first = arg->source.rowIndex[arg->start];
+  uint last = arg->source.rowIndex[arg->end];
+
+  // The last worker also writes the closing element of rowIndex.
+  uint rowsEnd = (arg->end == arg->source.size) ? arg->end + 1 : arg->end;
+  for (uint row = arg->start; row < rowsEnd; row++) {
+    arg->target.rowIndex[row] = arg->source.rowIndex[row];
+  }
+
+  for (uint i = first; i < last; i++) {
+    arg->target.colIndex[i] = arg->source.colIndex[i];
+    arg->target.values[i] = arg->source.values[i];
+  }
+
+  return NULL;
+}
+
+
+// Makes a copy of table whose pages are first touched by the worker that owns each row range.
+// malloc() only reserves virtual memory for arrays this large, so the physical pages are
+// placed on the node of the thread that writes them first.
+csr firstTouchCSR(csr table, csr_arg *args, numa_plan *plan) {
+  uint size = table.size;
+  uint nonzeros = table.rowIndex[size];
+
+  csr touched = {
+    size,
+    (int *) malloc(nonzeros * sizeof(int)),
+    (uint *) malloc(nonzeros * sizeof(uint)),
+    (uint *) malloc((size + 1) * sizeof(uint))
+  };
+
+  pthread_t threads[plan->threads];
+  touch_arg touch[plan->threads];
+
+  for (int i = 0; i < plan->threads; i++) {
+    touch[i].source = table;
+    touch[i].target = touched;
+    touch[i].start = args[i].start;
+    touch[i].end = args[i].end;
+    touch[i].cpu = plan->cpus[i];
+    pthread_create(&threads[i], NULL, touchRowsVoid, (void *) &touch[i]);
+  }
+
+  for (int i = 0; i < plan->threads; i++) {
+    pthread_join(threads[i], NULL);
+  }
+
+  return touched;
+}
+
+
+// The first cpu of a node, if there is one.
+static int firstCpuOf(numa_topology *topology, int node) {
+  for (int cpu = 0; cpu < topology->cpus; cpu++) {
+    if (topology->cpuNode[cpu] == node) {
+      return cpu;
+    }
+  }
+  return -1;
+}
+
+
+// Fills plan->replicas. With replication on, each node gets a full copy of
+// the table, written by a thread that runs on that node. Otherwise every entry
+// refers to the given table.
+void replicateCSR(csr table, numa_plan *plan) {
+  int nodes = plan->topology.nodes;
+  plan->replicas = (csr *) malloc(nodes * sizeof(csr));
+
+  for (int node = 0; node < nodes; node++) {
+    plan->replicas[node] = table;
+  }
+
+  if (!plan->replicate) {
+    return;
+  }
+
+  uint size = table.size;
+  uint nonzeros = table.rowIndex[size];
+
+  pthread_t threads[nodes];
+  touch_arg touch[nodes];
+  int started[nodes];
+
+  for (int node = 0; node < nodes; node++) {
+    int cpu = firstCpuOf(&plan->topology, node);
+    started[node] = (cpu >= 0);
+    // Nodes without cpus (memory only) never run a worker.
+    if (!started[node]) {
+      continue;
+    }
+
+    csr replica = {
+      size,
+      (int *) malloc(nonzeros * sizeof(int)),
+      (uint *) malloc(nonzeros * sizeof(uint)),
+      (uint *) malloc((size + 1) * sizeof(uint))
+    };
+    plan->replicas[node] = replica;
+
+    touch[node].source = table;
+    touch[node].target = replica;
+    touch[node].start = 0;
+    touch[node].end = size;
+    touch[node].cpu = cpu;
+    pthread_create(&threads[node], NULL, touchRowsVoid, (void *) &touch[node]);
+  }
+
+  for (int node = 0; node < nodes; node++) {
+    if (started[node]) {
+      pthread_join(threads[node], NULL);
+    }
+  }
+}
+
+
+// The table a worker should read: the replica of its node, if one exists.
+csr numaTable(numa_plan *plan, int worker) {
+  return plan->replicas[plan->nodes[worker]];
+}
+
+
+// Finds the node of every page of an array. Pages that aren't resident get a negative status.
+// NULL if move_pages() fails: there's no placement to report then.
+static int *pageNodes(void *array, size_t bytes, uintptr_t *firstPage, long *pageCount) {
+  long pageSize = sysconf(_SC_PAGESIZE);
+  uintptr_t begin = (uintptr_t) array & ~(uintptr_t) (pageSize - 1);
+  uintptr_t end = (uintptr_t) array + bytes;
+  long count = (end - begin + pageSize - 1) / pageSize;
+
+  void **pages = (void **) malloc(count * sizeof(void *));
+  int *status = (int *) malloc(count * sizeof(int));
+  for (long i = 0; i < count; i++) {
+    pages[i] = (void *) (begin + i * pageSize);
+    status[i] = -1;
+  }
+
+  // With nodes == NULL move_pages() doesn't move anything, it only reports where each page is.
+  if (syscall(SYS_move_pages, 0, count, pages, NULL, status, 0) != 0) {
+    printf("move_pages() failed: %s\n", strerror(errno));
+    free(pages);
+    free(status);
+    return NULL;
+  }
+
+  free(pages);
+  *firstPage = begin;
+  *pageCount = count;
+  return status;
+}
+
+
+// Adds weight for every element of colIndex[from, to) to the local, remote or missing
+// counter, depending on the node of the page the element lives in, if it's resident.
+static void countRange(uint *colIndex, uint from, uint to, unsigned long weight, int node,
+  int *status, uintptr_t firstPage, unsigned long *local, unsigned long *remote, unsigned long *missing)
+{
+  long pageSize = sysconf(_SC_PAGESIZE);
+  uint elementsPerPage = pageSize / sizeof(uint);
+
+  while (from < to) {
+    long page = ((uintptr_t) &colIndex[from] - firstPage) / pageSize;
+    // The elements left until the end of this page.
+    uint pageEnd = from + (elementsPerPage - (((uintptr_t) &colIndex[from] % pageSize) / sizeof(uint)));
+    uint segmentEnd = (pageEnd < to) ? pageEnd : to;
+
+    if (status[page] < 0) {
+      *missing += (segmentEnd - from) * weight;
+    } else if (status[page] == node) {
+      *local += (segmentEnd - from) * weight;
+    } else {
+      *remote += (segmentEnd - from) * weight;
+    }
+    from = segmentEnd;
+  }
+}
+
+
+// Replays the adjacency reads every worker makes in hadamardSingleStep() and reports
+// which share of them hit pages on the worker's own node. Each dot(row, column) reads
+// the whole adjacency of row and of column once.
+void reportNumaAccess(csr_arg *args, numa_plan *plan) {
+  unsigned long totalLocal = 0;
+  unsigned long totalRemote = 0;
+  unsigned long totalMissing = 0;
+
+  printf("\nNUMA access report (adjacency elements read per worker):\n");
+  for (int i = 0; i < plan->threads; i++) {
+    csr table = numaTable(plan, i);
+    uint nonzeros = table.rowIndex[table.size];
+
+    uintptr_t firstPage;
+    long pageCount;
+    int *status = pageNodes(table.colIndex, nonzeros * sizeof(uint), &firstPage, &pageCount);
+    if (status == NULL) {
+      printf("worker %d (cpu %d, node %d): the placement of its pages is unknown\n", i, plan->cpus[i], plan->nodes[i]);
+      continue;
+    }
+
+    unsigned long local = 0;
+    unsigned long remote = 0;
+    unsigned long missing = 0;
+    for (uint row = args[i].start; row < args[i].end; row++) {
+      uint rowStart = table.rowIndex[row];
+      uint rowEnd = table.rowIndex[row+1];
+
+      // The row itself is scanned once for every one of its neighbors.
+      countRange(table.colIndex, rowStart, rowEnd, rowEnd - rowStart, plan->nodes[i],
+        status, firstPage, &local, &remote, &missing);
+
+      for (uint index = rowStart; index < rowEnd; index++) {
+        uint column = table.colIndex[index];
+        countRange(table.colIndex, table.rowIndex[column], table.rowIndex[column+1], 1,
+          plan->nodes[i], status, firstPage, &local, &remote, &missing);
+      }
+    }
+    free(status);
+
+    unsigned long total = local + remote + missing;
+    printf("worker %d (cpu %d, node %d): local = %lu (%.2f%%)\tremote = %lu (%.2f%%)\tnot resident = %lu (%.2f%%)\n",
+      i, plan->cpus[i], plan->nodes[i],
+      local, (total > 0) ? 100.0 * local / total : 0.0,
+      remote, (total > 0) ? 100.0 * remote / total : 0.0,
+      missing, (total > 0) ? 100.0 * missing / total : 0.0);
+
+    totalLocal += local;
+    totalRemote += remote;
+    totalMissing += missing;
+  }
+
+  unsigned long total = totalLocal + totalRemote + totalMissing;
+  printf("total: local/remote/not resident = %.2f%% / %.2f%% / %.2f%%\n\n",
+    (total > 0) ? 100.0 * totalLocal / total : 0.0,
+    (total > 0) ? 100.0 * totalRemote / total : 0.0,
+    (total > 0) ? 100.0 * totalMissing / total : 0.0);
+}
+
+
+// Frees the plan and the replicas it made. The table the replicas were made from
+// belongs to the caller, and so do the entries of the nodes without cpus, that point to it.
+void freeNumaPlan(numa_plan *plan) {
+  if (plan->replicas != NULL && plan->replicate) {
+    for (int node = 0; node < plan->topology.nodes; node++) {
+      if (firstCpuOf(&plan->topology, node) >= 0) {
+        free(plan->replicas[node].values);
+        free(plan->replicas[node].colIndex);
+        free(plan->replicas[node].rowIndex);
+      }
+    }
+  }
+
+  free(plan->replicas);
+  free(plan->cpus);
+  free(plan->nodes);
+  free(plan->topology.cpuNode);
+}
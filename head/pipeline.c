@@ -0,0 +1,299 @@
+/*
+ * pipeline.c
+ * Pipelined load-and-count. See headers/pipeline.h.
+ *
+ * Every entry (row, col) of the file adds col to row and row to col, like in
+ * readmtx_dynamic(). If the entries come sorted by min(row, col) (a lower triangle
+ * sorted by column, or an upper triangle sorted by row, which is how .mtx files
+ * are usually stored), then once we read an entry with min(row, col) == k, no
+ * later entry can touch the rows before k. Those rows are final.
+ *
+ * The loader publishes the final rows in blocks through a lock-free queue (an
+ * array of blocks and a few atomic counters). A block can be counted as soon as
+ * the adjacency of all its neighbors is final too.
+ *
+ * If the file turns out not to be sorted, the loader stops publishing, waits
+ * for the blocks in flight and counts everything after the file is read.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "../headers/mmio.h"
+#include "../headers/csr.h"
+#include "../headers/bench.h"
+#include "../headers/pipeline.h"
+#include "../headers/trace.h"
+#include "../headers/intersect.h"
+
+// @param start, end: The rows of the block.
+// @param maxNeighbor: The largest column in any of its rows. The block is
+// ready when every row up to that one is final.
+typedef struct {
+  uint start;
+  uint end;
+  uint maxNeighbor;
+} row_block;
+
+// Shared between the loader and the counting threads.
+// @param adjacency, degree, capacity: The rows, as they are being read.
+// @param completed: Rows below this one are final.
+// @param published: How many blocks the loader has published.
+// @param claimed: How many blocks the counting threads have taken.
+// @param finished: How many blocks are done (counted or given up).
+// @param loaded: 1 once the whole file has been read.
+// @param broken: 1 if the input isn't sorted. Nothing is published after that.
+// @param workers: How many counting threads have started. Gives each one its number.
+typedef struct {
+  uint size;
+  uint **adjacency;
+  uint *degree;
+  uint *capacity;
+  uint *triangles;
+
+  row_block *blocks;
+  uint blocks_num;
+
+  uint completed;
+  uint published;
+  uint claimed;
+  uint finished;
+  int loaded;
+  int broken;
+  int workers;
+} pipeline_state;
+
+
+static void countBlock(pipeline_state *state, row_block block) {
+  for (uint row = block.start; row < block.end; row++) {
+    uint sum = 0;
+    for (uint i = 0; i < state->degree[row]; i++) {
+      uint column = state->adjacency[row][i];
+      sum += intersectAdaptive(state->adjacency[row], state->degree[row],
+        state->adjacency[column], state->degree[column]);
+    }
+    state->triangles[row] = sum / 2;
+  }
+}
+
+
+void *countBlocksVoid(void *pipeline) {
+  pipeline_state *state = (pipeline_state *) pipeline;
+  int id = __atomic_fetch_add(&state->workers, 1, __ATOMIC_RELAXED);
+
+  while (1) {
+    uint index = __atomic_fetch_add(&state->claimed, 1, __ATOMIC_RELAXED);
+    if (index >= state->blocks_num) {
+      return NULL;
+    }
+
+    // Wait for the block to be published. If the file is done and it never
+    // was, the input wasn't sorted and the main thread counts the rest.
+    while (__atomic_load_n(&state->published, __ATOMIC_ACQUIRE) <= index) {
+      if (__atomic_load_n(&state->loaded, __ATOMIC_ACQUIRE)) {
+        return NULL;
+      }
+      sched_yield();
+    }
+
+    row_block block = state->blocks[index];
+
+    // Then wait for the neighbors of its rows to be final.
+    int ready = 1;
+    while (__atomic_load_n(&state->completed, __ATOMIC_ACQUIRE) <= block.maxNeighbor) {
+      if (__atomic_load_n(&state->broken, __ATOMIC_ACQUIRE)) {
+        ready = 0;
+        break;
+      }
+      sched_yield();
+    }
+
+    if (ready) {
+      double start = traceStart();
+      countBlock(state, block);
+      traceRecord("block", id, start);
+    }
+    __atomic_fetch_add(&state->finished, 1, __ATOMIC_RELEASE);
+  }
+}
+
+
+// Adds column to the end of row, doubling the row when it's full.
+// Returns 0 if that breaks the order of the row.
+static int appendToRow(pipeline_state *state, uint row, uint column) {
+  if (state->degree[row] == state->capacity[row]) {
+    state->capacity[row] = (state->capacity[row] == 0) ? 4 : 2 * state->capacity[row];
+    state->adjacency[row] = (uint *) realloc(state->adjacency[row], state->capacity[row] * sizeof(uint));
+  }
+
+  int sorted = (state->degree[row] == 0) || (state->adjacency[row][state->degree[row] - 1] <= column);
+  state->adjacency[row][state->degree[row]++] = column;
+  return sorted;
+}
+
+
+// Publishes every whole block below the completed rows. At the end of the file,
+// the last (partial) block too.
+static void publishBlocks(pipeline_state *state, uint completed) {
+  uint published = state->published;
+
+  while (published < state->blocks_num && state->blocks[published].end <= completed) {
+    row_block *block = &state->blocks[published];
+    block->maxNeighbor = block->start;
+    for (uint row = block->start; row < block->end; row++) {
+      if (state->degree[row] > 0) {
+        uint last = state->adjacency[row][state->degree[row] - 1];
+        block->maxNeighbor = (last > block->maxNeighbor) ? last : block->maxNeighbor;
+      }
+    }
+    published++;
+  }
+
+  __atomic_store_n(&state->completed, completed, __ATOMIC_RELEASE);
+  __atomic_store_n(&state->published, published, __ATOMIC_RELEASE);
+}
+
+
+static int compareRows(const void *a, const void *b) {
+  uint x = *(const uint *) a;
+  uint y = *(const uint *) b;
+  return (x > y) - (x < y);
+}
+
+
+// Reads the file on the calling thread while the counting threads work on the published blocks.
+pipeline_result countTrianglesPipelined(char *mtx, int threads) {
+  double start = nowMicros();
+
+  pipeline_result result = {{0, NULL, NULL, NULL}, NULL, 0, 0};
+  MM_typecode t;
+  int M, N, nz;
+
+  FILE *matrixFile = fopen(mtx, "r");
+  if (matrixFile == NULL || mm_read_banner(matrixFile, &t) != 0 ||
+    mm_read_mtx_crd_size(matrixFile, &M, &N, &nz) != 0 || M != N)
+  {
+    printf("Error. Couldn't process the .mtx file!");
+    return result;
+  }
+
+  pipeline_state state;
+  memset(&state, 0, sizeof(state));
+  state.size = N;
+  state.adjacency = (uint **) calloc(N, sizeof(uint *));
+  state.degree = (uint *) calloc(N, sizeof(uint));
+  state.capacity = (uint *) calloc(N, sizeof(uint));
+  state.triangles = (uint *) calloc(N, sizeof(uint));
+  state.blocks_num = (N + PIPELINE_BLOCK_ROWS - 1) / PIPELINE_BLOCK_ROWS;
+  state.blocks = (row_block *) malloc(state.blocks_num * sizeof(row_block));
+
+  for (uint i = 0; i < state.blocks_num; i++) {
+    state.blocks[i].start = i * PIPELINE_BLOCK_ROWS;
+    state.blocks[i].end = (i == state.blocks_num - 1) ? state.size : (i + 1) * PIPELINE_BLOCK_ROWS;
+  }
+
+  pthread_t workers[threads];
+  for (int i = 0; i < threads; i++) {
+    pthread_create(&workers[i], NULL, countBlocksVoid, (void *) &state);
+  }
+
+  double loadStart = traceStart();
+  uint completed = 0;
+  for (int i = 0; i < nz; i++) {
+    int row, col;
+    if (fscanf(matrixFile, "%d %d%*[^\n]", &row, &col) != 2) {
+      break;
+    }
+
+    // Decrease the values since Matlab is 1-index based.
+    row--;
+    col--;
+    uint key = (row < col) ? row : col;
+
+    // This entry changes a row that was already published. Stop publishing and
+    // wait for the threads to let go of the rows before we touch them.
+    if (!state.broken && key < completed) {
+      __atomic_store_n(&state.broken, 1, __ATOMIC_RELEASE);
+      while (__atomic_load_n(&state.finished, __ATOMIC_ACQUIRE) < state.published) {
+        sched_yield();
+      }
+    }
+
+    int sorted = appendToRow(&state, row, col);
+    // If the scanned element isn't on the main diagonal, add the symmetric value.
+    if (row != col) {
+      sorted &= appendToRow(&state, col, row);
+    }
+
+    if (!state.broken && !sorted) {
+      __atomic_store_n(&state.broken, 1, __ATOMIC_RELEASE);
+      while (__atomic_load_n(&state.finished, __ATOMIC_ACQUIRE) < state.published) {
+        sched_yield();
+      }
+    }
+
+    // Everything before key is final. Publish only when a new block is complete.
+    if (!state.broken && key > completed) {
+      completed = key;
+      if (state.published < state.blocks_num && state.blocks[state.published].end <= completed) {
+        publishBlocks(&state, completed);
+      }
+    }
+  }
+  fclose(matrixFile);
+
+  if (!state.broken) {
+    publishBlocks(&state, N);
+  }
+  __atomic_store_n(&state.loaded, 1, __ATOMIC_RELEASE);
+  traceRecord("load", TRACE_MAIN, loadStart);
+  result.loadTime = nowMicros() - start;
+
+  for (int i = 0; i < threads; i++) {
+    pthread_join(workers[i], NULL);
+  }
+
+  // The file wasn't sorted: sort the rows and count everything now.
+  if (state.broken) {
+    printf("The entries of %s aren't sorted. Counting after the whole file was read.\n", mtx);
+    for (uint row = 0; row < state.size; row++) {
+      qsort(state.adjacency[row], state.degree[row], sizeof(uint), compareRows);
+    }
+    double countStart = traceStart();
+    row_block whole = {0, N, 0};
+    countBlock(&state, whole);
+    traceRecord("count", TRACE_MAIN, countStart);
+  }
+
+  // Put the rows in a CSR structure, the same way readmtx_dynamic() does.
+  uint *rowIndex = (uint *) calloc(N + 1, sizeof(uint));
+  for (uint row = 0; row < state.size; row++) {
+    rowIndex[row + 1] = rowIndex[row] + state.degree[row];
+  }
+
+  uint nonzeros = rowIndex[N];
+  uint *colIndex = (uint *) malloc(nonzeros * sizeof(uint));
+  int *values = (int *) malloc(nonzeros * sizeof(int));
+  for (uint row = 0; row < state.size; row++) {
+    memcpy(&colIndex[rowIndex[row]], state.adjacency[row], state.degree[row] * sizeof(uint));
+    free(state.adjacency[row]);
+  }
+  for (uint i = 0; i < nonzeros; i++) {
+    values[i] = 1;
+  }
+
+  csr table = {N, values, colIndex, rowIndex};
+  result.table = table;
+  result.triangles = state.triangles;
+  result.pipelined = !state.broken;
+
+  free(state.adjacency);
+  free(state.degree);
+  free(state.capacity);
+  free(state.blocks);
+
+  return result;
+}
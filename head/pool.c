@@ -0,0 +1,271 @@
+/*
+ * pool.c
+ * Batch counting of many graphs on one pool of workers. See headers/pool.h.
+ *
+ * The large graphs are published in jobs, a slot per graph at most. The workers claim
+ * the blocks of a job with an atomic counter and count the finished ones with another.
+ * A job stays in its slot until the end, so a worker can always read its counters,
+ * but its table is freed as soon as its last block is done.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "../headers/csr.h"
+#include "../headers/csr_arg.h"
+#include "../headers/mmio.h"
+#include "../headers/helpers.h"
+#include "../headers/bench.h"
+#include "../headers/generator.h"
+#include "../headers/verify.h"
+#include "../headers/pool.h"
+
+typedef struct {
+  int index;
+  csr table;
+  csr_arg *slices;
+  int slices_num;
+  uint claimed;
+  uint finished;
+  uint *triangles;
+  double start;
+} pool_job;
+
+typedef struct {
+  char **graphs;
+  int count;
+  int threads;
+  uint large;
+  pool_result *results;
+  uint next;
+  uint remaining;
+  pool_job **jobs;
+  uint reserved;
+} pool_state;
+
+typedef struct {
+  pool_state *state;
+  int id;
+} pool_worker;
+
+
+// One graph per non-empty line. Lines starting with # are comments. NULL if it can't be read.
+char **readManifest(char *path, int *count) {
+  FILE *file = fopen(path, "r");
+  *count = 0;
+  if (file == NULL) {
+    printf("Couldn't read %s\n", path);
+    return NULL;
+  }
+
+  int capacity = 64;
+  char **graphs = (char **) malloc(capacity * sizeof(char *));
+  char line[4096];
+  while (fgets(line, sizeof(line), file) != NULL) {
+    char *start = line;
+    while (*start == ' ' || *start == '\t') {
+      start++;
+    }
+    size_t length = strcspn(start, "\r\n");
+    while (length > 0 && (start[length - 1] == ' ' || start[length - 1] == '\t')) {
+      length--;
+    }
+    if (length == 0 || start[0] == '#') {
+      continue;
+    }
+
+    if (*count == capacity) {
+      capacity *= 2;
+      graphs = (char **) realloc(graphs, capacity * sizeof(char *));
+    }
+    start[length] = '\0';
+    graphs[(*count)++] = strdup(start);
+  }
+
+  fclose(file);
+  return graphs;
+}
+
+
+void freeManifest(char **graphs, int count) {
+  for (int i = 0; i < count; i++) {
+    free(graphs[i]);
+  }
+  free(graphs);
+}
+
+
+// The triangles of the rows from start to end, into triangles[start..end).
+static void countRows(csr table, uint start, uint end, uint *triangles) {
+  if (end <= start) {
+    return;
+  }
+  csr C = hadamardSingleStep(table, start, end);
+  uint *rows = countTriangles(C);
+  memcpy(&triangles[start], rows, (end - start) * sizeof(uint));
+  free(rows);
+  freeCSR(C);
+}
+
+
+static void recordCounts(pool_state *state, int index, uint *triangles, uint size, double countTime) {
+  verify_result summary = summarizeTriangles(triangles, size);
+  state->results[index].triangles = summary.total;
+  state->results[index].checksum = summary.checksum;
+  state->results[index].countTime = countTime;
+  __atomic_sub_fetch(&state->remaining, 1, __ATOMIC_RELEASE);
+}
+
+
+// Takes a block of a published graph, if one is left. The last block records the graph.
+static int helpShared(pool_state *state) {
+  uint reserved = __atomic_load_n(&state->reserved, __ATOMIC_ACQUIRE);
+  for (uint j = 0; j < reserved; j++) {
+    pool_job *job = __atomic_load_n(&state->jobs[j], __ATOMIC_ACQUIRE);
+    if (job == NULL || __atomic_load_n(&job->claimed, __ATOMIC_RELAXED) >= (uint) job->slices_num) {
+      continue;
+    }
+    uint s = __atomic_fetch_add(&job->claimed, 1, __ATOMIC_RELAXED);
+    if (s >= (uint) job->slices_num) {
+      continue;
+    }
+
+    countRows(job->table, job->slices[s].start, job->slices[s].end, job->triangles);
+
+    if (__atomic_add_fetch(&job->finished, 1, __ATOMIC_ACQ_REL) == (uint) job->slices_num) {
+      recordCounts(state, job->index, job->triangles, job->table.size, nowMicros() - job->start);
+      freeThreadArguments(job->slices, job->slices_num);
+      freeCSR(job->table);
+      free(job->triangles);
+    }
+    return 1;
+  }
+  return 0;
+}
+
+
+// Takes the next graph of the list and counts it, or publishes it if it's large.
+static int takeGraph(pool_state *state, int id) {
+  uint index = __atomic_fetch_add(&state->next, 1, __ATOMIC_RELAXED);
+  if (index >= (uint) state->count) {
+    return 0;
+  }
+
+  pool_result *result = &state->results[index];
+  result->worker = id;
+  double start = nowMicros();
+  csr table = loadGraph(state->graphs[index]);
+  result->loadTime = nowMicros() - start;
+
+  if (table.rowIndex == NULL) {
+    __atomic_sub_fetch(&state->remaining, 1, __ATOMIC_RELEASE);
+    return 1;
+  }
+  result->loaded = 1;
+  result->vertices = table.size;
+  result->nonzeros = table.rowIndex[table.size];
+
+  uint *triangles = (uint *) calloc((table.size > 0) ? table.size : 1, sizeof(uint));
+  if (result->nonzeros <= state->large || state->threads == 1) {
+    start = nowMicros();
+    countRows(table, 0, table.size, triangles);
+    recordCounts(state, index, triangles, table.size, nowMicros() - start);
+    free(triangles);
+    freeCSR(table);
+    return 1;
+  }
+
+  pool_job *job = (pool_job *) calloc(1, sizeof(pool_job));
+  job->index = index;
+  job->table = table;
+  job->slices_num = state->threads * POOL_BLOCKS_PER_THREAD;
+  job->slices = makeThreadArguments(table, job->slices_num);
+  job->triangles = triangles;
+  job->start = nowMicros();
+  result->shared = 1;
+
+  uint slot = __atomic_fetch_add(&state->reserved, 1, __ATOMIC_ACQ_REL);
+  __atomic_store_n(&state->jobs[slot], job, __ATOMIC_RELEASE);
+  return 1;
+}
+
+
+static void *poolWorkerVoid(void *arg) {
+  pool_worker *worker = (pool_worker *) arg;
+  pool_state *state = worker->state;
+
+  // The published graphs first, so they don't wait for the small ones.
+  while (__atomic_load_n(&state->remaining, __ATOMIC_ACQUIRE) > 0) {
+    if (helpShared(state) || takeGraph(state, worker->id)) {
+      continue;
+    }
+    // Another worker is still loading a graph, or counting the last blocks of one.
+    sched_yield();
+  }
+  return NULL;
+}
+
+
+pool_result *countGraphs(char **graphs, int count, int threads, uint large) {
+  threads = (threads < 1) ? 1 : threads;
+
+  pool_state state;
+  memset(&state, 0, sizeof(state));
+  state.graphs = graphs;
+  state.count = count;
+  state.threads = threads;
+  state.large = large;
+  state.remaining = count;
+  state.results = (pool_result *) calloc((count > 0) ? count : 1, sizeof(pool_result));
+  state.jobs = (pool_job **) calloc((count > 0) ? count : 1, sizeof(pool_job *));
+  for (int i = 0; i < count; i++) {
+    state.results[i].graph = graphs[i];
+    state.results[i].worker = -1;
+  }
+
+  pthread_t *ids = (pthread_t *) malloc(threads * sizeof(pthread_t));
+  pool_worker *workers = (pool_worker *) malloc(threads * sizeof(pool_worker));
+  for (int i = 0; i < threads; i++) {
+    workers[i].state = &state;
+    workers[i].id = i;
+    pthread_create(&ids[i], NULL, poolWorkerVoid, (void *) &workers[i]);
+  }
+  for (int i = 0; i < threads; i++) {
+    pthread_join(ids[i], NULL);
+  }
+
+  for (uint j = 0; j < state.reserved; j++) {
+    free(state.jobs[j]);
+  }
+  free(state.jobs);
+  free(ids);
+  free(workers);
+  return state.results;
+}
+
+
+// One row per graph, in the order of the list. NA for the graphs that couldn't be read.
+int writePoolResults(char *path, pool_result *results, int count) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    printf("Couldn't write %s\n", path);
+    return 0;
+  }
+
+  fprintf(file, "graph\tmode\tworker\tvertices\tnonzeros\ttriangles\tchecksum\tload_us\tcount_us\n");
+  for (int i = 0; i < count; i++) {
+    pool_result r = results[i];
+    if (!r.loaded) {
+      fprintf(file, "%s\tfailed\t%d\tNA\tNA\tNA\tNA\t%.1f\tNA\n", r.graph, r.worker, r.loadTime);
+      continue;
+    }
+    fprintf(file, "%s\t%s\t%d\t%u\t%u\t%llu\t%016llx\t%.1f\t%.1f\n", r.graph, r.shared ? "pool" : "worker",
+      r.worker, r.vertices, r.nonzeros, r.triangles, r.checksum, r.loadTime, r.countTime);
+  }
+
+  fclose(file);
+  return 1;
+}
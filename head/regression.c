@@ -0,0 +1,196 @@
+/*
+ * regression.c
+ * The comparison of the runs to a baseline. See headers/regression.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../headers/bench.h"
+#include "../headers/regression.h"
+
+static const char *verdict_names[] = {"same", "REGRESSED", "improved", "new", "MISSING"};
+
+typedef struct {
+  double time;
+  int sample;
+} ranked_time;
+
+
+static int compareRanked(const void *a, const void *b) {
+  double x = ((const ranked_time *) a)->time;
+  double y = ((const ranked_time *) b)->time;
+  return (x > y) - (x < y);
+}
+
+
+// The one-sided p value of the Mann-Whitney U test that the times of b tend to be larger
+// than the times of a. Ranks both together (ties get their average rank), then compares
+// the U of b to its normal approximation, with the tie and the continuity corrections.
+double mannWhitneyGreater(double *a, int countA, double *b, int countB) {
+  int total = countA + countB;
+  if (countA == 0 || countB == 0) {
+    return 1;
+  }
+
+  ranked_time *all = (ranked_time *) malloc(total * sizeof(ranked_time));
+  for (int i = 0; i < countA; i++) {
+    all[i].time = a[i];
+    all[i].sample = 0;
+  }
+  for (int i = 0; i < countB; i++) {
+    all[countA + i].time = b[i];
+    all[countA + i].sample = 1;
+  }
+  qsort(all, total, sizeof(ranked_time), compareRanked);
+
+  double ranksB = 0;
+  double ties = 0;
+  for (int i = 0; i < total; ) {
+    int j = i;
+    while (j < total && all[j].time == all[i].time) {
+      j++;
+    }
+
+    // Ranks i + 1 to j are tied.
+    double rank = (i + 1 + j) / 2.0;
+    for (int k = i; k < j; k++) {
+      ranksB += (all[k].sample == 1) ? rank : 0;
+    }
+    double tied = j - i;
+    ties += tied * tied * tied - tied;
+    i = j;
+  }
+  free(all);
+
+  double u = ranksB - countB * (countB + 1) / 2.0;
+  double mean = countA * (double) countB / 2;
+  double variance = countA * (double) countB / 12 * ((total + 1) - ties / (total * (double) (total - 1)));
+  if (variance <= 0) {
+    return 1;
+  }
+
+  double z = (u - mean - 0.5) / sqrt(variance);
+  return 0.5 * erfc(z / sqrt(2));
+}
+
+
+// The run of results that matches run by graph, backend and threads, or NULL.
+static bench_result *findRun(bench_result *results, int count, bench_result *run) {
+  for (int i = 0; i < count; i++) {
+    if (results[i].stats.samples > 0 && results[i].threads == run->threads &&
+      strcmp(results[i].graph, run->graph) == 0 && strcmp(results[i].backend, run->backend) == 0)
+    {
+      return &results[i];
+    }
+  }
+  return NULL;
+}
+
+
+// One row per run that has samples, then one per run of the baseline that wasn't run
+// again. The runs are matched to the baseline by graph, backend and threads. rows needs
+// room for count + baseline_num. Returns the number of rows.
+int compareToBaseline(bench_result *results, int count, bench_result *baseline, int baseline_num,
+  double threshold, regression_row *rows)
+{
+  int rows_num = 0;
+
+  for (int i = 0; i < count; i++) {
+    bench_result *run = &results[i];
+    if (run->stats.samples == 0) {
+      continue;
+    }
+
+    regression_row *row = &rows[rows_num++];
+    row->graph = run->graph;
+    row->backend = run->backend;
+    row->threads = run->threads;
+    row->median = run->stats.median;
+    row->baseline = 0;
+    row->change = 0;
+    row->p = 1;
+    row->verdict = REGRESSION_NEW;
+
+    bench_result *old = findRun(baseline, baseline_num, run);
+    if (old == NULL) {
+      continue;
+    }
+
+    row->baseline = old->stats.median;
+    row->change = (old->stats.median > 0) ? (run->stats.median - old->stats.median) / old->stats.median : 0;
+    row->verdict = REGRESSION_SAME;
+
+    if (row->change >= 0) {
+      row->p = mannWhitneyGreater(old->times, old->stats.samples, run->times, run->stats.samples);
+      row->verdict = (row->change > threshold && row->p < REGRESSION_ALPHA) ? REGRESSION_REGRESSED : REGRESSION_SAME;
+    } else {
+      row->p = mannWhitneyGreater(run->times, run->stats.samples, old->times, old->stats.samples);
+      row->verdict = (-row->change > threshold && row->p < REGRESSION_ALPHA) ? REGRESSION_IMPROVED : REGRESSION_SAME;
+    }
+  }
+
+  for (int j = 0; j < baseline_num; j++) {
+    bench_result *old = &baseline[j];
+    if (old->stats.samples == 0 || findRun(results, count, old) != NULL) {
+      continue;
+    }
+
+    regression_row *row = &rows[rows_num++];
+    row->graph = old->graph;
+    row->backend = old->backend;
+    row->threads = old->threads;
+    row->baseline = old->stats.median;
+    row->median = 0;
+    row->change = 0;
+    row->p = 1;
+    row->verdict = REGRESSION_MISSING;
+  }
+
+  return rows_num;
+}
+
+
+void printRegressions(regression_row *rows, int count) {
+  printf("\n%-16s %-14s %8s %14s %12s %9s %10s %s\n", "graph", "backend", "threads", "baseline(us)",
+    "median(us)", "change", "p", "verdict");
+
+  for (int i = 0; i < count; i++) {
+    regression_row r = rows[i];
+    if (r.verdict == REGRESSION_NEW) {
+      printf("%-16s %-14s %8d %14s %12.0f %9s %10s %s\n", r.graph, r.backend, r.threads, "-",
+        r.median, "-", "-", verdict_names[r.verdict]);
+    } else if (r.verdict == REGRESSION_MISSING) {
+      printf("%-16s %-14s %8d %14.0f %12s %9s %10s %s\n", r.graph, r.backend, r.threads, r.baseline,
+        "-", "-", "-", verdict_names[r.verdict]);
+    } else {
+      printf("%-16s %-14s %8d %14.0f %12.0f %+8.1f%% %10.2g %s\n", r.graph, r.backend, r.threads,
+        r.baseline, r.median, r.change * 100, r.p, verdict_names[r.verdict]);
+    }
+  }
+  printf("\n");
+}
+
+
+// Tab separated, one row per run, with the same metadata columns as the results file.
+void writeRegressionCSV(char *path, regression_row *rows, int count, bench_meta meta) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    printf("Couldn't write %s\n", path);
+    return;
+  }
+
+  fprintf(file, "graph\tbackend\tthreads\tbaseline_median_us\tmedian_us\tchange\tp\tverdict"
+    "\thost\tcompiler\tflags\tdate\n");
+
+  for (int i = 0; i < count; i++) {
+    regression_row r = rows[i];
+    fprintf(file, "%s\t%s\t%d\t%.1f\t%.1f\t%.4f\t%.3g\t%s\t%s\t%s\t%s\t%s\n", r.graph, r.backend,
+      r.threads, r.baseline, r.median, r.change, r.p, verdict_names[r.verdict],
+      meta.host, meta.compiler, meta.flags, meta.date);
+  }
+
+  fclose(file);
+}
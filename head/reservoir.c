@@ -0,0 +1,543 @@
+/*
+ * reservoir.c
+ * TRIEST-IMPR over an edge stream, sharded by vertex colors. See headers/reservoir.h.
+ *
+ * Every shard keeps the edges of its reservoir in an array, to evict a random one, and
+ * the neighbors of every vertex of the sample in a sorted block, to intersect N(u) and
+ * N(v) by merging. The vertices of the sample are packed entries, found through an open
+ * addressing map with linear probing, both sized up front for two vertices per edge.
+ * A shard is only ever touched by its own thread.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#include "../headers/csr.h"
+#include "../headers/mmio.h"
+#include "../headers/helpers.h"
+#include "../headers/bench.h"
+#include "../headers/generator.h"
+#include "../headers/sampling.h"
+#include "../headers/reservoir.h"
+
+#define STREAM_MTX 0
+#define STREAM_EDGES 1
+#define STREAM_TABLE 2
+
+#define NO_ENTRY UINT_MAX
+
+typedef struct {
+  int kind;
+  FILE *file;
+  long remaining;
+  csr table;
+  uint row;
+  uint position;
+} edge_stream;
+
+typedef struct {
+  unsigned long long capacity;
+  unsigned long long seen;
+  unsigned long long stored;
+  uint *sampleU;
+  uint *sampleV;
+  // The vertices of the sample: vertex[e] has degree[e] neighbors, sorted, in a block of
+  // blockSize[e], and the estimate local[e].
+  uint count;
+  uint *vertex;
+  uint **neighbors;
+  uint *degree;
+  uint *blockSize;
+  double *local;
+  // The map from a vertex to its entry + 1, 0 in the empty slots.
+  uint *slots;
+  uint mask;
+  int shift;
+  // The largest estimates of the vertices that left the sample, largest first.
+  uint top;
+  uint retired;
+  uint *retiredVertex;
+  double *retiredLocal;
+  double global;
+  unsigned long long seed;
+} reservoir;
+
+
+// Opens the stream of a .mtx file, an edge list, or the table of a snapshot or a spec.
+static int openStream(char *path, edge_stream *stream) {
+  memset(stream, 0, sizeof(edge_stream));
+
+  if (isGraphSpec(path) || isSnapshot(path)) {
+    stream->kind = STREAM_TABLE;
+    stream->table = loadGraph(path);
+    return stream->table.rowIndex != NULL;
+  }
+
+  stream->file = fopen(path, "r");
+  if (stream->file == NULL) {
+    printf("Couldn't read %s\n", path);
+    return 0;
+  }
+
+  char *extension = strrchr(path, '.');
+  if (extension == NULL || strcmp(extension, ".mtx") != 0) {
+    stream->kind = STREAM_EDGES;
+    return 1;
+  }
+
+  MM_typecode t;
+  int M, N, nz;
+  if (mm_read_banner(stream->file, &t) != 0 || mm_read_mtx_crd_size(stream->file, &M, &N, &nz) != 0 || M != N) {
+    printf("Error. Couldn't process the .mtx file!");
+    fclose(stream->file);
+    return 0;
+  }
+  stream->kind = STREAM_MTX;
+  stream->remaining = nz;
+  return 1;
+}
+
+
+// Reads up to max edges into u and v. Returns how many were read, 0 at the end.
+static uint readEdges(edge_stream *stream, uint *u, uint *v, uint max) {
+  uint count = 0;
+
+  if (stream->kind == STREAM_TABLE) {
+    // Every edge once, from its smaller end.
+    csr table = stream->table;
+    while (count < max && stream->row < table.size) {
+      if (stream->position >= table.rowIndex[stream->row + 1]) {
+        stream->row++;
+        continue;
+      }
+      uint column = table.colIndex[stream->position++];
+      if (column > stream->row) {
+        u[count] = stream->row;
+        v[count++] = column;
+      }
+    }
+    return count;
+  }
+
+  if (stream->kind == STREAM_MTX) {
+    while (count < max && stream->remaining > 0) {
+      int row, col;
+      if (fscanf(stream->file, "%d %d%*[^\n]", &row, &col) != 2) {
+        stream->remaining = 0;
+        break;
+      }
+      stream->remaining--;
+      // Decrease the values since Matlab is 1-index based.
+      u[count] = row - 1;
+      v[count++] = col - 1;
+    }
+    return count;
+  }
+
+  char line[256];
+  while (count < max && fgets(line, sizeof(line), stream->file) != NULL) {
+    if (line[0] == '#' || line[0] == '%' || sscanf(line, "%u %u", &u[count], &v[count]) != 2) {
+      continue;
+    }
+    count++;
+  }
+  return count;
+}
+
+
+static void closeStream(edge_stream *stream) {
+  if (stream->kind == STREAM_TABLE) {
+    freeCSR(stream->table);
+  } else {
+    fclose(stream->file);
+  }
+}
+
+
+// Fibonacci hashing: the top bits of the product.
+static uint homeSlot(reservoir *r, uint vertex) {
+  return (uint) ((vertex * 0x9E3779B97F4A7C15ULL) >> r->shift);
+}
+
+
+// The slot of vertex, or the empty slot where it would go.
+static uint findSlot(reservoir *r, uint vertex) {
+  uint slot = homeSlot(r, vertex);
+  while (r->slots[slot] != 0 && r->vertex[r->slots[slot] - 1] != vertex) {
+    slot = (slot + 1) & r->mask;
+  }
+  return slot;
+}
+
+
+static uint findEntry(reservoir *r, uint vertex) {
+  uint slot = findSlot(r, vertex);
+  return (r->slots[slot] != 0) ? r->slots[slot] - 1 : NO_ENTRY;
+}
+
+
+// The entry of vertex, added without neighbors if it isn't in the sample.
+static uint addEntry(reservoir *r, uint vertex) {
+  uint slot = findSlot(r, vertex);
+  if (r->slots[slot] != 0) {
+    return r->slots[slot] - 1;
+  }
+
+  uint entry = r->count++;
+  r->slots[slot] = entry + 1;
+  r->vertex[entry] = vertex;
+  r->neighbors[entry] = NULL;
+  r->degree[entry] = 0;
+  r->blockSize[entry] = 0;
+  r->local[entry] = 0;
+  return entry;
+}
+
+
+// Empties a slot, and moves back into it the slots after it that probed past it, so
+// that every vertex stays reachable from its home slot.
+static void clearSlot(reservoir *r, uint hole) {
+  for (uint next = (hole + 1) & r->mask; r->slots[next] != 0; next = (next + 1) & r->mask) {
+    uint home = homeSlot(r, r->vertex[r->slots[next] - 1]);
+    if (((next - home) & r->mask) >= ((next - hole) & r->mask)) {
+      r->slots[hole] = r->slots[next];
+      hole = next;
+    }
+  }
+  r->slots[hole] = 0;
+}
+
+
+// Keeps the estimate of a vertex that left the sample if it's among the top ones, added
+// to what it had if it left before.
+static void retire(reservoir *r, uint vertex, double local) {
+  if (local <= 0 || r->top == 0) {
+    return;
+  }
+
+  uint i = 0;
+  while (i < r->retired && r->retiredVertex[i] != vertex) {
+    i++;
+  }
+  if (i < r->retired) {
+    local += r->retiredLocal[i];
+  } else if (r->retired < r->top) {
+    i = r->retired++;
+  } else if (local > r->retiredLocal[r->top - 1]) {
+    i = r->top - 1;
+  } else {
+    return;
+  }
+
+  while (i > 0 && r->retiredLocal[i - 1] < local) {
+    r->retiredVertex[i] = r->retiredVertex[i - 1];
+    r->retiredLocal[i] = r->retiredLocal[i - 1];
+    i--;
+  }
+  r->retiredVertex[i] = vertex;
+  r->retiredLocal[i] = local;
+}
+
+
+static double retiredEstimate(reservoir *r, uint vertex) {
+  for (uint i = 0; i < r->retired; i++) {
+    if (r->retiredVertex[i] == vertex) {
+      return r->retiredLocal[i];
+    }
+  }
+  return 0;
+}
+
+
+// Drops a vertex that has no neighbors left in the sample. The last entry takes its
+// place, so that the entries stay packed.
+static void removeEntry(reservoir *r, uint entry) {
+  retire(r, r->vertex[entry], r->local[entry]);
+  free(r->neighbors[entry]);
+  clearSlot(r, findSlot(r, r->vertex[entry]));
+
+  uint last = --r->count;
+  if (entry != last) {
+    r->slots[findSlot(r, r->vertex[last])] = entry + 1;
+    r->vertex[entry] = r->vertex[last];
+    r->neighbors[entry] = r->neighbors[last];
+    r->degree[entry] = r->degree[last];
+    r->blockSize[entry] = r->blockSize[last];
+    r->local[entry] = r->local[last];
+  }
+}
+
+
+// The position of the first neighbor of the entry that isn't below value.
+static uint findNeighbor(reservoir *r, uint entry, uint value) {
+  uint *block = r->neighbors[entry];
+  uint low = 0, high = r->degree[entry];
+  while (low < high) {
+    uint middle = low + (high - low) / 2;
+    if (block[middle] < value) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low;
+}
+
+
+static void insertNeighbor(reservoir *r, uint vertex, uint value) {
+  uint entry = addEntry(r, vertex);
+  if (r->degree[entry] == r->blockSize[entry]) {
+    r->blockSize[entry] = (r->blockSize[entry] > 0) ? 2 * r->blockSize[entry] : 2;
+    r->neighbors[entry] = (uint *) realloc(r->neighbors[entry], r->blockSize[entry] * sizeof(uint));
+  }
+
+  uint position = findNeighbor(r, entry, value);
+  uint *block = r->neighbors[entry];
+  memmove(&block[position + 1], &block[position], (r->degree[entry] - position) * sizeof(uint));
+  block[position] = value;
+  r->degree[entry]++;
+}
+
+
+// The blocks halve when less than half full, so they are never more than twice their neighbors.
+static void removeNeighbor(reservoir *r, uint vertex, uint value) {
+  uint entry = findEntry(r, vertex);
+  uint position = findNeighbor(r, entry, value);
+  uint *block = r->neighbors[entry];
+  memmove(&block[position], &block[position + 1], (r->degree[entry] - position - 1) * sizeof(uint));
+  r->degree[entry]--;
+
+  if (r->degree[entry] == 0) {
+    removeEntry(r, entry);
+  } else if (r->degree[entry] < r->blockSize[entry] / 2) {
+    r->blockSize[entry] /= 2;
+    r->neighbors[entry] = (uint *) realloc(block, r->blockSize[entry] * sizeof(uint));
+  }
+}
+
+
+static int sampled(reservoir *r, uint u, uint v) {
+  uint eu = findEntry(r, u), ev = findEntry(r, v);
+  if (eu == NO_ENTRY || ev == NO_ENTRY) {
+    return 0;
+  }
+
+  uint entry = (r->degree[eu] < r->degree[ev]) ? eu : ev;
+  uint other = (entry == eu) ? v : u;
+  uint position = findNeighbor(r, entry, other);
+  return position < r->degree[entry] && r->neighbors[entry][position] == other;
+}
+
+
+// One edge of the stream: its triangles in the sample, then maybe into the sample.
+// Self loops and edges that are in the sample already are skipped.
+static void streamEdge(reservoir *r, uint u, uint v) {
+  if (u == v || sampled(r, u, v)) {
+    return;
+  }
+
+  unsigned long long t = ++r->seen;
+  double capacity = r->capacity;
+  double weight = ((double) (t - 1) * (t - 2)) / (capacity * (capacity - 1));
+  weight = (weight > 1) ? weight : 1;
+
+  // Without an entry, an end has no neighbors in the sample, so the edge closes nothing.
+  uint eu = findEntry(r, u), ev = findEntry(r, v);
+  uint *a = (eu != NO_ENTRY) ? r->neighbors[eu] : NULL, *b = (ev != NO_ENTRY) ? r->neighbors[ev] : NULL;
+  uint sizeA = (eu != NO_ENTRY) ? r->degree[eu] : 0, sizeB = (ev != NO_ENTRY) ? r->degree[ev] : 0;
+  uint i = 0, j = 0;
+  while (i < sizeA && j < sizeB) {
+    if (a[i] == b[j]) {
+      r->global += weight;
+      r->local[eu] += weight;
+      r->local[ev] += weight;
+      r->local[findEntry(r, a[i])] += weight;
+      i++;
+      j++;
+    } else if (a[i] < b[j]) {
+      i++;
+    } else {
+      j++;
+    }
+  }
+
+  unsigned long long slot = r->stored;
+  if (r->stored == r->capacity) {
+    // Kept with probability capacity / t, in place of a random edge of the sample.
+    if ((splitmix64(r->seed, 2 * t) >> 11) * (1.0 / 9007199254740992.0) >= capacity / t) {
+      return;
+    }
+    slot = splitmix64(r->seed, 2 * t + 1) % r->capacity;
+    removeNeighbor(r, r->sampleU[slot], r->sampleV[slot]);
+    removeNeighbor(r, r->sampleV[slot], r->sampleU[slot]);
+  } else {
+    r->stored++;
+  }
+
+  r->sampleU[slot] = u;
+  r->sampleV[slot] = v;
+  insertNeighbor(r, u, v);
+  insertNeighbor(r, v, u);
+}
+
+
+// The sample and the map for capacity edges, and the estimates of top retired vertices.
+static void makeReservoir(reservoir *r, unsigned long long capacity, uint top, unsigned long long seed) {
+  memset(r, 0, sizeof(reservoir));
+  r->capacity = capacity;
+  r->seed = seed;
+  r->sampleU = (uint *) malloc(capacity * sizeof(uint));
+  r->sampleV = (uint *) malloc(capacity * sizeof(uint));
+
+  // Every edge brings at most two vertices, and the map is at most half full.
+  unsigned long long entries = 2 * capacity;
+  unsigned long long slots = 2;
+  r->shift = 63;
+  while (slots < 2 * entries) {
+    slots *= 2;
+    r->shift--;
+  }
+  r->vertex = (uint *) malloc(entries * sizeof(uint));
+  r->neighbors = (uint **) malloc(entries * sizeof(uint *));
+  r->degree = (uint *) malloc(entries * sizeof(uint));
+  r->blockSize = (uint *) malloc(entries * sizeof(uint));
+  r->local = (double *) malloc(entries * sizeof(double));
+  r->slots = (uint *) calloc(slots, sizeof(uint));
+  r->mask = (uint) (slots - 1);
+
+  r->top = top;
+  r->retiredVertex = (uint *) malloc((top + 1) * sizeof(uint));
+  r->retiredLocal = (double *) malloc((top + 1) * sizeof(double));
+}
+
+
+static void freeReservoir(reservoir *r) {
+  for (uint i = 0; i < r->count; i++) {
+    free(r->neighbors[i]);
+  }
+  free(r->vertex);
+  free(r->neighbors);
+  free(r->degree);
+  free(r->blockSize);
+  free(r->local);
+  free(r->slots);
+  free(r->retiredVertex);
+  free(r->retiredLocal);
+  free(r->sampleU);
+  free(r->sampleV);
+}
+
+
+// Puts a vertex among the top ones of the result if its estimate is large enough.
+static void rankVertex(sample_result *result, uint top, uint vertex, double local, unsigned long long edges) {
+  if (local <= 0 || (result->top == top && (top == 0 || local <= result->vertex[top - 1].estimate))) {
+    return;
+  }
+
+  uint i = (result->top < top) ? result->top++ : top - 1;
+  while (i > 0 && result->vertex[i - 1].estimate < local) {
+    result->vertices[i] = result->vertices[i - 1];
+    result->vertex[i] = result->vertex[i - 1];
+    i--;
+  }
+  sample_estimate estimate = {local, NAN, NAN, edges};
+  result->vertices[i] = vertex;
+  result->vertex[i] = estimate;
+}
+
+
+static uint colorOf(unsigned long long seed, uint vertex, int shards) {
+  return (shards > 1) ? splitmix64(seed, vertex) % shards : 0;
+}
+
+
+sample_result estimateStream(char *path, sample_options options) {
+  double start = nowMicros();
+  sample_result result;
+  memset(&result, 0, sizeof(result));
+  int shards = (options.threads < 1) ? 1 : options.threads;
+
+  edge_stream stream;
+  if (!openStream(path, &stream)) {
+    result.total.estimate = NAN;
+    return result;
+  }
+
+  // An equal part of the memory for every shard, and at least 2 edges, for the weights.
+  unsigned long long capacity = (unsigned long long) (options.memory / RESERVOIR_EDGE_BYTES / shards);
+  capacity = (capacity < 2) ? 2 : capacity;
+  unsigned long long colors = splitmix64(options.seed, ~0ULL);
+
+  reservoir *reservoirs = (reservoir *) malloc(shards * sizeof(reservoir));
+  for (int s = 0; s < shards; s++) {
+    makeReservoir(&reservoirs[s], capacity, options.top, splitmix64(options.seed, s));
+  }
+
+  uint *u = (uint *) malloc(RESERVOIR_CHUNK * sizeof(uint));
+  uint *v = (uint *) malloc(RESERVOIR_CHUNK * sizeof(uint));
+  int *shardOf = (int *) malloc(RESERVOIR_CHUNK * sizeof(int));
+  unsigned long long edges = 0;
+  uint count;
+
+  while ((count = readEdges(&stream, u, v, RESERVOIR_CHUNK)) > 0) {
+    // The shard of every edge of the chunk, -1 when its ends have different colors.
+    #pragma omp parallel for schedule(static) num_threads(shards)
+    for (uint i = 0; i < count; i++) {
+      uint color = colorOf(colors, u[i], shards);
+      shardOf[i] = (color == colorOf(colors, v[i], shards)) ? (int) color : -1;
+    }
+
+    #pragma omp parallel for schedule(static, 1) num_threads(shards)
+    for (int s = 0; s < shards; s++) {
+      for (uint i = 0; i < count; i++) {
+        if (shardOf[i] == s) {
+          streamEdge(&reservoirs[s], u[i], v[i]);
+        }
+      }
+    }
+    edges += count;
+  }
+  closeStream(&stream);
+
+  // A triangle is in a shard with probability 1 / shards^2.
+  double scale = (double) shards * shards;
+  double global = 0;
+  for (int s = 0; s < shards; s++) {
+    global += reservoirs[s].global;
+  }
+  sample_estimate total = {global * scale, NAN, NAN, edges};
+  result.total = total;
+
+  // The vertices with the most triangles. Each one is only in the shard of its color: in
+  // its sample, with what it had when it left it before, or retired.
+  result.vertices = (uint *) malloc((options.top + 1) * sizeof(uint));
+  result.vertex = (sample_estimate *) calloc(options.top + 1, sizeof(sample_estimate));
+  for (int s = 0; s < shards; s++) {
+    reservoir *r = &reservoirs[s];
+    for (uint e = 0; e < r->count; e++) {
+      double local = r->local[e] + retiredEstimate(r, r->vertex[e]);
+      rankVertex(&result, options.top, r->vertex[e], local * scale, edges);
+    }
+    for (uint i = 0; i < r->retired; i++) {
+      if (findEntry(r, r->retiredVertex[i]) == NO_ENTRY) {
+        rankVertex(&result, options.top, r->retiredVertex[i], r->retiredLocal[i] * scale, edges);
+      }
+    }
+  }
+
+  for (int s = 0; s < shards; s++) {
+    freeReservoir(&reservoirs[s]);
+  }
+  free(reservoirs);
+  free(u);
+  free(v);
+  free(shardOf);
+
+  result.rounds = 1;
+  result.converged = 1;
+  result.time = nowMicros() - start;
+  return result;
+}
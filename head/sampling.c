@@ -0,0 +1,499 @@
+/*
+ * sampling.c
+ * DOULION and wedge sampling. See headers/sampling.h.
+ *
+ * The exact counts, of the whole graph and of the sparse ones, go over every edge u < v
+ * once and intersect the parts of both rows above v, so each triangle u < v < w is
+ * found once, and self loops never are.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../headers/csr.h"
+#include "../headers/bench.h"
+#include "../headers/generator.h"
+#include "../headers/intersect.h"
+#include "../headers/sampling.h"
+
+// The 0.975 quantiles of Student's t, by degrees of freedom. SAMPLE_Z from 31 on.
+static const double student[31] = {
+  0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+  2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+  2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+// Wedges of every top vertex in its first round.
+#define SAMPLE_FIRST_VERTEX_WEDGES 4096
+
+
+sample_options defaultSampleOptions() {
+  sample_options options;
+  options.method = SAMPLE_WEDGE;
+  options.error = 0.01;
+  options.budget = 0;
+  options.probability = 0.1;
+  options.top = 0;
+  options.seed = 1;
+  options.threads = 1;
+  options.memory = 64 * 1048576.0;
+  return options;
+}
+
+
+// SAMPLE_DOULION, SAMPLE_WEDGE or SAMPLE_TRIEST. -1 for anything else.
+int parseSampleMethod(char *name) {
+  if (strcmp(name, "doulion") == 0) {
+    return SAMPLE_DOULION;
+  }
+  if (strcmp(name, "wedge") == 0) {
+    return SAMPLE_WEDGE;
+  }
+  if (strcmp(name, "triest") == 0) {
+    return SAMPLE_TRIEST;
+  }
+  return -1;
+}
+
+
+const char *sampleMethodName(int method) {
+  return (method == SAMPLE_DOULION) ? "doulion" : (method == SAMPLE_TRIEST) ? "triest" : "wedge";
+}
+
+
+// A uniform number in [0, 1).
+static double uniformDraw(unsigned long long seed, unsigned long long i) {
+  return (splitmix64(seed, i) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
+static int hasColumn(csr table, uint row, uint column) {
+  uint position = firstAbove(table, row, column);
+  return position > table.rowIndex[row] && table.colIndex[position - 1] == column;
+}
+
+
+// The number of neighbors of a vertex, without its self loop.
+static uint degreeOf(csr table, uint vertex) {
+  return table.rowIndex[vertex + 1] - table.rowIndex[vertex] - hasColumn(table, vertex, vertex);
+}
+
+
+// Every triangle u < v < w, once. The triangles of every vertex are added to triangles
+// when it isn't NULL, and only the total is counted otherwise, with the intersection kernels.
+static unsigned long long countOriented(csr table, int threads, uint *triangles) {
+  uint size = table.size;
+  uint *above = (uint *) malloc(((size > 0) ? size : 1) * sizeof(uint));
+  unsigned long long total = 0;
+
+  #pragma omp parallel for schedule(dynamic, 256) num_threads(threads)
+  for (uint v = 0; v < size; v++) {
+    above[v] = firstAbove(table, v, v);
+  }
+
+  #pragma omp parallel for schedule(dynamic, 64) num_threads(threads) reduction(+:total)
+  for (uint u = 0; u < size; u++) {
+    uint end = table.rowIndex[u + 1];
+
+    for (uint k = above[u]; k < end; k++) {
+      uint v = table.colIndex[k];
+      uint *a = &table.colIndex[k + 1];
+      uint sizeA = end - k - 1;
+      uint *b = &table.colIndex[above[v]];
+      uint sizeB = table.rowIndex[v + 1] - above[v];
+
+      if (triangles == NULL) {
+        total += intersectAdaptive(a, sizeA, b, sizeB);
+        continue;
+      }
+
+      uint i = 0, j = 0;
+      while (i < sizeA && j < sizeB) {
+        if (a[i] == b[j]) {
+          __atomic_add_fetch(&triangles[u], 1, __ATOMIC_RELAXED);
+          __atomic_add_fetch(&triangles[v], 1, __ATOMIC_RELAXED);
+          __atomic_add_fetch(&triangles[a[i]], 1, __ATOMIC_RELAXED);
+          total++;
+          i++;
+          j++;
+        } else if (a[i] < b[j]) {
+          i++;
+        } else {
+          j++;
+        }
+      }
+    }
+  }
+
+  free(above);
+  return total;
+}
+
+
+// The true number of triangles, without the self loops, and those of every vertex into
+// triangles when it isn't NULL. The backends count (A .* A^2) / 2, which differs on
+// graphs with self loops.
+unsigned long long exactTriangles(csr table, int threads, uint *triangles) {
+  if (triangles != NULL) {
+    memset(triangles, 0, table.size * sizeof(uint));
+  }
+  return countOriented(table, threads, triangles);
+}
+
+
+// Keeps every edge with probability p, in both of its rows, without the self loops.
+// Only the row and column arrays are allocated.
+static csr sparsify(csr table, double p, unsigned long long seed, int threads) {
+  uint size = table.size;
+  uint *rowIndex = (uint *) calloc(size + 1, sizeof(uint));
+
+  // 1. How many of every row are kept. Both ends of an edge draw the same number.
+  #pragma omp parallel for schedule(dynamic, 256) num_threads(threads)
+  for (uint u = 0; u < size; u++) {
+    uint kept = 0;
+    for (uint i = table.rowIndex[u]; i < table.rowIndex[u + 1]; i++) {
+      uint v = table.colIndex[i];
+      unsigned long long key = (u < v) ? ((unsigned long long) u << 32) | v : ((unsigned long long) v << 32) | u;
+      kept += (u != v && uniformDraw(seed, key) < p);
+    }
+    rowIndex[u + 1] = kept;
+  }
+
+  for (uint u = 0; u < size; u++) {
+    rowIndex[u + 1] += rowIndex[u];
+  }
+
+  // 2. The kept columns, still sorted.
+  uint *colIndex = (uint *) malloc(((rowIndex[size] > 0) ? rowIndex[size] : 1) * sizeof(uint));
+  #pragma omp parallel for schedule(dynamic, 256) num_threads(threads)
+  for (uint u = 0; u < size; u++) {
+    uint position = rowIndex[u];
+    for (uint i = table.rowIndex[u]; i < table.rowIndex[u + 1]; i++) {
+      uint v = table.colIndex[i];
+      unsigned long long key = (u < v) ? ((unsigned long long) u << 32) | v : ((unsigned long long) v << 32) | u;
+      if (u != v && uniformDraw(seed, key) < p) {
+        colIndex[position++] = v;
+      }
+    }
+  }
+
+  csr sparse = {size, NULL, colIndex, rowIndex};
+  return sparse;
+}
+
+
+// The top vertices of highest degree, highest first. Returns how many there are.
+static uint topVertices(csr table, uint top, uint *vertices) {
+  uint found = 0;
+  for (uint v = 0; v < table.size; v++) {
+    uint degree = table.rowIndex[v + 1] - table.rowIndex[v];
+    if (found == top && (top == 0 ||
+      degree <= table.rowIndex[vertices[top - 1] + 1] - table.rowIndex[vertices[top - 1]])) {
+      continue;
+    }
+
+    // Insertion into the sorted list, that drops its last one when it's full.
+    uint i = (found < top) ? found++ : top - 1;
+    while (i > 0 && table.rowIndex[vertices[i - 1] + 1] - table.rowIndex[vertices[i - 1]] < degree) {
+      vertices[i] = vertices[i - 1];
+      i--;
+    }
+    vertices[i] = v;
+  }
+  return found;
+}
+
+
+// The mean of the replicas and its interval, from their spread.
+static sample_estimate replicaEstimate(double sum, double squares, unsigned long long count) {
+  sample_estimate result = {0, 0, 0, count};
+  if (count == 0) {
+    return result;
+  }
+
+  double mean = sum / count;
+  double variance = (count > 1) ? (squares - sum * mean) / (count - 1) : 0;
+  double t = (count - 1 < 31) ? student[count - 1] : SAMPLE_Z;
+  double half = (count > 1) ? t * sqrt((variance > 0) ? variance / count : 0) : INFINITY;
+
+  result.estimate = mean;
+  result.low = (mean - half > 0) ? mean - half : 0;
+  result.high = mean + half;
+  return result;
+}
+
+
+// Wilson's interval of closed / drawn, scaled to triangles by scale.
+static sample_estimate wilsonEstimate(unsigned long long closed, unsigned long long drawn, double scale) {
+  sample_estimate result = {0, 0, 0, drawn};
+  if (drawn == 0) {
+    result.high = scale;
+    return result;
+  }
+
+  double n = drawn;
+  double p = closed / n;
+  double z2 = SAMPLE_Z * SAMPLE_Z;
+  double center = (p + z2 / (2 * n)) / (1 + z2 / n);
+  double half = SAMPLE_Z / (1 + z2 / n) * sqrt(p * (1 - p) / n + z2 / (4 * n * n));
+
+  result.estimate = p * scale;
+  result.low = ((center - half > 0) ? center - half : 0) * scale;
+  result.high = ((center + half < 1) ? center + half : 1) * scale;
+  return result;
+}
+
+
+static int precise(sample_estimate e, double error) {
+  return (e.high - e.low) / 2 <= error * e.estimate;
+}
+
+
+// The half width of the interval as a fraction of the estimate. 0 for an exact 0.
+static double relativeError(sample_estimate e) {
+  if (e.estimate > 0) {
+    return (e.high - e.low) / 2 / e.estimate;
+  }
+  return (e.high > 0) ? INFINITY : 0;
+}
+
+
+// About how long the exact count takes, in us. A pass over the edges u < v adds up
+// min(degree(u), degree(v)), the length of their intersection at most, and times itself:
+// the exact count takes that many steps per edge for the one step of the pass.
+static double exactCost(csr table, int threads) {
+  double start = nowMicros();
+  uint size = table.size;
+  unsigned long long edges = 0, work = 0;
+
+  #pragma omp parallel for schedule(dynamic, 256) num_threads(threads) reduction(+:edges, work)
+  for (uint u = 0; u < size; u++) {
+    uint degreeU = table.rowIndex[u + 1] - table.rowIndex[u];
+    for (uint k = table.rowIndex[u]; k < table.rowIndex[u + 1]; k++) {
+      uint v = table.colIndex[k];
+      if (v > u) {
+        uint degreeV = table.rowIndex[v + 1] - table.rowIndex[v];
+        work += (degreeU < degreeV) ? degreeU : degreeV;
+        edges++;
+      }
+    }
+  }
+
+  double pass = nowMicros() - start;
+  return (edges > 0) ? pass * (edges + work) / edges : pass;
+}
+
+
+// Whether another round, that takes about as long as every round so far, still fits.
+static int withinBudget(sample_options options, double start) {
+  return options.budget <= 0 || 2 * (nowMicros() - start) <= options.budget;
+}
+
+
+static sample_result estimateDoulion(csr table, sample_options options, sample_result result, double start) {
+  uint size = table.size;
+  double scale = 1 / (options.probability * options.probability * options.probability);
+  double sum = 0, squares = 0;
+  double *vertexSum = (double *) calloc(result.top + 1, sizeof(double));
+  double *vertexSquares = (double *) calloc(result.top + 1, sizeof(double));
+  uint *triangles = (result.top > 0) ? (uint *) malloc(size * sizeof(uint)) : NULL;
+  unsigned long long replicas = 0;
+
+  for (int round = 0; round < SAMPLE_MAX_ROUNDS; round++) {
+    unsigned long long count = (round == 0) ? SAMPLE_MIN_REPLICAS : replicas;
+
+    for (unsigned long long r = replicas; r < replicas + count; r++) {
+      csr sparse = sparsify(table, options.probability, splitmix64(options.seed, r), options.threads);
+      if (triangles != NULL) {
+        memset(triangles, 0, size * sizeof(uint));
+      }
+      double estimate = countOriented(sparse, options.threads, triangles) * scale;
+      sum += estimate;
+      squares += estimate * estimate;
+
+      for (uint i = 0; i < result.top; i++) {
+        double vertex = triangles[result.vertices[i]] * scale;
+        vertexSum[i] += vertex;
+        vertexSquares[i] += vertex * vertex;
+      }
+      free(sparse.colIndex);
+      free(sparse.rowIndex);
+    }
+    replicas += count;
+    result.rounds = round + 1;
+
+    result.total = replicaEstimate(sum, squares, replicas);
+    int converged = precise(result.total, options.error);
+    for (uint i = 0; i < result.top; i++) {
+      result.vertex[i] = replicaEstimate(vertexSum[i], vertexSquares[i], replicas);
+      converged = converged && precise(result.vertex[i], options.error);
+    }
+
+    if (converged) {
+      result.converged = 1;
+      break;
+    }
+    if (!withinBudget(options, start)) {
+      break;
+    }
+  }
+
+  free(triangles);
+  free(vertexSum);
+  free(vertexSquares);
+  return result;
+}
+
+
+// The closed wedges of count draws, from first on, centered on vertices picked by their
+// number of wedges, or all on center when it isn't -1.
+static unsigned long long drawWedges(csr table, unsigned long long *cumulative, long center,
+  unsigned long long seed, unsigned long long first, unsigned long long count, int threads)
+{
+  unsigned long long closed = 0;
+  unsigned long long wedges = (center < 0) ? cumulative[table.size] : 0;
+
+  #pragma omp parallel for schedule(static) num_threads(threads) reduction(+:closed)
+  for (unsigned long long s = first; s < first + count; s++) {
+    uint v = (uint) center;
+    if (center < 0) {
+      // The first vertex whose cumulative wedges exceed the draw.
+      unsigned long long target = splitmix64(seed, 3 * s) % wedges;
+      uint low = 0, high = table.size;
+      while (low < high) {
+        uint middle = low + (high - low) / 2;
+        if (cumulative[middle + 1] <= target) {
+          low = middle + 1;
+        } else {
+          high = middle;
+        }
+      }
+      v = low;
+    }
+
+    // Two different neighbors, skipping over the self loop.
+    uint start = table.rowIndex[v];
+    uint degree = table.rowIndex[v + 1] - start;
+    uint self = firstAbove(table, v, v);
+    int loop = self > start && table.colIndex[self - 1] == v;
+    degree -= loop;
+
+    uint i = splitmix64(seed, 3 * s + 1) % degree;
+    uint j = splitmix64(seed, 3 * s + 2) % (degree - 1);
+    j += (j >= i);
+    i += (loop && start + i >= self - 1);
+    j += (loop && start + j >= self - 1);
+
+    uint a = table.colIndex[start + i], b = table.colIndex[start + j];
+    uint shorter = (table.rowIndex[a + 1] - table.rowIndex[a] < table.rowIndex[b + 1] - table.rowIndex[b]) ? a : b;
+    closed += hasColumn(table, shorter, (shorter == a) ? b : a);
+  }
+
+  return closed;
+}
+
+
+static sample_result estimateWedges(csr table, sample_options options, sample_result result, double start) {
+  uint size = table.size;
+
+  // The wedges of every vertex, C(degree, 2), added up.
+  unsigned long long *cumulative = (unsigned long long *) malloc((size + 1) * sizeof(unsigned long long));
+  cumulative[0] = 0;
+  #pragma omp parallel for schedule(dynamic, 1024) num_threads(options.threads)
+  for (uint v = 0; v < size; v++) {
+    unsigned long long degree = degreeOf(table, v);
+    cumulative[v + 1] = (degree > 1) ? degree * (degree - 1) / 2 : 0;
+  }
+  for (uint v = 0; v < size; v++) {
+    cumulative[v + 1] += cumulative[v];
+  }
+  double wedges = (double) cumulative[size];
+
+  unsigned long long drawn = 0, closed = 0;
+  unsigned long long *vertexDrawn = (unsigned long long *) calloc(result.top + 1, sizeof(unsigned long long));
+  unsigned long long *vertexClosed = (unsigned long long *) calloc(result.top + 1, sizeof(unsigned long long));
+
+  for (int round = 0; round < SAMPLE_MAX_ROUNDS; round++) {
+    int converged = 1;
+    result.rounds = round + 1;
+
+    if (wedges == 0) {
+      sample_estimate none = {0, 0, 0, 0};
+      result.total = none;
+    } else if (round == 0 || !precise(result.total, options.error)) {
+      unsigned long long count = (round == 0) ? SAMPLE_FIRST_WEDGES : drawn;
+      closed += drawWedges(table, cumulative, -1, options.seed, drawn, count, options.threads);
+      drawn += count;
+      result.total = wilsonEstimate(closed, drawn, wedges / 3);
+      converged = precise(result.total, options.error);
+    }
+
+    for (uint i = 0; i < result.top; i++) {
+      uint v = result.vertices[i];
+      double degree = degreeOf(table, v);
+      if (degree < 2 || (round > 0 && precise(result.vertex[i], options.error))) {
+        continue;
+      }
+
+      unsigned long long count = (round == 0) ? SAMPLE_FIRST_VERTEX_WEDGES : vertexDrawn[i];
+      vertexClosed[i] += drawWedges(table, cumulative, v, splitmix64(options.seed, ~(unsigned long long) v),
+        vertexDrawn[i], count, options.threads);
+      vertexDrawn[i] += count;
+      result.vertex[i] = wilsonEstimate(vertexClosed[i], vertexDrawn[i], degree * (degree - 1) / 2);
+      converged = converged && precise(result.vertex[i], options.error);
+    }
+
+    if (converged) {
+      result.converged = 1;
+      break;
+    }
+    if (!withinBudget(options, start)) {
+      break;
+    }
+  }
+
+  free(cumulative);
+  free(vertexDrawn);
+  free(vertexClosed);
+  return result;
+}
+
+
+sample_result estimateTriangles(csr table, sample_options options) {
+  double start = nowMicros();
+  sample_result result;
+  memset(&result, 0, sizeof(result));
+  options.threads = (options.threads < 1) ? 1 : options.threads;
+
+  result.vertices = (uint *) malloc((options.top + 1) * sizeof(uint));
+  result.vertex = (sample_estimate *) calloc(options.top + 1, sizeof(sample_estimate));
+  result.top = topVertices(table, options.top, result.vertices);
+  if (options.budget <= 0) {
+    options.budget = SAMPLE_DEFAULT_BUDGET * exactCost(table, options.threads);
+  }
+
+  if (options.method == SAMPLE_DOULION) {
+    result = estimateDoulion(table, options, result, start);
+  } else {
+    result = estimateWedges(table, options, result, start);
+  }
+
+  result.reached = relativeError(result.total);
+  for (uint i = 0; i < result.top; i++) {
+    double error = relativeError(result.vertex[i]);
+    result.reached = (error > result.reached) ? error : result.reached;
+  }
+
+  result.time = nowMicros() - start;
+  return result;
+}
+
+
+void freeSampleResult(sample_result *result) {
+  free(result->vertices);
+  free(result->vertex);
+  result->vertices = NULL;
+  result->vertex = NULL;
+}
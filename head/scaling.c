@@ -0,0 +1,166 @@
+/*
+ * scaling.c
+ * Scaling sweeps. See headers/scaling.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../headers/bench.h"
+#include "../headers/scaling.h"
+
+
+// The thread counts of a sweep: the powers of 2 below the number of cpus, the number of
+// cpus, then twice that to see what oversubscription costs. Weak scaling doubles the graph
+// with the threads, so it only takes powers of 2, up to twice the first one at or above the cpus.
+// Returns how many there are.
+int sweepThreads(int *threads, int max, int weak) {
+  int cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  cpus = (cpus < 1) ? 1 : cpus;
+  int count = 0;
+
+  int p = 1;
+  for (; p < cpus && count < max; p *= 2) {
+    threads[count++] = p;
+  }
+
+  if (weak) {
+    for (int last = p * 2; p <= last && count < max; p *= 2) {
+      threads[count++] = p;
+    }
+  } else {
+    if (count < max) threads[count++] = cpus;
+    if (count < max) threads[count++] = 2 * cpus;
+  }
+
+  return count;
+}
+
+
+// The run of backend with threads, on graph. Any graph when graph is NULL.
+static bench_result *findResult(bench_result *results, int count, char *graph, char *backend, int threads) {
+  for (int i = 0; i < count; i++) {
+    if (results[i].stats.samples > 0 && results[i].threads == threads &&
+      strcmp(results[i].backend, backend) == 0 && (graph == NULL || strcmp(results[i].graph, graph) == 0))
+    {
+      return &results[i];
+    }
+  }
+  return NULL;
+}
+
+
+static int comparePoints(const void *a, const void *b) {
+  const scaling_point *x = (const scaling_point *) a;
+  const scaling_point *y = (const scaling_point *) b;
+
+  int order = strcmp(x->backend, y->backend);
+  if (order == 0 && x->mode == SCALING_STRONG) {
+    order = strcmp(x->graph, y->graph);
+  }
+  return (order != 0) ? order : x->threads - y->threads;
+}
+
+
+// One point for every parallel run that has a single thread run of the same backend to compare to.
+// The points are grouped by backend (and graph, for strong scaling) and sorted by threads.
+// Returns how many there are. points needs room for count of them.
+int computeScaling(bench_result *results, int count, int mode, scaling_point *points) {
+  int cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  int points_num = 0;
+
+  for (int i = 0; i < count; i++) {
+    bench_result *run = &results[i];
+    if (run->stats.samples == 0 || strcmp(run->backend, "serial") == 0 || strcmp(run->backend, "load") == 0) {
+      continue;
+    }
+
+    char *graph = (mode == SCALING_STRONG) ? run->graph : NULL;
+    bench_result *single = findResult(results, count, graph, run->backend, 1);
+    bench_result *serial = findResult(results, count, graph, "serial", 1);
+    if (single == NULL) {
+      continue;
+    }
+
+    int p = run->threads;
+    double time = run->stats.median;
+    scaling_point *point = &points[points_num++];
+    point->mode = mode;
+    point->graph = run->graph;
+    point->backend = run->backend;
+    point->threads = p;
+    point->oversubscribed = p > cpus;
+    point->time = time;
+
+    // Weak scaling has p times the work at p threads.
+    double work = (mode == SCALING_WEAK) ? p : 1;
+    point->speedup = work * single->stats.median / time;
+    point->serialSpeedup = (serial != NULL) ? work * serial->stats.median / time : 0;
+    point->efficiency = point->speedup / p;
+    point->karpFlatt = (p > 1) ? (1 / point->speedup - 1.0 / p) / (1 - 1.0 / p) : 0;
+    point->knee = 0;
+  }
+
+  qsort(points, points_num, sizeof(scaling_point), comparePoints);
+
+  // The knee of every group: the point before the first one that gains less than SCALING_KNEE.
+  int first = 0;
+  while (first < points_num) {
+    int last = first;
+    while (last + 1 < points_num && strcmp(points[last + 1].backend, points[first].backend) == 0 &&
+      (mode == SCALING_WEAK || strcmp(points[last + 1].graph, points[first].graph) == 0))
+    {
+      last++;
+    }
+
+    int knee = first;
+    while (knee < last && points[knee + 1].speedup >= SCALING_KNEE * points[knee].speedup) {
+      knee++;
+    }
+    points[knee].knee = 1;
+
+    first = last + 1;
+  }
+
+  return points_num;
+}
+
+
+void printScaling(scaling_point *points, int count) {
+  printf("\n%-10s %-16s %-14s %8s %12s %9s %9s %11s %11s\n", "scaling", "graph", "backend", "threads",
+    "median(us)", "speedup", "vs serial", "efficiency", "karp-flatt");
+
+  for (int i = 0; i < count; i++) {
+    scaling_point p = points[i];
+    printf("%-10s %-16s %-14s %7d%s %12.0f %9.2f %9.2f %11.2f %11.3f%s\n",
+      (p.mode == SCALING_WEAK) ? "weak" : "strong", p.graph, p.backend, p.threads,
+      (p.oversubscribed) ? "*" : " ", p.time, p.speedup, p.serialSpeedup, p.efficiency, p.karpFlatt,
+      (p.knee) ? "   <- knee" : "");
+  }
+  printf("(* more threads than cpus)\n\n");
+}
+
+
+// Tab separated, one row per point, with the same metadata columns as the results file.
+void writeScalingCSV(char *path, scaling_point *points, int count, bench_meta meta) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    printf("Couldn't write %s\n", path);
+    return;
+  }
+
+  fprintf(file, "scaling\tgraph\tbackend\tthreads\toversubscribed\tmedian_us\tspeedup\tserial_speedup"
+    "\tefficiency\tkarp_flatt\tknee\thost\tcompiler\tflags\tdate\tcpus\n");
+
+  for (int i = 0; i < count; i++) {
+    scaling_point p = points[i];
+    fprintf(file, "%s\t%s\t%s\t%d\t%d\t%.1f\t%.4f\t%.4f\t%.4f\t%.4f\t%d\t%s\t%s\t%s\t%s\t%ld\n",
+      (p.mode == SCALING_WEAK) ? "weak" : "strong", p.graph, p.backend, p.threads, p.oversubscribed,
+      p.time, p.speedup, p.serialSpeedup, p.efficiency, p.karpFlatt, p.knee,
+      meta.host, meta.compiler, meta.flags, meta.date, meta.cpus);
+  }
+
+  fclose(file);
+}
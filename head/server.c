@@ -0,0 +1,564 @@
+/*
+ * server.c
+ * The query daemon. See headers/server.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "../headers/csr.h"
+#include "../headers/mmio.h"
+#include "../headers/helpers.h"
+#include "../headers/bench.h"
+#include "../headers/generator.h"
+#include "../headers/truss.h"
+#include "../headers/subset.h"
+#include "../headers/server.h"
+
+#define SERVER_CONTINUE 0
+#define SERVER_CLOSE 1
+#define SERVER_SHUTDOWN 2
+
+typedef struct {
+  served_graph *graphs;
+  int count;
+  int threads;
+  char *socketPath;
+  int stopping;
+
+  // The connections that are open, so that SHUTDOWN can close them and wait for them.
+  pthread_mutex_t lock;
+  pthread_cond_t closed;
+  int *clients;
+  int clients_num;
+  int capacity;
+} server_state;
+
+typedef struct {
+  server_state *server;
+  int fd;
+} server_client;
+
+
+// Every graph as name=graph, or as the graph alone, named by graphName(). NULL if one can't be read.
+served_graph *loadServedGraphs(char **graphs, int count) {
+  served_graph *served = (served_graph *) calloc(count, sizeof(served_graph));
+
+  for (int i = 0; i < count; i++) {
+    char *equals = strchr(graphs[i], '=');
+    char *graph = (equals != NULL) ? equals + 1 : graphs[i];
+    served[i].name = (equals != NULL) ? strndup(graphs[i], equals - graphs[i]) : graphName(graph);
+    served[i].table = loadGraph(graph);
+    pthread_mutex_init(&served[i].lock, NULL);
+
+    if (served[i].table.rowIndex == NULL) {
+      freeServedGraphs(served, i + 1);
+      return NULL;
+    }
+  }
+
+  return served;
+}
+
+
+void freeServedGraphs(served_graph *graphs, int count) {
+  for (int i = 0; i < count; i++) {
+    free(graphs[i].name);
+    if (graphs[i].table.rowIndex != NULL) {
+      freeCSR(graphs[i].table);
+    }
+    free(graphs[i].support);
+    free(graphs[i].triangles);
+    pthread_mutex_destroy(&graphs[i].lock);
+  }
+  free(graphs);
+}
+
+
+// The first query on a graph computes everything the others are answered from.
+static void cacheCounts(served_graph *graph, int threads) {
+  pthread_mutex_lock(&graph->lock);
+  if (graph->cached) {
+    pthread_mutex_unlock(&graph->lock);
+    return;
+  }
+
+  double start = nowMicros();
+  csr table = graph->table;
+  uint size = table.size;
+  graph->support = edgeSupport(table, threads);
+  graph->triangles = (uint *) calloc((size > 0) ? size : 1, sizeof(uint));
+
+  unsigned long long sum = 0, wedges = 0;
+  #pragma omp parallel for schedule(dynamic, 1024) num_threads(threads) reduction(+:sum, wedges)
+  for (uint row = 0; row < size; row++) {
+    unsigned long long rowSum = 0, degree = 0;
+    for (uint i = table.rowIndex[row]; i < table.rowIndex[row + 1]; i++) {
+      rowSum += graph->support[i];
+      degree += (table.colIndex[i] != row);
+    }
+    graph->triangles[row] = rowSum / 2;
+    sum += rowSum / 2;
+    wedges += (degree > 1) ? degree * (degree - 1) / 2 : 0;
+  }
+
+  graph->total = sum / 3;
+  graph->wedges = wedges;
+  graph->computeTime = nowMicros() - start;
+  printf("%s: counted %llu triangles for the first query in %.0f us\n", graph->name, graph->total,
+    graph->computeTime);
+  __atomic_store_n(&graph->cached, 1, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&graph->lock);
+}
+
+
+static served_graph *findGraph(server_state *server, char *name) {
+  for (int i = 0; name != NULL && i < server->count; i++) {
+    if (strcmp(server->graphs[i].name, name) == 0) {
+      return &server->graphs[i];
+    }
+  }
+  return NULL;
+}
+
+
+// The vertices on the rest of the line, 0-based. NULL, with the reason in error, if one isn't a vertex.
+static uint *parseVertices(char **save, uint size, uint *count, char *error, size_t length) {
+  uint capacity = 16;
+  uint *vertices = (uint *) malloc(capacity * sizeof(uint));
+  *count = 0;
+
+  char *token;
+  while ((token = strtok_r(NULL, " \t\r\n", save)) != NULL) {
+    char *end;
+    unsigned long vertex = strtoul(token, &end, 10);
+    if (*end != '\0' || vertex < 1 || vertex > size) {
+      snprintf(error, length, "%s isn't a vertex (1 to %u)", token, size);
+      free(vertices);
+      return NULL;
+    }
+    if (*count == capacity) {
+      capacity *= 2;
+      vertices = (uint *) realloc(vertices, capacity * sizeof(uint));
+    }
+    vertices[(*count)++] = vertex - 1;
+  }
+
+  return vertices;
+}
+
+
+// The position of column in row, or the end of the row if it isn't there.
+static uint findColumn(csr table, uint row, uint column) {
+  uint low = table.rowIndex[row], high = table.rowIndex[row + 1];
+  while (low < high) {
+    uint middle = low + (high - low) / 2;
+    if (table.colIndex[middle] < column) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return (low < table.rowIndex[row + 1] && table.colIndex[low] == column) ? low : table.rowIndex[row + 1];
+}
+
+
+static double localClustering(csr table, uint vertex, uint triangles) {
+  unsigned long long degree = table.rowIndex[vertex + 1] - table.rowIndex[vertex];
+  degree -= (findColumn(table, vertex, vertex) != table.rowIndex[vertex + 1]);
+  return (degree > 1) ? 2.0 * triangles / (degree * (degree - 1)) : 0;
+}
+
+
+// The triangles u < v < w of the subgraph the vertices induce.
+static unsigned long long subsetTriangles(csr table, uint *vertices, uint count, int threads) {
+  char *member = (char *) calloc(table.size, sizeof(char));
+  uint *unique = (uint *) malloc(((count > 0) ? count : 1) * sizeof(uint));
+  uint unique_num = 0;
+  for (uint i = 0; i < count; i++) {
+    if (!member[vertices[i]]) {
+      member[vertices[i]] = 1;
+      unique[unique_num++] = vertices[i];
+    }
+  }
+
+  unsigned long long triangles = 0;
+  #pragma omp parallel for schedule(dynamic, 16) num_threads(threads) reduction(+:triangles)
+  for (uint k = 0; k < unique_num; k++) {
+    uint u = unique[k];
+    uint end = table.rowIndex[u + 1];
+    for (uint i = table.rowIndex[u]; i < end; i++) {
+      uint v = table.colIndex[i];
+      if (v <= u || !member[v]) {
+        continue;
+      }
+      uint a = i + 1, b = table.rowIndex[v], bEnd = table.rowIndex[v + 1];
+      while (a < end && b < bEnd) {
+        uint x = table.colIndex[a], y = table.colIndex[b];
+        if (x < y) {
+          a++;
+        } else if (x > y) {
+          b++;
+        } else {
+          triangles += (x > v && member[x]);
+          a++;
+          b++;
+        }
+      }
+    }
+  }
+
+  free(member);
+  free(unique);
+  return triangles;
+}
+
+
+// Answers one line. Tells the connection whether to go on, close, or stop the daemon.
+static int answerQuery(server_state *server, char *line, FILE *out) {
+  char *save;
+  char *command = strtok_r(line, " \t\r\n", &save);
+  if (command == NULL) {
+    return SERVER_CONTINUE;
+  }
+  if (strcasecmp(command, "QUIT") == 0) {
+    return SERVER_CLOSE;
+  }
+  if (strcasecmp(command, "SHUTDOWN") == 0) {
+    fprintf(out, "OK 0\n");
+    return SERVER_SHUTDOWN;
+  }
+  if (strcasecmp(command, "GRAPHS") == 0) {
+    fprintf(out, "OK %d\n", server->count);
+    for (int i = 0; i < server->count; i++) {
+      csr table = server->graphs[i].table;
+      fprintf(out, "%s\t%u\t%u\n", server->graphs[i].name, table.size, table.rowIndex[table.size]);
+    }
+    return SERVER_CONTINUE;
+  }
+
+  int known = strcasecmp(command, "COUNT") == 0 || strcasecmp(command, "TRIANGLES") == 0
+    || strcasecmp(command, "CLUSTERING") == 0 || strcasecmp(command, "SUBSET") == 0
+    || strcasecmp(command, "SUPPORT") == 0;
+  if (!known) {
+    fprintf(out, "ERR unknown query %s\n", command);
+    return SERVER_CONTINUE;
+  }
+
+  char *name = strtok_r(NULL, " \t\r\n", &save);
+  served_graph *graph = findGraph(server, name);
+  if (graph == NULL) {
+    fprintf(out, "ERR no graph %s\n", (name != NULL) ? name : "given");
+    return SERVER_CONTINUE;
+  }
+  csr table = graph->table;
+
+  char error[128];
+  uint count;
+  uint *vertices = parseVertices(&save, table.size, &count, error, sizeof(error));
+  if (vertices == NULL) {
+    fprintf(out, "ERR %s\n", error);
+    return SERVER_CONTINUE;
+  }
+
+  if (strcasecmp(command, "SUBSET") == 0) {
+    // Only needs the rows of the subset, so it doesn't wait for the cache.
+    if (count == 0) {
+      fprintf(out, "ERR SUBSET needs vertices\n");
+    } else {
+      fprintf(out, "OK 1\n%llu\n", subsetTriangles(table, vertices, count, server->threads));
+    }
+    free(vertices);
+    return SERVER_CONTINUE;
+  }
+
+  if (strcasecmp(command, "SUPPORT") == 0 && count % 2 != 0) {
+    fprintf(out, "ERR SUPPORT needs pairs of vertices\n");
+    free(vertices);
+    return SERVER_CONTINUE;
+  }
+
+  // The triangles of a few vertices don't need the whole graph counted, until it is.
+  int perVertex = count > 0 && (strcasecmp(command, "TRIANGLES") == 0 || strcasecmp(command, "CLUSTERING") == 0);
+  if (perVertex && !__atomic_load_n(&graph->cached, __ATOMIC_ACQUIRE)) {
+    uint *triangles = countSubsetTriangles(table, vertices, count, server->threads);
+    fprintf(out, "OK %u\n", count);
+    for (uint i = 0; i < count; i++) {
+      if (strcasecmp(command, "TRIANGLES") == 0) {
+        fprintf(out, "%u\t%u\n", vertices[i] + 1, triangles[i]);
+      } else {
+        fprintf(out, "%u\t%.6f\n", vertices[i] + 1, localClustering(table, vertices[i], triangles[i]));
+      }
+    }
+    free(triangles);
+    free(vertices);
+    return SERVER_CONTINUE;
+  }
+
+  if (!__atomic_load_n(&graph->cached, __ATOMIC_ACQUIRE)) {
+    cacheCounts(graph, server->threads);
+  }
+
+  if (strcasecmp(command, "COUNT") == 0) {
+    fprintf(out, "OK 1\n%llu\n", graph->total);
+  } else if (strcasecmp(command, "TRIANGLES") == 0) {
+    fprintf(out, "OK %u\n", (count > 0) ? count : table.size);
+    for (uint i = 0; i < ((count > 0) ? count : table.size); i++) {
+      uint v = (count > 0) ? vertices[i] : i;
+      fprintf(out, "%u\t%u\n", v + 1, graph->triangles[v]);
+    }
+  } else if (strcasecmp(command, "CLUSTERING") == 0) {
+    if (count == 0) {
+      double average = 0;
+      for (uint v = 0; v < table.size; v++) {
+        average += localClustering(table, v, graph->triangles[v]);
+      }
+      fprintf(out, "OK 2\ntransitivity\t%.6f\naverage\t%.6f\n",
+        (graph->wedges > 0) ? 3.0 * graph->total / graph->wedges : 0, (table.size > 0) ? average / table.size : 0);
+    } else {
+      fprintf(out, "OK %u\n", count);
+      for (uint i = 0; i < count; i++) {
+        fprintf(out, "%u\t%.6f\n", vertices[i] + 1, localClustering(table, vertices[i], graph->triangles[vertices[i]]));
+      }
+    }
+  } else {
+    uint pairs = count / 2;
+    if (pairs > 0) {
+      for (uint p = 0; p < pairs; p++) {
+        uint u = vertices[2 * p], v = vertices[2 * p + 1];
+        if (findColumn(table, u, v) == table.rowIndex[u + 1]) {
+          fprintf(out, "ERR %u %u isn't an edge\n", u + 1, v + 1);
+          free(vertices);
+          return SERVER_CONTINUE;
+        }
+      }
+      fprintf(out, "OK %u\n", pairs);
+      for (uint p = 0; p < pairs; p++) {
+        uint u = vertices[2 * p], v = vertices[2 * p + 1];
+        fprintf(out, "%u\t%u\t%d\n", u + 1, v + 1, graph->support[findColumn(table, u, v)]);
+      }
+    } else {
+      unsigned long long edges = 0;
+      for (uint u = 0; u < table.size; u++) {
+        for (uint i = table.rowIndex[u]; i < table.rowIndex[u + 1]; i++) {
+          edges += (table.colIndex[i] > u);
+        }
+      }
+      fprintf(out, "OK %llu\n", edges);
+      for (uint u = 0; u < table.size; u++) {
+        for (uint i = table.rowIndex[u]; i < table.rowIndex[u + 1]; i++) {
+          if (table.colIndex[i] > u) {
+            fprintf(out, "%u\t%u\t%d\n", u + 1, table.colIndex[i] + 1, graph->support[i]);
+          }
+        }
+      }
+    }
+  }
+
+  free(vertices);
+  return SERVER_CONTINUE;
+}
+
+
+static int connectTo(char *socketPath) {
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, socketPath, sizeof(address.sun_path) - 1);
+
+  if (fd < 0 || connect(fd, (struct sockaddr *) &address, sizeof(address)) != 0) {
+    // The caller tells a stale socket from a missing one by errno.
+    int error = errno;
+    if (fd >= 0) {
+      close(fd);
+    }
+    errno = error;
+    return -1;
+  }
+  return fd;
+}
+
+
+static void removeClient(server_state *server, int fd) {
+  pthread_mutex_lock(&server->lock);
+  for (int i = 0; i < server->clients_num; i++) {
+    if (server->clients[i] == fd) {
+      server->clients[i] = server->clients[--server->clients_num];
+      break;
+    }
+  }
+  pthread_cond_signal(&server->closed);
+  pthread_mutex_unlock(&server->lock);
+}
+
+
+static void *serveClientVoid(void *arg) {
+  server_client *client = (server_client *) arg;
+  server_state *server = client->server;
+  FILE *in = fdopen(dup(client->fd), "r");
+  FILE *out = fdopen(dup(client->fd), "w");
+
+  char *line = NULL;
+  size_t capacity = 0;
+  int action = SERVER_CONTINUE;
+  while (action == SERVER_CONTINUE && getline(&line, &capacity, in) > 0) {
+    action = answerQuery(server, line, out);
+    fflush(out);
+  }
+
+  free(line);
+  fclose(in);
+  fclose(out);
+
+  // accept() only returns for a connection, so the daemon gets one to notice.
+  if (action == SERVER_SHUTDOWN) {
+    __atomic_store_n(&server->stopping, 1, __ATOMIC_RELEASE);
+    int wake = connectTo(server->socketPath);
+    if (wake >= 0) {
+      close(wake);
+    }
+  }
+
+  // The daemon may return as soon as the last client is gone: nothing touches it after.
+  int fd = client->fd;
+  free(client);
+  removeClient(server, fd);
+  close(fd);
+  return NULL;
+}
+
+
+// Answers queries until SHUTDOWN. 0 if the socket couldn't be opened.
+int serveQueries(char *socketPath, served_graph *graphs, int count, int threads) {
+  server_state server;
+  memset(&server, 0, sizeof(server));
+  server.graphs = graphs;
+  server.count = count;
+  server.threads = (threads < 1) ? 1 : threads;
+  server.socketPath = socketPath;
+  server.capacity = SERVER_BACKLOG;
+  server.clients = (int *) malloc(server.capacity * sizeof(int));
+  pthread_mutex_init(&server.lock, NULL);
+  pthread_cond_init(&server.closed, NULL);
+
+  // A client that goes away mid-reply mustn't take the daemon with it.
+  signal(SIGPIPE, SIG_IGN);
+
+  // The socket of a daemon that still answers is left alone. Only a stale one, that
+  // refuses connections, is replaced.
+  int running = connectTo(socketPath);
+  if (running >= 0) {
+    close(running);
+    printf("A daemon is already listening on %s\n", socketPath);
+    free(server.clients);
+    return 0;
+  }
+  if (errno == ECONNREFUSED) {
+    unlink(socketPath);
+  }
+
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, socketPath, sizeof(address.sun_path) - 1);
+
+  if (listener < 0 || bind(listener, (struct sockaddr *) &address, sizeof(address)) != 0
+      || listen(listener, SERVER_BACKLOG) != 0) {
+    printf("Couldn't listen on %s\n", socketPath);
+    if (listener >= 0) {
+      close(listener);
+    }
+    free(server.clients);
+    return 0;
+  }
+  printf("Listening on %s\n", socketPath);
+  fflush(stdout);
+
+  while (!__atomic_load_n(&server.stopping, __ATOMIC_ACQUIRE)) {
+    int fd = accept(listener, NULL, NULL);
+    if (fd < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    if (__atomic_load_n(&server.stopping, __ATOMIC_ACQUIRE)) {
+      close(fd);
+      break;
+    }
+
+    pthread_mutex_lock(&server.lock);
+    if (server.clients_num == server.capacity) {
+      server.capacity *= 2;
+      server.clients = (int *) realloc(server.clients, server.capacity * sizeof(int));
+    }
+    server.clients[server.clients_num++] = fd;
+    pthread_mutex_unlock(&server.lock);
+
+    server_client *client = (server_client *) malloc(sizeof(server_client));
+    client->server = &server;
+    client->fd = fd;
+    pthread_t id;
+    pthread_create(&id, NULL, serveClientVoid, (void *) client);
+    pthread_detach(id);
+  }
+
+  // Ends the connections that are still open, then waits for their threads.
+  close(listener);
+  unlink(socketPath);
+  pthread_mutex_lock(&server.lock);
+  for (int i = 0; i < server.clients_num; i++) {
+    shutdown(server.clients[i], SHUT_RDWR);
+  }
+  while (server.clients_num > 0) {
+    pthread_cond_wait(&server.closed, &server.lock);
+  }
+  pthread_mutex_unlock(&server.lock);
+
+  pthread_mutex_destroy(&server.lock);
+  pthread_cond_destroy(&server.closed);
+  free(server.clients);
+  return 1;
+}
+
+
+// Sends one query and prints the reply. 0 if it's an error or there's no daemon.
+int sendQuery(char *socketPath, char *query) {
+  int fd = connectTo(socketPath);
+  if (fd < 0) {
+    printf("No daemon on %s\n", socketPath);
+    return 0;
+  }
+
+  FILE *in = fdopen(dup(fd), "r");
+  FILE *out = fdopen(fd, "w");
+  fprintf(out, "%s\n", query);
+  fflush(out);
+
+  char *line = NULL;
+  size_t capacity = 0;
+  int ok = 0;
+  if (getline(&line, &capacity, in) > 0) {
+    fputs(line, stdout);
+    unsigned long long lines;
+    ok = sscanf(line, "OK %llu", &lines) == 1;
+    for (unsigned long long i = 0; ok && i < lines && getline(&line, &capacity, in) > 0; i++) {
+      fputs(line, stdout);
+    }
+  }
+
+  free(line);
+  fclose(in);
+  fclose(out);
+  return ok;
+}
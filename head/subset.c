@@ -0,0 +1,128 @@
+/*
+ * subset.c
+ * Triangle counts of a subset of the vertices. See headers/subset.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../headers/csr.h"
+#include "../headers/intersect.h"
+#include "../headers/subset.h"
+
+
+// The triangles of every vertex of the list, in its order. NULL if one isn't a vertex.
+uint *countSubsetTriangles(csr table, uint *vertices, uint count, int threads) {
+  threads = (threads < 1) ? 1 : threads;
+  for (uint k = 0; k < count; k++) {
+    if (vertices[k] >= table.size) {
+      return NULL;
+    }
+  }
+
+  // Where the neighbors of every vertex of the list start among all the pairs.
+  unsigned long long *first = (unsigned long long *) malloc((count + 1) * sizeof(unsigned long long));
+  first[0] = 0;
+  for (uint k = 0; k < count; k++) {
+    uint v = vertices[k];
+    first[k + 1] = first[k] + (table.rowIndex[v + 1] - table.rowIndex[v]);
+  }
+  unsigned long long pairs = first[count];
+
+  unsigned long long *sums = (unsigned long long *) calloc((count > 0) ? count : 1, sizeof(unsigned long long));
+
+  #pragma omp parallel for schedule(dynamic, SUBSET_CHUNK) num_threads(threads)
+  for (unsigned long long p = 0; p < pairs; p++) {
+    // The vertex of the list the pair belongs to: the last one that starts at p or before.
+    uint low = 0, high = count;
+    while (high - low > 1) {
+      uint middle = low + (high - low) / 2;
+      if (first[middle] <= p) {
+        low = middle;
+      } else {
+        high = middle;
+      }
+    }
+
+    uint v = vertices[low];
+    uint *row = &table.colIndex[table.rowIndex[v]];
+    uint size = table.rowIndex[v + 1] - table.rowIndex[v];
+    uint u = row[p - first[low]];
+    uint common = intersectAdaptive(row, size, &table.colIndex[table.rowIndex[u]],
+      table.rowIndex[u + 1] - table.rowIndex[u]);
+    if (common > 0) {
+      __atomic_add_fetch(&sums[low], common, __ATOMIC_RELAXED);
+    }
+  }
+
+  uint *triangles = (uint *) malloc(((count > 0) ? count : 1) * sizeof(uint));
+  for (uint k = 0; k < count; k++) {
+    triangles[k] = sums[k] / 2;
+  }
+
+  free(first);
+  free(sums);
+  return triangles;
+}
+
+
+// The vertices of a file, or of a comma separated list when there is no such file,
+// 1-based like the .mtx files, and returned 0-based. In a file, they're separated by
+// any white space, and lines starting with # or % are comments.
+// NULL if one of them isn't a vertex of a table of that size.
+uint *readVertexList(char *source, uint size, uint *count) {
+  FILE *file = (access(source, R_OK) == 0) ? fopen(source, "r") : NULL;
+  uint capacity = 1024;
+  uint *vertices = (uint *) malloc(capacity * sizeof(uint));
+  *count = 0;
+
+  char *line = NULL;
+  size_t length = 0;
+  char *list = (file == NULL) ? strdup(source) : NULL;
+  int more = 1;
+  while (more) {
+    char *text;
+    if (file != NULL) {
+      if (getline(&line, &length, file) < 0) {
+        break;
+      }
+      if (line[0] == '#' || line[0] == '%') {
+        continue;
+      }
+      text = line;
+    } else {
+      text = list;
+      more = 0;
+    }
+
+    char *save;
+    for (char *token = strtok_r(text, " \t\r\n,", &save); token != NULL; token = strtok_r(NULL, " \t\r\n,", &save)) {
+      char *end;
+      unsigned long vertex = strtoul(token, &end, 10);
+      if (*end != '\0' || vertex < 1 || vertex > size) {
+        printf("%s isn't a vertex (1 to %u)\n", token, size);
+        free(vertices);
+        vertices = NULL;
+        more = 0;
+        break;
+      }
+      if (*count == capacity) {
+        capacity *= 2;
+        vertices = (uint *) realloc(vertices, capacity * sizeof(uint));
+      }
+      vertices[(*count)++] = vertex - 1;
+    }
+    if (vertices == NULL) {
+      break;
+    }
+  }
+
+  if (file != NULL) {
+    fclose(file);
+  }
+  free(line);
+  free(list);
+  return vertices;
+}
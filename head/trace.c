@@ -0,0 +1,336 @@
+/*
+ * trace.c
+ * Phase timers, the load imbalance report and the Chrome trace export. See headers/trace.h.
+ *
+ * The events of a run go in one fixed array. Every thread takes the next free
+ * slot with an atomic add, so recording never blocks. The counters at the start
+ * of a phase are kept per thread, until the phase is recorded.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../headers/bench.h"
+#include "../headers/trace.h"
+
+#define MAX_PHASES 32
+#define MAX_WORKERS 1024
+
+int trace_enabled = 0;
+
+static trace_event events[TRACE_CAPACITY];
+static unsigned int events_num = 0;
+static int first_event = 1;
+
+static __thread long long phase_counters[COUNTERS_NUM];
+static __thread int phase_counted = 0;
+
+
+void traceEnable(int enable) {
+  trace_enabled = enable;
+}
+
+
+// Forgets the events of the previous run.
+void traceReset() {
+  events_num = 0;
+}
+
+
+// The start of an event. 0 when tracing is off, so the clock isn't even read.
+double traceStart() {
+  if (!trace_enabled) {
+    return 0;
+  }
+
+  double start = nowMicros();
+  phase_counted = counters_enabled && countersRead(phase_counters);
+  if (memory_enabled) {
+    memoryPhaseStart();
+  }
+  return start;
+}
+
+
+// Records an event that started at start and ends now.
+void traceRecord(const char *name, int worker, double start) {
+  if (!trace_enabled) {
+    return;
+  }
+
+  long long counters[COUNTERS_NUM];
+  int counted = phase_counted && countersRead(counters);
+  memory_usage memory = {0, 0, 0};
+  if (memory_enabled) {
+    memory = memoryPhaseEnd();
+  }
+  double end = nowMicros();
+
+  unsigned int slot = __atomic_fetch_add(&events_num, 1, __ATOMIC_RELAXED);
+  if (slot >= TRACE_CAPACITY) {
+    return;
+  }
+
+  trace_event *event = &events[slot];
+  event->name = name;
+  event->worker = worker;
+  event->start = start;
+  event->end = end;
+  event->counted = counted;
+  for (int i = 0; i < COUNTERS_NUM; i++) {
+    event->counters[i] = (counted) ? counters[i] - phase_counters[i] : 0;
+  }
+  event->memory = memory;
+  phase_counted = 0;
+}
+
+
+// The counts of every event of the last run, added up. Returns 0 if none were counted.
+int traceTotals(long long *totals) {
+  unsigned int count = (events_num < TRACE_CAPACITY) ? events_num : TRACE_CAPACITY;
+  int counted = 0;
+
+  for (int i = 0; i < COUNTERS_NUM; i++) {
+    totals[i] = 0;
+  }
+  for (unsigned int e = 0; e < count; e++) {
+    if (events[e].counted) {
+      counted = 1;
+      for (int i = 0; i < COUNTERS_NUM; i++) {
+        totals[i] += events[e].counters[i];
+      }
+    }
+  }
+
+  return counted;
+}
+
+
+static double ratio(long long a, long long b) {
+  return (b > 0) ? (double) a / b : 0;
+}
+
+
+// Prints the breakdown of the last run:
+// For every phase, the time of its slowest worker (the critical path of the phase),
+// the average time of its workers and their ratio (the imbalance factor).
+// For every worker, when it started and finished (from the first event) and how long it was busy.
+// With the counters on, the IPC and the misses of every phase and worker, and the misses per
+// edge of the whole run. The LLC misses are the only memory traffic a thread can count, so the
+// bandwidth is estimated as one cache line per miss.
+// With the memory accounting on, what every phase allocated, left behind and held at most,
+// added up over its workers.
+void traceReport(const char *label, unsigned int edges) {
+  unsigned int count = (events_num < TRACE_CAPACITY) ? events_num : TRACE_CAPACITY;
+  if (count == 0) {
+    return;
+  }
+
+  double runStart = events[0].start;
+  double runEnd = events[0].end;
+  for (unsigned int i = 1; i < count; i++) {
+    runStart = (events[i].start < runStart) ? events[i].start : runStart;
+    runEnd = (events[i].end > runEnd) ? events[i].end : runEnd;
+  }
+
+  // Sum the time of every (phase, worker) pair. Workers are shifted by one, so the main thread is 0.
+  const char *phases[MAX_PHASES];
+  int phases_num = 0;
+  int workers_num = 0;
+  double *phaseTime = (double *) calloc(MAX_PHASES * (MAX_WORKERS + 1), sizeof(double));
+  long long (*phaseCounters)[COUNTERS_NUM] = calloc(MAX_PHASES, sizeof(*phaseCounters));
+  long long (*workerCounters)[COUNTERS_NUM] = calloc(MAX_WORKERS + 1, sizeof(*workerCounters));
+  memory_usage phaseMemory[MAX_PHASES];
+  memset(phaseMemory, 0, sizeof(phaseMemory));
+  double workerStart[MAX_WORKERS + 1], workerEnd[MAX_WORKERS + 1], workerBusy[MAX_WORKERS + 1];
+  for (int w = 0; w <= MAX_WORKERS; w++) {
+    workerStart[w] = runEnd;
+    workerEnd[w] = runStart;
+    workerBusy[w] = 0;
+  }
+
+  for (unsigned int i = 0; i < count; i++) {
+    int p = 0;
+    while (p < phases_num && strcmp(phases[p], events[i].name) != 0) {
+      p++;
+    }
+    if (p == phases_num) {
+      if (phases_num == MAX_PHASES) {
+        continue;
+      }
+      phases[phases_num++] = events[i].name;
+    }
+
+    int w = events[i].worker + 1;
+    if (w < 0 || w > MAX_WORKERS) {
+      continue;
+    }
+    workers_num = (events[i].worker + 1 > workers_num) ? events[i].worker + 1 : workers_num;
+
+    double duration = events[i].end - events[i].start;
+    phaseTime[p * (MAX_WORKERS + 1) + w] += duration;
+    workerBusy[w] += duration;
+    workerStart[w] = (events[i].start < workerStart[w]) ? events[i].start : workerStart[w];
+    workerEnd[w] = (events[i].end > workerEnd[w]) ? events[i].end : workerEnd[w];
+
+    for (int c = 0; c < COUNTERS_NUM; c++) {
+      phaseCounters[p][c] += events[i].counters[c];
+      workerCounters[w][c] += events[i].counters[c];
+    }
+    phaseMemory[p].allocated += events[i].memory.allocated;
+    phaseMemory[p].retained += events[i].memory.retained;
+    phaseMemory[p].peak += events[i].memory.peak;
+  }
+
+  long long totals[COUNTERS_NUM];
+  int counted = traceTotals(totals);
+
+  printf("\nPhases of %s (wall time %.0f us):\n", label, runEnd - runStart);
+  printf("%-12s %8s %14s %14s %10s", "phase", "workers", "critical(us)", "average(us)", "imbalance");
+  if (counted) {
+    printf(" %14s %6s %12s %12s", "cycles", "IPC", "llc-misses", "br-misses");
+  }
+  if (memory_enabled) {
+    printf(" %10s %12s %9s", "alloc(MB)", "retained(MB)", "peak(MB)");
+  }
+  printf("\n");
+
+  double criticalPath = 0;
+  for (int p = 0; p < phases_num; p++) {
+    double *times = &phaseTime[p * (MAX_WORKERS + 1)];
+
+    int active = 0;
+    double slowest = 0, total = 0;
+    for (int w = 1; w <= workers_num; w++) {
+      if (times[w] > 0) {
+        active++;
+        total += times[w];
+        slowest = (times[w] > slowest) ? times[w] : slowest;
+      }
+    }
+
+    // A phase of the main thread. The backends never run those on workers too.
+    if (times[0] > 0) {
+      printf("%-12s %8s %14.0f %14.0f %10s", phases[p], "main", times[0], times[0], "-");
+      criticalPath += times[0];
+    } else if (active > 0) {
+      double average = total / active;
+      printf("%-12s %8d %14.0f %14.0f %10.2f", phases[p], active, slowest, average, slowest / average);
+      criticalPath += slowest;
+    } else {
+      continue;
+    }
+
+    if (counted) {
+      long long *c = phaseCounters[p];
+      printf(" %14lld %6.2f %12lld %12lld", c[COUNTER_CYCLES],
+        ratio(c[COUNTER_INSTRUCTIONS], c[COUNTER_CYCLES]), c[COUNTER_LLC_MISSES], c[COUNTER_BRANCH_MISSES]);
+    }
+    if (memory_enabled) {
+      printf(" %10.2f %12.2f %9.2f", phaseMemory[p].allocated / MEMORY_MB,
+        phaseMemory[p].retained / MEMORY_MB, phaseMemory[p].peak / MEMORY_MB);
+    }
+    printf("\n");
+  }
+
+  int active = 0;
+  double slowest = 0, total = 0;
+  for (int w = 1; w <= workers_num; w++) {
+    if (workerBusy[w] == 0) {
+      continue;
+    }
+    printf("worker %d: start %.0f us\tfinish %.0f us\tbusy %.0f us", w - 1,
+      workerStart[w] - runStart, workerEnd[w] - runStart, workerBusy[w]);
+    if (counted) {
+      printf("\tIPC %.2f\tllc-misses %lld", ratio(workerCounters[w][COUNTER_INSTRUCTIONS],
+        workerCounters[w][COUNTER_CYCLES]), workerCounters[w][COUNTER_LLC_MISSES]);
+    }
+    printf("\n");
+
+    active++;
+    total += workerBusy[w];
+    slowest = (workerBusy[w] > slowest) ? workerBusy[w] : slowest;
+  }
+
+  printf("critical path: %.0f us\taverage worker: %.0f us\timbalance: %.2f\n",
+    criticalPath, (active > 0) ? total / active : 0, (active > 0) ? slowest / (total / active) : 1);
+
+  double seconds = (runEnd - runStart) / 1e6;
+  printf("intersections/s: %.3g", (seconds > 0) ? edges / seconds : 0);
+  if (counted) {
+    printf("\tIPC: %.2f\tllc-misses/edge: %.3f\tbranch-misses/edge: %.3f\tmemory: ~%.2f GB/s",
+      ratio(totals[COUNTER_INSTRUCTIONS], totals[COUNTER_CYCLES]),
+      ratio(totals[COUNTER_LLC_MISSES], edges), ratio(totals[COUNTER_BRANCH_MISSES], edges),
+      (seconds > 0) ? totals[COUNTER_LLC_MISSES] * (double) CACHE_LINE / seconds / 1e9 : 0);
+  }
+  printf("\n\n");
+
+  free(phaseTime);
+  free(phaseCounters);
+  free(workerCounters);
+}
+
+
+// Starts a Chrome trace file (open it in chrome://tracing or https://ui.perfetto.dev).
+FILE *traceOpen(char *path) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    printf("Couldn't write %s\n", path);
+    return NULL;
+  }
+
+  fprintf(file, "{\"traceEvents\": [");
+  first_event = 1;
+  return file;
+}
+
+
+// Adds the events of the last run as one process of the trace, named after the run.
+// The main thread is thread 0 and worker i is thread i + 1.
+void traceWrite(FILE *file, int process, const char *label) {
+  if (file == NULL) {
+    return;
+  }
+
+  unsigned int count = (events_num < TRACE_CAPACITY) ? events_num : TRACE_CAPACITY;
+  double runStart = (count > 0) ? events[0].start : 0;
+  for (unsigned int i = 1; i < count; i++) {
+    runStart = (events[i].start < runStart) ? events[i].start : runStart;
+  }
+
+  fprintf(file, "%s\n{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"args\": {\"name\": \"%s\"}}",
+    (first_event) ? "" : ",", process, label);
+  first_event = 0;
+
+  for (unsigned int i = 0; i < count; i++) {
+    fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": %d, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f",
+      events[i].name, process, events[i].worker + 1, events[i].start - runStart,
+      events[i].end - events[i].start);
+
+    // The counters and the heap usage show up in the details of the event.
+    if (events[i].counted || memory_enabled) {
+      fprintf(file, ", \"args\": {");
+      for (int c = 0; events[i].counted && c < COUNTERS_NUM; c++) {
+        fprintf(file, "%s\"%s\": %lld", (c == 0) ? "" : ", ", counter_names[c], events[i].counters[c]);
+      }
+      if (memory_enabled) {
+        fprintf(file, "%s\"allocated\": %lld, \"retained\": %lld, \"peak\": %lld",
+          (events[i].counted) ? ", " : "", events[i].memory.allocated, events[i].memory.retained,
+          events[i].memory.peak);
+      }
+      fprintf(file, "}");
+    }
+    fprintf(file, "}");
+  }
+}
+
+
+void traceClose(FILE *file) {
+  if (file == NULL) {
+    return;
+  }
+
+  fprintf(file, "\n]}\n");
+  fclose(file);
+}
@@ -0,0 +1,337 @@
+/*
+ * truss.c
+ * Parallel k-truss decomposition. See headers/truss.h.
+ *
+ * Every edge u < v gets an id, in the order of the table. edgeOf maps every nonzero,
+ * in both of its rows, to the id of its edge, so the merge of two rows finds the ids
+ * of the other two edges of each triangle by the positions of the match.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../headers/csr.h"
+#include "../headers/csr_arg.h"
+#include "../headers/mmio.h"
+#include "../headers/helpers.h"
+#include "../headers/bench.h"
+#include "../headers/trace.h"
+#include "../headers/intersect.h"
+#include "../headers/truss.h"
+
+
+// The table without its self loops, or the table itself when it has none.
+static csr withoutSelfLoops(csr table, int *copied) {
+  uint size = table.size;
+  uint loops = 0;
+  for (uint row = 0; row < size; row++) {
+    for (uint i = table.rowIndex[row]; i < table.rowIndex[row + 1]; i++) {
+      loops += (table.colIndex[i] == row);
+    }
+  }
+
+  *copied = (loops > 0);
+  if (loops == 0) {
+    return table;
+  }
+
+  uint nonzeros = table.rowIndex[size] - loops;
+  csr clean;
+  clean.size = size;
+  clean.rowIndex = (uint *) malloc((size + 1) * sizeof(uint));
+  clean.colIndex = (uint *) malloc(((nonzeros > 0) ? nonzeros : 1) * sizeof(uint));
+  clean.values = (int *) malloc(((nonzeros > 0) ? nonzeros : 1) * sizeof(int));
+
+  uint position = 0;
+  clean.rowIndex[0] = 0;
+  for (uint row = 0; row < size; row++) {
+    for (uint i = table.rowIndex[row]; i < table.rowIndex[row + 1]; i++) {
+      if (table.colIndex[i] != row) {
+        clean.colIndex[position] = table.colIndex[i];
+        clean.values[position++] = 1;
+      }
+    }
+    clean.rowIndex[row + 1] = position;
+  }
+
+  return clean;
+}
+
+
+// The triangles of every nonzero, from the rows of A .* A^2 of every slice.
+// hadamardSingleStep() leaves the zeros out, so its rows are merged back into the table's.
+int *edgeSupport(csr table, int threads) {
+  uint nonzeros = table.rowIndex[table.size];
+  int *support = (int *) calloc((nonzeros > 0) ? nonzeros : 1, sizeof(int));
+  int slices_num = threads * TRUSS_SLICES_PER_THREAD;
+  csr_arg *slices = splitRows(table, slices_num);
+
+  #pragma omp parallel for schedule(dynamic, 1) num_threads(threads)
+  for (int s = 0; s < slices_num; s++) {
+    uint start = slices[s].start, end = slices[s].end;
+    if (end <= start) {
+      continue;
+    }
+    csr hadamard = hadamardSingleStep(table, start, end);
+
+    for (uint row = start; row < end; row++) {
+      uint h = hadamard.rowIndex[row - start];
+      uint hEnd = hadamard.rowIndex[row - start + 1];
+      for (uint i = table.rowIndex[row]; i < table.rowIndex[row + 1] && h < hEnd; i++) {
+        if (hadamard.colIndex[h] == table.colIndex[i]) {
+          support[i] = hadamard.values[h++];
+        }
+      }
+    }
+    freeCSR(hadamard);
+  }
+
+  freeThreadArguments(slices, slices_num);
+  return support;
+}
+
+
+// Takes one triangle off the support of edge. Edges that drop to the level join next.
+static void decrementSupport(int *support, uint edge, int level, uint *next, uint *next_num) {
+  if (__atomic_load_n(&support[edge], __ATOMIC_RELAXED) <= level) {
+    return;
+  }
+
+  int old = __atomic_fetch_sub(&support[edge], 1, __ATOMIC_RELAXED);
+  if (old == level + 1) {
+    next[__atomic_fetch_add(next_num, 1, __ATOMIC_RELAXED)] = edge;
+  } else if (old <= level) {
+    // Another frontier edge got there first. It stays at the level.
+    __atomic_add_fetch(&support[edge], 1, __ATOMIC_RELAXED);
+  }
+}
+
+
+truss_result trussDecomposition(csr input, int threads) {
+  truss_result result;
+  memset(&result, 0, sizeof(result));
+  threads = (threads < 1) ? 1 : threads;
+
+  int copied;
+  csr table = withoutSelfLoops(input, &copied);
+  uint size = table.size;
+  uint nonzeros = table.rowIndex[size];
+
+  double start = nowMicros();
+  double begin = traceStart();
+  int *rowSupport = edgeSupport(table, threads);
+  traceRecord("support", TRACE_MAIN, begin);
+
+  // The ids: the edges of a row above it are numbered from firstEdge of the row on.
+  begin = traceStart();
+  uint *above = (uint *) malloc((size + 1) * sizeof(uint));
+  uint *firstEdge = (uint *) malloc((size + 1) * sizeof(uint));
+  #pragma omp parallel for schedule(dynamic, 1024) num_threads(threads)
+  for (uint row = 0; row < size; row++) {
+    above[row] = firstAbove(table, row, row);
+  }
+  firstEdge[0] = 0;
+  for (uint row = 0; row < size; row++) {
+    firstEdge[row + 1] = firstEdge[row] + table.rowIndex[row + 1] - above[row];
+  }
+  unsigned long long edges = firstEdge[size];
+
+  uint *edgeOf = (uint *) malloc(((nonzeros > 0) ? nonzeros : 1) * sizeof(uint));
+  result.edges = edges;
+  result.u = (uint *) malloc(((edges > 0) ? edges : 1) * sizeof(uint));
+  result.v = (uint *) malloc(((edges > 0) ? edges : 1) * sizeof(uint));
+  result.trussness = (uint *) malloc(((edges > 0) ? edges : 1) * sizeof(uint));
+  int *support = (int *) malloc(((edges > 0) ? edges : 1) * sizeof(int));
+
+  #pragma omp parallel for schedule(dynamic, 1024) num_threads(threads)
+  for (uint row = 0; row < size; row++) {
+    for (uint i = table.rowIndex[row]; i < table.rowIndex[row + 1]; i++) {
+      uint column = table.colIndex[i];
+      if (column > row) {
+        uint edge = firstEdge[row] + (i - above[row]);
+        edgeOf[i] = edge;
+        result.u[edge] = row;
+        result.v[edge] = column;
+        support[edge] = rowSupport[i];
+      } else {
+        // The same edge from the row of its smaller end.
+        uint low = above[column], high = table.rowIndex[column + 1];
+        while (low < high) {
+          uint middle = low + (high - low) / 2;
+          if (table.colIndex[middle] < row) {
+            low = middle + 1;
+          } else {
+            high = middle;
+          }
+        }
+        edgeOf[i] = firstEdge[column] + (low - above[column]);
+      }
+    }
+  }
+  free(rowSupport);
+  free(above);
+  free(firstEdge);
+  traceRecord("index", TRACE_MAIN, begin);
+  result.supportTime = nowMicros() - start;
+
+  // Peel level by level.
+  start = nowMicros();
+  begin = traceStart();
+  char *processed = (char *) calloc((edges > 0) ? edges : 1, sizeof(char));
+  char *inFrontier = (char *) calloc((edges > 0) ? edges : 1, sizeof(char));
+  uint *frontier = (uint *) malloc(((edges > 0) ? edges : 1) * sizeof(uint));
+  uint *next = (uint *) malloc(((edges > 0) ? edges : 1) * sizeof(uint));
+  unsigned long long left = edges;
+  int level = 0;
+
+  while (left > 0) {
+    // The frontier of the level, and the lowest support above it, to skip empty levels.
+    uint frontier_num = 0;
+    int lowest = __INT_MAX__;
+    #pragma omp parallel for schedule(static) num_threads(threads) reduction(min:lowest)
+    for (unsigned long long e = 0; e < edges; e++) {
+      if (processed[e]) {
+        continue;
+      }
+      if (support[e] <= level) {
+        frontier[__atomic_fetch_add(&frontier_num, 1, __ATOMIC_RELAXED)] = e;
+        inFrontier[e] = 1;
+      } else if (support[e] < lowest) {
+        lowest = support[e];
+      }
+    }
+    if (frontier_num == 0) {
+      level = lowest;
+      continue;
+    }
+    result.levels++;
+
+    while (frontier_num > 0) {
+      uint next_num = 0;
+
+      #pragma omp parallel for schedule(dynamic, 64) num_threads(threads)
+      for (uint k = 0; k < frontier_num; k++) {
+        uint e = frontier[k];
+        uint u = result.u[e], v = result.v[e];
+        // The shorter row is searched for in the longer one, by merging or, when they
+        // are far apart, by binary search, so hub rows aren't scanned for every edge.
+        if (table.rowIndex[u + 1] - table.rowIndex[u] > table.rowIndex[v + 1] - table.rowIndex[v]) {
+          uint swap = u; u = v; v = swap;
+        }
+        uint i = table.rowIndex[u], iEnd = table.rowIndex[u + 1];
+        uint j = table.rowIndex[v], jEnd = table.rowIndex[v + 1];
+        int search = (jEnd - j) > INTERSECT_GALLOP_RATIO * (iEnd - i);
+
+        while (i < iEnd && j < jEnd) {
+          if (search) {
+            uint low = j, high = jEnd;
+            while (low < high) {
+              uint middle = low + (high - low) / 2;
+              if (table.colIndex[middle] < table.colIndex[i]) {
+                low = middle + 1;
+              } else {
+                high = middle;
+              }
+            }
+            j = low;
+            if (j == jEnd) {
+              break;
+            }
+          }
+          if (table.colIndex[i] < table.colIndex[j]) {
+            i++;
+            continue;
+          }
+          if (table.colIndex[i] > table.colIndex[j]) {
+            j++;
+            continue;
+          }
+
+          // The triangle (u, v, w): its edges (u, w) and (v, w).
+          uint first = edgeOf[i], second = edgeOf[j];
+          i++;
+          j++;
+          if (processed[first] || processed[second]) {
+            continue;
+          }
+          if (inFrontier[first] && inFrontier[second]) {
+            continue;
+          }
+          if (inFrontier[first]) {
+            if (e < first) {
+              decrementSupport(support, second, level, next, &next_num);
+            }
+          } else if (inFrontier[second]) {
+            if (e < second) {
+              decrementSupport(support, first, level, next, &next_num);
+            }
+          } else {
+            decrementSupport(support, first, level, next, &next_num);
+            decrementSupport(support, second, level, next, &next_num);
+          }
+        }
+      }
+
+      #pragma omp parallel for schedule(static) num_threads(threads)
+      for (uint k = 0; k < frontier_num; k++) {
+        uint e = frontier[k];
+        processed[e] = 1;
+        inFrontier[e] = 0;
+        result.trussness[e] = level + 2;
+      }
+      #pragma omp parallel for schedule(static) num_threads(threads)
+      for (uint k = 0; k < next_num; k++) {
+        inFrontier[next[k]] = 1;
+      }
+
+      left -= frontier_num;
+      uint *swap = frontier;
+      frontier = next;
+      next = swap;
+      frontier_num = next_num;
+    }
+
+    result.maxTruss = level + 2;
+    level++;
+  }
+  traceRecord("peel", TRACE_MAIN, begin);
+  result.peelTime = nowMicros() - start;
+
+  free(processed);
+  free(inFrontier);
+  free(frontier);
+  free(next);
+  free(support);
+  free(edgeOf);
+  if (copied) {
+    freeCSR(table);
+  }
+  return result;
+}
+
+
+// One row per edge, 1-based like the .mtx files.
+int writeTrussness(char *path, truss_result result) {
+  FILE *file = fopen(path, "w");
+  if (file == NULL) {
+    printf("Couldn't write %s\n", path);
+    return 0;
+  }
+
+  fprintf(file, "u\tv\ttruss\n");
+  for (unsigned long long e = 0; e < result.edges; e++) {
+    fprintf(file, "%u\t%u\t%u\n", result.u[e] + 1, result.v[e] + 1, result.trussness[e]);
+  }
+
+  fclose(file);
+  return 1;
+}
+
+
+void freeTrussResult(truss_result *result) {
+  free(result->u);
+  free(result->v);
+  free(result->trussness);
+  memset(result, 0, sizeof(truss_result));
+}
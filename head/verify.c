@@ -0,0 +1,86 @@
+/*
+ * verify.c
+ * The reference triangle counts and the checks of the backends. See headers/verify.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../headers/csr.h"
+#include "../headers/verify.h"
+
+
+// The definition the backends implement, (A .* A^2) summed by row and halved, without
+// dot(): the neighbors of u are marked with u + 1, then the marked neighbors of every
+// neighbor v are counted. Self loops take part like they do in dot(), so the counts
+// are only the true number of triangles on graphs that have none.
+uint *referenceTriangles(csr table) {
+  uint size = table.size;
+  uint *triangles = (uint *) calloc(size, sizeof(uint));
+  uint *marks = (uint *) calloc(size, sizeof(uint));
+
+  for (uint u = 0; u < size; u++) {
+    for (uint i = table.rowIndex[u]; i < table.rowIndex[u + 1]; i++) {
+      marks[table.colIndex[i]] = u + 1;
+    }
+
+    unsigned long long sum = 0;
+    for (uint i = table.rowIndex[u]; i < table.rowIndex[u + 1]; i++) {
+      uint v = table.colIndex[i];
+      for (uint j = table.rowIndex[v]; j < table.rowIndex[v + 1]; j++) {
+        sum += (marks[table.colIndex[j]] == u + 1);
+      }
+    }
+    triangles[u] = sum / 2;
+  }
+
+  free(marks);
+  return triangles;
+}
+
+
+// splitmix64's finalizer. Spreads the vertex numbers, so that swapped counts change the sum.
+static unsigned long long mixVertex(unsigned long long x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+
+// The total and the checksum of the per-vertex counts, unchecked.
+verify_result summarizeTriangles(uint *triangles, uint size) {
+  verify_result result = {0, 0, VERIFY_NONE, 0, 0};
+  unsigned long long sum = 0;
+
+  for (uint i = 0; i < size; i++) {
+    sum += triangles[i];
+    result.checksum += mixVertex(i) * (triangles[i] + 1ULL);
+  }
+  result.total = sum / 3;
+
+  return result;
+}
+
+
+// Compares the counts to the reference vertex by vertex when there is one. Otherwise
+// to the total and the checksum of expected. Nothing is checked if both are NULL.
+verify_result verifyTriangles(uint *triangles, uint *reference, verify_result *expected, uint size) {
+  verify_result result = summarizeTriangles(triangles, size);
+
+  if (reference != NULL) {
+    for (uint i = 0; i < size; i++) {
+      if (triangles[i] != reference[i]) {
+        result.first = (result.mismatches == 0) ? i : result.first;
+        result.mismatches++;
+      }
+    }
+    result.status = (result.mismatches == 0) ? VERIFY_OK : VERIFY_MISMATCH;
+  }
+  else if (expected != NULL) {
+    result.status = (result.total == expected->total && result.checksum == expected->checksum)
+      ? VERIFY_OK : VERIFY_MISMATCH;
+  }
+
+  return result;
+}
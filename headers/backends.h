@@ -0,0 +1,39 @@
+/*
+ * backends.h
+ * The common interface of every implementation of the algorithm, so that a single
+ * driver can load a graph once and run any of them on it.
+ *
+ * @param name: The name the backend is selected by on the command line.
+ * @param label: The prefix of its row in stats/data.csv (followed by the number of threads).
+ * @param parallel: 0 if the backend ignores the number of threads.
+ * @param count: Returns the triangles of every vertex. plan is NULL outside NUMA mode.
+ */
+
+#ifndef BACKENDS_H
+#define BACKENDS_H
+
+#include <stdio.h>
+#include "csr.h"
+#include "numa_helpers.h"
+
+typedef struct {
+  char *name;
+  char *label;
+  int parallel;
+  uint *(*count)(csr table, int threads, numa_plan *plan);
+} backend;
+
+extern backend backends[];
+extern int backends_num;
+
+backend *findBackend(char *name);
+
+// The implementations. The openMP and Cilk ones only exist if the compiler supports them.
+uint *countTrianglesSerial(csr table, int threads, numa_plan *plan);
+uint *countTrianglesPthread(csr table, int threads, numa_plan *plan);
+uint *countTrianglesOMP(csr table, int threads, numa_plan *plan);
+uint *countTrianglesEdgesOMP(csr table, int threads, numa_plan *plan);
+uint *countTrianglesCilk(csr table, int threads, numa_plan *plan);
+uint *countTrianglesEdgesCilk(csr table, int threads, numa_plan *plan);
+
+#endif
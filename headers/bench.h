@@ -0,0 +1,73 @@
+/*
+ * bench.h
+ * The benchmark harness: monotonic timing, the statistics of the repetitions
+ * and the machine readable output (tab separated CSV and JSON) of every run.
+ *
+ * @param min, median, mean, p95, stddev: In us.
+ * @param samples: The number of measured repetitions (warmups not included).
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+
+typedef struct {
+  double min;
+  double median;
+  double mean;
+  double p95;
+  double stddev;
+  int samples;
+} time_stats;
+
+// One row of the output: a graph, a backend and the number of threads it ran with.
+// @param graph: The name of the graph (the file name without the path and the .mtx).
+// @param backend: The name of the backend or mode.
+// @param label: The row label of stats/data.csv (seq, pth4, ...).
+// @param times: The measured times in us. There are stats.samples of them.
+// @param intersections: Sorted list intersections (one per nonzero) per second, at the median time.
+// @param ipc, missesPerEdge: From the hardware counters of the last repetition. -1 without counters.
+// @param triangles, checksum: The total and the checksum of the first measured repetition.
+// @param verified: VERIFY_OK or VERIFY_MISMATCH in verify mode, VERIFY_NONE otherwise (see verify.h).
+// @param peakHeap, peakRSS: In bytes, over all the repetitions, the graph included. -1 without the accounting.
+// @param retained: The heap bytes every repetition left behind, on average.
+// @param bytesPerEdge: The peak heap per nonzero of the graph.
+typedef struct {
+  char *graph;
+  char *backend;
+  char *label;
+  int threads;
+  int warmups;
+  double *times;
+  time_stats stats;
+  double intersections;
+  double ipc;
+  double missesPerEdge;
+  unsigned long long triangles;
+  unsigned long long checksum;
+  int verified;
+  long long peakHeap;
+  long long peakRSS;
+  long long retained;
+  double bytesPerEdge;
+} bench_result;
+
+// Where and how the binary was built and run.
+typedef struct {
+  char host[256];
+  char compiler[256];
+  char flags[256];
+  char date[64];
+  long cpus;
+} bench_meta;
+
+double nowMicros();
+time_stats computeStats(double *times, int count);
+bench_meta readBenchMeta();
+char *graphName(char *path);
+void writeResultsCSV(char *path, bench_result *results, int count, bench_meta meta);
+void writeResultsJSON(char *path, bench_result *results, int count, bench_meta meta);
+bench_result *readResultsJSON(char *path, int *count);
+
+#endif
@@ -0,0 +1,33 @@
+/*
+ * clique.h
+ * Counts the k-cliques of a graph, globally and per vertex, for any k from 3 up to
+ * CLIQUE_MAX_K. k = 3 gives the triangles.
+ *
+ * The edges are oriented from the lower rank to the higher (kClist, Danisch et al.), so
+ * every clique is found once, from its lowest vertex. The ranks are a degeneracy order
+ * (the cores, peeled by bucket, serial and O(edges)) or a degree order (parallel, a bit
+ * more work per vertex): either way no vertex has more than a few out-neighbors.
+ * The candidates of every level are the out-neighbors of the chosen vertices so far,
+ * intersected level by level into per-thread scratch buffers, one per level.
+ * The top-level vertices are handed out to the threads dynamically, the biggest first.
+ *
+ * The per-vertex counts have the shape of countTriangles(): one uint per vertex, every
+ * clique counted at each of its k vertices, so they add up to k times the total.
+ * Self loops are ignored.
+ */
+
+#ifndef CLIQUE_H
+#define CLIQUE_H
+
+#include "csr.h"
+
+#define CLIQUE_MAX_K 16
+
+#define CLIQUE_DEGENERACY 0
+#define CLIQUE_DEGREE 1
+
+uint *countCliques(csr table, int k, int ordering, int threads, unsigned long long *total);
+int parseCliqueOrdering(char *name);
+const char *cliqueOrderingName(int ordering);
+
+#endif
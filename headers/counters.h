@@ -0,0 +1,28 @@
+/*
+ * counters.h
+ * Hardware performance counters of the calling thread, read with perf_event_open().
+ * No external tools are needed, but the kernel has to allow it
+ * (/proc/sys/kernel/perf_event_paranoid at 2 or lower counts user space only).
+ *
+ * The counters are opened the first time a thread reads them and closed when it exits.
+ */
+
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#define COUNTER_CYCLES 0
+#define COUNTER_INSTRUCTIONS 1
+#define COUNTER_LLC_MISSES 2
+#define COUNTER_BRANCH_MISSES 3
+#define COUNTERS_NUM 4
+
+// A cache line, to turn LLC misses into the bytes they brought from memory.
+#define CACHE_LINE 64
+
+extern int counters_enabled;
+extern const char *counter_names[COUNTERS_NUM];
+
+int countersEnable();
+int countersRead(long long *values);
+
+#endif
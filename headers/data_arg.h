@@ -2,7 +2,7 @@
  * data_arg.h
  * 
  * A struct that's used for the presentation of the assignment.
- * Store the time it took for the algorithm to finish
+ * Store the time (in us) it took for the algorithm to finish
  * and the resulting array of triangle values.
  */
 
@@ -13,7 +13,7 @@
 #include <stdlib.h>
 
 typedef struct {
-  uint time;
+  double time;
   uint *triangles;
 } data_arg;
 
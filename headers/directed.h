@@ -0,0 +1,66 @@
+/*
+ * directed.h
+ * Directed graphs and their triangle census.
+ *
+ * readmtx_dynamic() mirrors every entry, so the direction of the edges of a general
+ * .mtx file is lost. readDirectedMtx() keeps it: out holds the successors of every
+ * vertex and in its predecessors, both sorted, without duplicates or self loops. The
+ * entries of a symmetric (or skew) file are edges both ways.
+ *
+ * The census lists every triangle of the underlying undirected graph once, like the
+ * oriented count does: the union of out and in by row, where every entry also says which
+ * way the edge goes (one way, the other or both), is merged row by row, and the three
+ * directions of each triangle give its type. Reciprocal edges count once in the union, so
+ * they make one triangle and not several. The rows are handed out dynamically, and
+ * skewed pairs are searched like intersectGalloping() does.
+ *
+ * The types of the triads with an edge between every two vertices (Holland and Leinhardt),
+ * with a <-> b a reciprocal edge:
+ *   030T: a -> b -> c, a -> c. The feed-forward loop.
+ *   030C: a -> b -> c -> a. The cycle.
+ *   120D: a <-> b, c -> a, c -> b.
+ *   120U: a <-> b, a -> c, b -> c.
+ *   120C: a <-> b, a -> c -> b.
+ *   210:  a <-> b, b <-> c, a -> c (or c -> a).
+ *   300:  every edge reciprocal.
+ *
+ * @param totals: The triangles of every type.
+ * @param vertices: DIRECTED_TYPES counts per vertex: the triangles of every type it's in.
+ * @param reciprocal: The pairs with an edge both ways.
+ * @param time: In us.
+ */
+
+#ifndef DIRECTED_H
+#define DIRECTED_H
+
+#include "csr.h"
+
+#define DIRECTED_TYPES 7
+
+#define DIRECTED_030T 0
+#define DIRECTED_030C 1
+#define DIRECTED_120D 2
+#define DIRECTED_120U 3
+#define DIRECTED_120C 4
+#define DIRECTED_210 5
+#define DIRECTED_300 6
+
+typedef struct {
+  csr out;
+  csr in;
+} directed_graph;
+
+typedef struct {
+  unsigned long long totals[DIRECTED_TYPES];
+  uint *vertices;
+  unsigned long long reciprocal;
+  double time;
+} census_result;
+
+directed_graph readDirectedMtx(char *path);
+census_result directedCensus(directed_graph graph, int threads);
+const char *directedTypeName(int type);
+void freeDirectedGraph(directed_graph *graph);
+void freeCensusResult(census_result *result);
+
+#endif
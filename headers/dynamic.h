@@ -0,0 +1,66 @@
+/*
+ * dynamic.h
+ * Triangle counts kept up to date while edges are inserted and deleted, without
+ * reading or recounting the whole graph.
+ *
+ * Every vertex keeps its neighbors in its own sorted block, that grows by doubling.
+ * A batch of updates only touches the blocks of its endpoints and the counts of the
+ * triangles they close or open: for every changed edge (u, v), every w in N(u) and N(v).
+ * So an update costs about deg(u) + deg(v), whatever the size of the graph.
+ *
+ * A batch runs in three parallel passes (openMP, serial without it):
+ *   1. For every deleted edge, the triangles it belongs to in the old graph are lost.
+ *   2. Every touched block is rebuilt once, with the deletions and the insertions merged in.
+ *   3. For every inserted edge, the triangles it belongs to in the new graph are new.
+ * A triangle with more than one changed edge of the batch is only counted by the first
+ * of them (in the sorted batch), so it's never counted twice.
+ *
+ * Within a batch the last update of an edge wins. Inserting an edge that is there or
+ * deleting one that isn't changes nothing. Self loops are ignored, so the counts are the
+ * true number of triangles, and vertices past the end add to the graph.
+ *
+ * @param neighbors, degree, capacity: The sorted block of every vertex.
+ * @param triangles: The triangles of every vertex. total: Of the graph.
+ */
+
+#ifndef DYNAMIC_H
+#define DYNAMIC_H
+
+#include "csr.h"
+
+#define DYNAMIC_DELETE 0
+#define DYNAMIC_INSERT 1
+
+typedef struct {
+  uint size;
+  uint allocated;
+  uint **neighbors;
+  uint *degree;
+  uint *capacity;
+  uint *triangles;
+  unsigned long long total;
+  unsigned long long edges;
+} dynamic_graph;
+
+typedef struct {
+  uint u;
+  uint v;
+  int insert;
+} edge_update;
+
+// What a batch did. The ignored updates didn't change the graph.
+typedef struct {
+  uint inserted;
+  uint deleted;
+  uint ignored;
+  long long change;
+} batch_result;
+
+dynamic_graph dynamicFromCSR(csr table, int threads);
+batch_result dynamicUpdate(dynamic_graph *graph, edge_update *updates, uint count, int threads);
+int dynamicHasEdge(dynamic_graph *graph, uint u, uint v);
+uint *dynamicRecount(dynamic_graph *graph, int threads);
+csr dynamicToCSR(dynamic_graph *graph);
+void freeDynamicGraph(dynamic_graph *graph);
+
+#endif
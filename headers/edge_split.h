@@ -0,0 +1,45 @@
+/*
+ * edge_split.h
+ * Edge-parallel execution mode. Instead of giving each thread a range of rows,
+ * the nonzeros of the table are cut into tasks of roughly equal work, so the
+ * neighbors of a single hub row can be shared by many threads.
+ *
+ * @param first: The first nonzero (index in colIndex) of the task.
+ * @param last: One past the last nonzero of the task.
+ * @param row: The row that contains the first nonzero.
+ */
+
+#ifndef EDGE_SPLIT_H
+#define EDGE_SPLIT_H
+
+#include <stdio.h>
+#include "csr.h"
+#include "numa_helpers.h"
+
+// How many tasks each thread should get on average. More tasks give the
+// dynamic scheduler more room to balance the hub rows.
+#define TASKS_PER_THREAD 16
+
+typedef struct {
+  uint first;
+  uint last;
+  uint row;
+} edge_task;
+
+// @param tasks: The tasks, ordered by their first nonzero.
+// @param count: The number of tasks.
+// @param threshold: The work (in compared elements) a task is cut at.
+// @param splitRows: How many rows were split into more than one task.
+typedef struct {
+  edge_task *tasks;
+  uint count;
+  unsigned long threshold;
+  uint splitRows;
+} edge_tasks;
+
+edge_tasks makeEdgeTasks(csr table, int threads);
+void runEdgeTask(csr table, edge_task task, uint *sums);
+uint *halveSums(uint *sums, uint size);
+uint *countTrianglesEdges(csr table, int threads, numa_plan *plan);
+
+#endif
@@ -0,0 +1,58 @@
+/*
+ * generator.h
+ * Synthetic graphs for scaling studies, built in parallel straight into CSR,
+ * and a binary snapshot format that loads without parsing text.
+ *
+ * A graph is described by a spec string: kind:scale[:edgefactor[:seed]]
+ *   rmat:20:16    R-MAT (Kronecker) power-law graph, 2^20 vertices, 16 * 2^20 edges drawn.
+ *   er:20:16      Erdos-Renyi (uniform) graph, same sizes.
+ *   grid2d:20     Triangulated 2D mesh of about 2^20 vertices (the edge factor is ignored).
+ *   grid3d:21     3D lattice with the diagonals of its faces, about 2^21 vertices.
+ *                 The side of a mesh is 2^(scale / 2) or 2^(scale / 3), rounded.
+ * The default edge factor is 16 and the default seed is 1.
+ *
+ * Every edge is drawn from its own index and the seed, so the graph only depends on
+ * the spec, never on the number of threads. Self loops and duplicate edges are dropped.
+ */
+
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include "csr.h"
+
+#define GRAPH_RMAT 0
+#define GRAPH_ER 1
+#define GRAPH_GRID2D 2
+#define GRAPH_GRID3D 3
+
+// The default R-MAT probabilities of the Graph500 benchmark. d = 1 - a - b - c.
+#define RMAT_A 0.57
+#define RMAT_B 0.19
+#define RMAT_C 0.19
+
+#define SNAPSHOT_MAGIC 0x52534354 // "TCSR"
+#define SNAPSHOT_VERSION 1
+
+typedef struct {
+  int kind;
+  uint scale;
+  uint edgeFactor;
+  unsigned long long seed;
+} graph_spec;
+
+int isGraphSpec(char *name);
+int parseGraphSpec(char *name, graph_spec *spec);
+void formatGraphSpec(graph_spec spec, char *name, size_t length);
+csr generateGraph(graph_spec spec, int threads);
+// The i-th number of the random stream of seed, for anything else that must not depend
+// on the number of threads.
+unsigned long long splitmix64(unsigned long long seed, unsigned long long i);
+
+int isSnapshot(char *path);
+int writeSnapshot(char *path, csr table);
+csr readSnapshot(char *path);
+int writeMatrixMarket(char *path, csr table);
+
+csr loadGraph(char *graph);
+
+#endif
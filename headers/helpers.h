@@ -5,10 +5,13 @@
 
 // Final version of the functions used.
 csr readmtx_dynamic(char *mtx, MM_typecode *t, int N, int M, int nz);
+csr_arg *splitRows(csr table, int max_threads);
 csr_arg *makeThreadArguments(csr table, int max_threads);
+void freeThreadArguments(csr_arg *csr_args, int max_threads);
 csr hadamardSingleStep(csr table, uint start, uint end);
 int dot(csr table, uint row, uint column);
 uint *countTriangles(csr C);
 void printCSR(csr converted);
+void freeCSR(csr table);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,40 @@
+/*
+ * intersect.h
+ * Kernels that count the common elements of two sorted lists of distinct columns.
+ * For a binary table this is exactly what dot() computes for two rows.
+ *
+ *   merge:     one pass over both lists. O(sizeA + sizeB).
+ *   galloping: exponential then binary search of every element of the short list
+ *              in the long one. O(short * log(long / short)), best for skewed pairs.
+ *   simd:      compares blocks of 4 x 4 elements at once (SSE2). Falls back to merge
+ *              on other architectures.
+ *   hash:      inserts the short list in an open addressing table and probes it with
+ *              the long one. Pays off when one list is intersected with many.
+ *   adaptive:  galloping when the lists are INTERSECT_GALLOP_RATIO times apart, simd when
+ *              both are at least INTERSECT_SIMD_MIN long, merge otherwise.
+ *
+ * firstAbove() finds where the columns of a row pass a value, like the upper triangle
+ * of a row, that the kernels then intersect.
+ *
+ * The thresholds come from the micro-benchmark (make microbench), that prints the values
+ * it measured on the machine it ran on.
+ */
+
+#ifndef INTERSECT_H
+#define INTERSECT_H
+
+#include "csr.h"
+
+#define INTERSECT_GALLOP_RATIO 32
+#define INTERSECT_SIMD_MIN 8
+
+typedef uint (*intersect_kernel)(uint *a, uint sizeA, uint *b, uint sizeB);
+
+uint firstAbove(csr table, uint row, uint value);
+uint intersectMerge(uint *a, uint sizeA, uint *b, uint sizeB);
+uint intersectGalloping(uint *a, uint sizeA, uint *b, uint sizeB);
+uint intersectSIMD(uint *a, uint sizeA, uint *b, uint sizeB);
+uint intersectHash(uint *a, uint sizeA, uint *b, uint sizeB);
+uint intersectAdaptive(uint *a, uint sizeA, uint *b, uint sizeB);
+
+#endif
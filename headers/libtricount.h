@@ -0,0 +1,82 @@
+/*
+ * libtricount.h
+ * The C API of libtricount.so and libtricount.a (make lib), to count triangles inside
+ * another process: no files to write and no process to spawn per query.
+ *
+ * A graph is an opaque handle. It's either loaded like tricount loads its graphs (a .mtx
+ * file, a .csr snapshot or a generator spec), or wraps CSR arrays the caller owns,
+ * without copying them: a symmetric binary matrix, 0-based, with sorted columns and
+ * no duplicates in each row. Those arrays must outlive the handle and stay unchanged.
+ * The kernels multiply the values of the table, so a wrapped graph still allocates
+ * them, an int of 1 per nonzero.
+ * The results are written to buffers the caller owns too.
+ *
+ * Every function returns TRICOUNT_OK or one of the negative errors, except the ones that
+ * return a handle, which return NULL on failure. Different graphs can be counted from
+ * different threads at the same time. The progress lines of the drivers are compiled
+ * out (see headers/progress.h), so only a failure to read a graph prints anything.
+ *
+ * The API only grows: existing functions and fields keep their meaning, and
+ * TRICOUNT_API_VERSION goes up when something is added.
+ *
+ * @param backend: The name of a backend, like tricount -l lists them (serial, pthreads, openmp, ...).
+ *   NULL for the fastest one this build has.
+ * @param threads: 0 for the number of cpus. The serial backend ignores it.
+ * @param mode: TRICOUNT_ROWS gives every thread a range of rows, TRICOUNT_EDGES hands out
+ *   pieces of the nonzeros dynamically (the -edge backends), which balances hub rows.
+ */
+
+#ifndef LIBTRICOUNT_H
+#define LIBTRICOUNT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TRICOUNT_API_VERSION 2
+
+// The library is built with hidden symbols, so only these functions are exported.
+#if defined(TRICOUNT_LIBRARY) && defined(__GNUC__)
+#define TRICOUNT_API __attribute__((visibility("default")))
+#else
+#define TRICOUNT_API
+#endif
+
+#define TRICOUNT_OK 0
+#define TRICOUNT_ERROR_ARGUMENT -1
+#define TRICOUNT_ERROR_BACKEND -2
+#define TRICOUNT_ERROR_MEMORY -3
+
+#define TRICOUNT_ROWS 0
+#define TRICOUNT_EDGES 1
+
+typedef struct tricount_graph tricount_graph;
+
+typedef struct {
+  const char *backend;
+  int threads;
+  int mode;
+} tricount_options;
+
+TRICOUNT_API int tricountVersion();
+TRICOUNT_API const char *tricountError(int error);
+TRICOUNT_API int tricountBackends(const char **names, int max);
+
+TRICOUNT_API tricount_graph *tricountLoad(const char *path);
+TRICOUNT_API tricount_graph *tricountWrap(unsigned int vertices, const unsigned int *rowIndex, const unsigned int *colIndex);
+TRICOUNT_API void tricountFree(tricount_graph *graph);
+TRICOUNT_API unsigned int tricountVertices(const tricount_graph *graph);
+TRICOUNT_API unsigned long long tricountNonzeros(const tricount_graph *graph);
+
+TRICOUNT_API void tricountDefaultOptions(tricount_options *options);
+TRICOUNT_API int tricountCount(tricount_graph *graph, const tricount_options *options, unsigned int *triangles,
+  unsigned long long *total);
+// Since version 2.
+TRICOUNT_API int tricountCountSubset(tricount_graph *graph, const tricount_options *options,
+  const unsigned int *vertices, unsigned int count, unsigned int *triangles);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,43 @@
+/*
+ * listing.h
+ * Lists every triangle (u, v, w), u < v < w, once, instead of counting them.
+ *
+ * The workers take blocks of LISTING_BLOCK_ROWS rows u with an atomic counter and merge
+ * the row of u with the row of every neighbor v above it, for the w above v. Every
+ * worker writes its own file, <prefix>.<worker>.bin or .txt, from two buffers of its
+ * own: while it fills one, the other is being written with aio_write(), so the workers
+ * share nothing but the counter and never wait for each other, only for the disk.
+ *
+ * Binary: three uint32 per triangle, 0-based, in the byte order of the machine.
+ * Text: "u v w" per line, 1-based like the .mtx files.
+ * Self loops are ignored.
+ *
+ * @param triangles, bytes: Listed and written, by all the workers.
+ * @param files: The number of files written, one per worker. 0 if one couldn't be.
+ * @param time: In us, the last write included.
+ */
+
+#ifndef LISTING_H
+#define LISTING_H
+
+#include "csr.h"
+
+#define LISTING_BINARY 0
+#define LISTING_TEXT 1
+
+// The size of each of the two buffers of a worker.
+#define LISTING_BUFFER_BYTES (4 << 20)
+// The rows a worker takes at a time.
+#define LISTING_BLOCK_ROWS 64
+
+typedef struct {
+  unsigned long long triangles;
+  unsigned long long bytes;
+  int files;
+  double time;
+} listing_result;
+
+listing_result listTriangles(csr table, char *prefix, int format, int threads);
+void listingFileName(char *name, size_t length, char *prefix, int format, int worker);
+
+#endif
@@ -0,0 +1,40 @@
+/*
+ * memory.h
+ * Accounting of the heap, per phase and per run, and the peak resident set size.
+ *
+ * malloc() and the rest of the allocator are wrapped (see head/memory.c), so every
+ * allocation of the program counts: readmtx_dynamic(), makeThreadArguments(), the
+ * backends and the threading runtimes alike. While the accounting is off, a wrapped
+ * call only costs a check of a flag. Turn it on before the graphs are read, so that
+ * every block it sees freed was counted when it was allocated.
+ *
+ * The phases are the ones of trace.h: traceStart() and traceRecord() take the usage
+ * of the calling thread in between.
+ *
+ * @param allocated: The bytes the thread allocated during the phase.
+ * @param retained: The bytes it allocated minus the ones it freed, what the phase left behind.
+ * @param peak: The most bytes it held at once during the phase, over what it held at its start.
+ */
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#define MEMORY_MB (1024.0 * 1024.0)
+
+typedef struct {
+  long long allocated;
+  long long retained;
+  long long peak;
+} memory_usage;
+
+extern int memory_enabled;
+
+void memoryEnable();
+void memoryPhaseStart();
+memory_usage memoryPhaseEnd();
+void memoryResetPeak();
+long long memoryLive();
+long long memoryPeak();
+long long memoryPeakRSS();
+
+#endif
@@ -0,0 +1,51 @@
+/*
+ * numa_helpers.h
+ * Everything needed to run the parallel algorithms in NUMA mode:
+ * thread pinning, first-touch placement of the CSR arrays according to
+ * the row partition, optional per-node replicas of the read-only table
+ * and a report of how many adjacency reads stay on the local node.
+ *
+ * No libnuma is required. The topology is read from sysfs and page placement
+ * is queried through the move_pages() system call.
+ */
+
+#ifndef NUMA_HELPERS_H
+#define NUMA_HELPERS_H
+
+#include <stdio.h>
+#include "csr.h"
+#include "csr_arg.h"
+
+// @param nodes: The number of NUMA nodes (at least 1).
+// @param cpus: The number of cpus found.
+// @param cpuNode: The node each cpu belongs to.
+typedef struct {
+  int nodes;
+  int cpus;
+  int *cpuNode;
+} numa_topology;
+
+// @param threads: The number of workers the plan was made for.
+// @param cpus: The cpu each worker is pinned to. -1 means the worker isn't pinned.
+// @param nodes: The node each worker runs on.
+// @param replicate: Non zero if every node gets its own copy of the table.
+// @param replicas: One table per node. All point to the same arrays if replicate == 0.
+typedef struct {
+  numa_topology topology;
+  int threads;
+  int *cpus;
+  int *nodes;
+  int replicate;
+  csr *replicas;
+} numa_plan;
+
+numa_topology readTopology();
+numa_plan makeNumaPlan(int threads, char *affinity, int replicate);
+int pinThread(int cpu);
+csr firstTouchCSR(csr table, csr_arg *args, numa_plan *plan);
+void replicateCSR(csr table, numa_plan *plan);
+csr numaTable(numa_plan *plan, int worker);
+void reportNumaAccess(csr_arg *args, numa_plan *plan);
+void freeNumaPlan(numa_plan *plan);
+
+#endif
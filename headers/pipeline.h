@@ -0,0 +1,30 @@
+/*
+ * pipeline.h
+ * Pipelined mode: the triangles of a block of rows are counted while the rest
+ * of the .mtx file is still being read.
+ *
+ * @param table: The whole table, once the file has been read. Same as readmtx_dynamic().
+ * @param triangles: The triangles of every vertex.
+ * @param pipelined: 0 if the file wasn't sorted and the counting had to wait for the whole file.
+ * @param loadTime: The time (in us) until the last line of the file was read.
+ */
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdio.h>
+#include "csr.h"
+
+// The rows in each block that's handed to the counting threads.
+#define PIPELINE_BLOCK_ROWS 256
+
+typedef struct {
+  csr table;
+  uint *triangles;
+  int pipelined;
+  double loadTime;
+} pipeline_result;
+
+pipeline_result countTrianglesPipelined(char *mtx, int threads);
+
+#endif
@@ -0,0 +1,49 @@
+/*
+ * pool.h
+ * Counts the triangles of many graphs at once, on one pool of worker threads.
+ *
+ * Every worker takes the next graph of the list, with an atomic counter, and loads it.
+ * A small graph, up to large nonzeros, is counted there and then by the worker alone, so
+ * the small graphs are loaded and counted side by side, one per worker. A large one is
+ * cut into POOL_BLOCKS_PER_THREAD blocks of rows per worker (makeThreadArguments()) and
+ * published: every worker takes its blocks before it takes another graph, so the whole
+ * pool counts it, and the one that finishes its last block records it.
+ * Each block is hadamardSingleStep() and countTriangles(), the serial backend on a slice.
+ *
+ * @param graph: As given in the list. A .mtx file, a .csr snapshot or a generator spec.
+ * @param loaded: 0 if the graph couldn't be read. Nothing else is set then.
+ * @param shared: 1 if the whole pool counted it, 0 if one worker did.
+ * @param worker: The worker that loaded it.
+ * @param triangles, checksum: Of the per-vertex counts, as summarizeTriangles() gives them.
+ * @param loadTime, countTime: In us. The count of a shared graph runs from its publication
+ *                             to its last block.
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#include "csr.h"
+
+#define POOL_BLOCKS_PER_THREAD 4
+// The nonzeros above which a graph is shared by the whole pool, unless given.
+#define POOL_LARGE_NONZEROS (1u << 20)
+
+typedef struct {
+  char *graph;
+  int loaded;
+  int shared;
+  int worker;
+  uint vertices;
+  uint nonzeros;
+  unsigned long long triangles;
+  unsigned long long checksum;
+  double loadTime;
+  double countTime;
+} pool_result;
+
+char **readManifest(char *path, int *count);
+void freeManifest(char **graphs, int count);
+pool_result *countGraphs(char **graphs, int count, int threads, uint large);
+int writePoolResults(char *path, pool_result *results, int count);
+
+#endif
@@ -0,0 +1,19 @@
+/*
+ * progress.h
+ * The progress lines that the readers and the backends print for the drivers. The
+ * library (TRICOUNT_LIBRARY) compiles them out, so that it never writes to the stdout
+ * of the process it's in.
+ */
+
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <stdio.h>
+
+#ifdef TRICOUNT_LIBRARY
+#define PROGRESS(...) ((void) 0)
+#else
+#define PROGRESS(...) printf(__VA_ARGS__)
+#endif
+
+#endif
@@ -0,0 +1,51 @@
+/*
+ * regression.h
+ * Compares the runs to a baseline (a results.json of an earlier run) and flags the
+ * ones that got slower.
+ *
+ * A run regressed when its median is more than threshold slower than the baseline's
+ * and the one-sided Mann-Whitney U test says its times are larger with p < REGRESSION_ALPHA.
+ * The test only looks at the ranks of the times, so a few outliers in either run can't
+ * make or hide a regression. It uses the normal approximation of U with the tie
+ * correction, which needs about 8 times on each side; the runs get REGRESSION_MIN_REPS.
+ *
+ * @param baseline, median: The medians of the baseline and of the new run, in us.
+ * @param change: (median - baseline) / baseline. Positive when the run got slower.
+ * @param p: The p value of the test in the direction of the change.
+ * @param verdict: REGRESSION_SAME, REGRESSED, IMPROVED, NEW if the baseline didn't have the run,
+ *                 or MISSING if the baseline has a run that wasn't run again.
+ */
+
+#ifndef REGRESSION_H
+#define REGRESSION_H
+
+#include "bench.h"
+
+#define REGRESSION_THRESHOLD 0.05
+#define REGRESSION_ALPHA 0.01
+#define REGRESSION_MIN_REPS 20
+
+#define REGRESSION_SAME 0
+#define REGRESSION_REGRESSED 1
+#define REGRESSION_IMPROVED 2
+#define REGRESSION_NEW 3
+#define REGRESSION_MISSING 4
+
+typedef struct {
+  char *graph;
+  char *backend;
+  int threads;
+  double baseline;
+  double median;
+  double change;
+  double p;
+  int verdict;
+} regression_row;
+
+double mannWhitneyGreater(double *a, int countA, double *b, int countB);
+int compareToBaseline(bench_result *results, int count, bench_result *baseline, int baseline_num,
+  double threshold, regression_row *rows);
+void printRegressions(regression_row *rows, int count);
+void writeRegressionCSV(char *path, regression_row *rows, int count, bench_meta meta);
+
+#endif
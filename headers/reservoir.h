@@ -0,0 +1,42 @@
+/*
+ * reservoir.h
+ * One pass triangle estimates over a stream of edges that never becomes a table, in a
+ * fixed amount of memory (TRIEST-IMPR, De Stefani et al.).
+ *
+ * The stream is a .mtx file, an edge list (one "u v" per line, 0-based, # or % comments),
+ * or for testing a .csr snapshot or a generator spec, whose edges are streamed from the table.
+ * A reservoir keeps a uniform sample of RESERVOIR_EDGE_BYTES bytes per edge, up to the
+ * memory of the options, whatever the number of vertices. Every edge (u, v) first adds the triangles it closes in the
+ * sample, N(u) and N(v), to the estimates of u, v, the third vertex and the graph, weighted
+ * by the inverse of the chance that both other edges are still in it. Then it replaces a
+ * random edge of the sample with probability size / edges seen. The estimates are unbiased
+ * and exact while the whole stream fits.
+ *
+ * The threads are shards, each with its own reservoir and an equal part of the memory.
+ * Every vertex gets one of shards colors from the seed, and a shard only keeps the edges
+ * whose ends both have its color (Pagh and Tsourakakis). A triangle is in a shard with
+ * probability 1 / shards^2, so the merged estimates are the sums of the shards times
+ * shards^2, and the shards never need to talk to each other. The file is read in chunks
+ * of RESERVOIR_CHUNK edges, that the shards go through in parallel.
+ *
+ * Only the vertices of the sample have state, counted in the bytes of their edges. When a
+ * vertex leaves the sample, its estimate is kept only if it's among the top ones of its
+ * shard, so a vertex that leaves and comes back can lose what it had. On top of the
+ * reservoirs, the chunk being read takes 12 bytes per edge.
+ */
+
+#ifndef RESERVOIR_H
+#define RESERVOIR_H
+
+#include "csr.h"
+#include "sampling.h"
+
+// At most: the edge itself (8), both of its ends in the neighbor blocks, which are never
+// more than twice as large as their content (16), and the entries of its two vertices (56)
+// with their slots in the map, that is at most half full (32).
+#define RESERVOIR_EDGE_BYTES 112
+#define RESERVOIR_CHUNK 65536
+
+sample_result estimateStream(char *path, sample_options options);
+
+#endif
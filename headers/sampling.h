@@ -0,0 +1,92 @@
+/*
+ * sampling.h
+ * Approximate triangle counts with confidence intervals, for graphs where the exact
+ * count is more than needed. Self loops are ignored, so the estimates are of the true
+ * number of triangles.
+ *
+ *   doulion: keeps every edge with probability p, counts the triangles of the sparse
+ *            graph exactly and scales them by 1 / p^3 (Tsourakakis et al., DOULION).
+ *            The sparse graph has about p^2 of the work of the whole one. The interval
+ *            comes from the spread of independent sparsifications (Student's t).
+ *   wedge:   draws wedges (paths u - v - w) uniformly, with centers weighted by their
+ *            number of wedges, and checks which are closed (Seshadhri et al.).
+ *            triangles = closed fraction * wedges / 3. The interval is Wilson's, of the
+ *            closed fraction. Each sample costs a binary search.
+ *   triest:  one pass over the edges of the file, that is never loaded, with a fixed
+ *            reservoir of them (see reservoir.h). No interval.
+ *
+ * Both run in rounds, that double, until the half width of the interval is at most
+ * error times the estimate, the budget is spent, or SAMPLE_MAX_ROUNDS. Without a budget,
+ * it's SAMPLE_DEFAULT_BUDGET of the time the exact count would take, estimated from a
+ * pass over the edges, so that the targets of top can't take longer than counting. The vertices of
+ * top (the ones of highest degree) get their own estimates too: from the same sparse
+ * graphs with doulion, and from wedges centered on them with wedge, until they reach the
+ * same error.
+ *
+ * Every sample and every kept edge is drawn from the seed and its own index, so the
+ * results only depend on the seed, never on the number of threads.
+ *
+ * @param memory: The bytes the reservoir of triest may take.
+ * @param estimate, low, high: The estimate and its SAMPLE_CONFIDENCE interval. NAN without one.
+ * @param samples: Wedges drawn, sparsifications counted, or edges streamed.
+ * @param converged: 1 if the error was reached before the budget.
+ * @param reached: The largest half width of the intervals, as a fraction of their estimates.
+ */
+
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include "csr.h"
+
+#define SAMPLE_DOULION 0
+#define SAMPLE_WEDGE 1
+#define SAMPLE_TRIEST 2
+
+#define SAMPLE_CONFIDENCE 0.95
+#define SAMPLE_Z 1.959964
+// At most 2^11 times the first round: 134M wedges, 8192 sparsifications.
+#define SAMPLE_MAX_ROUNDS 12
+// Wedges of the first round. Every round draws as many as all the previous ones.
+#define SAMPLE_FIRST_WEDGES 65536
+// doulion needs a few sparsifications before their spread means anything.
+#define SAMPLE_MIN_REPLICAS 4
+// The fraction of the estimated time of the exact count that sampling gets by default.
+#define SAMPLE_DEFAULT_BUDGET 0.5
+
+typedef struct {
+  int method;
+  double error;
+  double budget;
+  double probability;
+  uint top;
+  unsigned long long seed;
+  int threads;
+  double memory;
+} sample_options;
+
+typedef struct {
+  double estimate;
+  double low;
+  double high;
+  unsigned long long samples;
+} sample_estimate;
+
+typedef struct {
+  sample_estimate total;
+  uint top;
+  uint *vertices;
+  sample_estimate *vertex;
+  int rounds;
+  int converged;
+  double reached;
+  double time;
+} sample_result;
+
+sample_options defaultSampleOptions();
+int parseSampleMethod(char *name);
+const char *sampleMethodName(int method);
+sample_result estimateTriangles(csr table, sample_options options);
+unsigned long long exactTriangles(csr table, int threads, uint *triangles);
+void freeSampleResult(sample_result *result);
+
+#endif
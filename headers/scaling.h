@@ -0,0 +1,49 @@
+/*
+ * scaling.h
+ * Strong and weak scaling sweeps: the thread counts to run, and the speedup,
+ * efficiency and Karp-Flatt serial fraction of every backend at each of them.
+ *
+ * Strong scaling keeps the graph and adds threads:
+ *   speedup S(p) = T(1) / T(p), efficiency E(p) = S(p) / p.
+ * Weak scaling doubles the graph with the threads (scale + log2(p)), so ideally T(p) = T(1):
+ *   scaled speedup S(p) = p * T(1) / T(p), efficiency E(p) = T(1) / T(p).
+ * Karp-Flatt: e(p) = (1/S(p) - 1/p) / (1 - 1/p). A serial fraction that grows with p
+ * points at overhead (synchronization, imbalance), a constant one at serial code.
+ *
+ * @param serialSpeedup: S(p) against the serial backend instead of the backend's own
+ *   single thread run. 0 if the serial backend didn't run.
+ * @param oversubscribed: 1 if the run had more threads than cpus.
+ * @param knee: 1 for the last point whose speedup was still at least SCALING_KNEE
+ *   times the one before it. Beyond the knee, adding threads barely pays.
+ */
+
+#ifndef SCALING_H
+#define SCALING_H
+
+#include "bench.h"
+
+#define SCALING_KNEE 1.10
+
+#define SCALING_STRONG 0
+#define SCALING_WEAK 1
+
+typedef struct {
+  int mode;
+  char *graph;
+  char *backend;
+  int threads;
+  int oversubscribed;
+  double time;
+  double speedup;
+  double serialSpeedup;
+  double efficiency;
+  double karpFlatt;
+  int knee;
+} scaling_point;
+
+int sweepThreads(int *threads, int max, int weak);
+int computeScaling(bench_result *results, int count, int mode, scaling_point *points);
+void printScaling(scaling_point *points, int count);
+void writeScalingCSV(char *path, scaling_point *points, int count, bench_meta meta);
+
+#endif
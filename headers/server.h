@@ -0,0 +1,51 @@
+/*
+ * server.h
+ * A resident daemon: the graphs are loaded once and the queries come over a Unix socket.
+ *
+ * Nothing is counted at startup. The first query on a graph computes, under the lock of
+ * the graph, the support of every nonzero with edgeSupport() (in parallel), the triangles
+ * of every vertex from it, and their total, and every later query is answered from them.
+ * Until then, TRIANGLES and CLUSTERING of given vertices only count those (see subset.h).
+ * The counts are those of the backends, (A .* A^2) / 2 by row. Every client gets a thread.
+ *
+ * The protocol is a line per query and a reply of "OK <lines>" and that many lines, or
+ * "ERR <reason>". The vertices are 1-based, like the .mtx files. Fields are tab separated.
+ *   GRAPHS                      name, vertices and nonzeros of every graph.
+ *   COUNT <graph>               the triangles of the graph.
+ *   TRIANGLES <graph> [v ...]   "v triangles", of every vertex if none are given.
+ *   CLUSTERING <graph> [v ...]  the local clustering coefficient of the vertices, or with
+ *                               none, "transitivity" (3 triangles / wedges) and "average".
+ *   SUBSET <graph> v ...        the triangles with all three vertices among the given ones.
+ *   SUPPORT <graph> [u v ...]   "u v support" of the edges (u, v), of every u < v if none.
+ *   QUIT                        closes the connection. SHUTDOWN stops the daemon.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <pthread.h>
+#include "csr.h"
+
+#define SERVER_SOCKET "/tmp/tricount.sock"
+#define SERVER_BACKLOG 16
+
+// @param cached: 1 once the first query has computed support, triangles, total and wedges.
+// @param computeTime: In us, what the first query took.
+typedef struct {
+  char *name;
+  csr table;
+  pthread_mutex_t lock;
+  int cached;
+  int *support;
+  uint *triangles;
+  unsigned long long total;
+  unsigned long long wedges;
+  double computeTime;
+} served_graph;
+
+served_graph *loadServedGraphs(char **graphs, int count);
+int serveQueries(char *socketPath, served_graph *graphs, int count, int threads);
+int sendQuery(char *socketPath, char *query);
+void freeServedGraphs(served_graph *graphs, int count);
+
+#endif
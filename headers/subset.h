@@ -0,0 +1,25 @@
+/*
+ * subset.h
+ * The triangles of a few vertices, without counting the rest of the graph.
+ *
+ * The count of a vertex v is its row of A .* A^2 by 2, like the backends give it: the
+ * sum, over every neighbor u of v, of the common neighbors of the two rows, which
+ * intersectAdaptive() counts. Only the rows of the subset and of their neighbors are read,
+ * so the time is proportional to the neighborhoods of the subset, not to the graph.
+ * The pairs (v, u) of every vertex of the subset and every neighbor are handed out to
+ * the threads in chunks of SUBSET_CHUNK, so a hub of the subset is shared by all of them.
+ *
+ * The counts are in the order of the vertices given, repeated ones included.
+ */
+
+#ifndef SUBSET_H
+#define SUBSET_H
+
+#include "csr.h"
+
+#define SUBSET_CHUNK 64
+
+uint *countSubsetTriangles(csr table, uint *vertices, uint count, int threads);
+uint *readVertexList(char *source, uint size, uint *count);
+
+#endif
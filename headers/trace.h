@@ -0,0 +1,47 @@
+/*
+ * trace.h
+ * Low overhead timers for the phases of every backend and for each of their workers.
+ * When tracing is off, recording an event only costs a check of a flag.
+ * When the hardware counters are on too, every event also gets their counts over the phase.
+ * When the memory accounting is on, it gets the heap usage of its thread too (see memory.h).
+ * A thread runs one phase at a time, so phases of the same thread must not overlap.
+ *
+ * @param name: The phase (partition, hadamard, count, stitch, ...).
+ * @param worker: The thread that ran it. TRACE_MAIN for the calling thread.
+ * @param start, end: In us, from nowMicros().
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+
+#include "counters.h"
+#include "memory.h"
+
+#define TRACE_MAIN -1
+#define TRACE_CAPACITY 65536
+
+typedef struct {
+  const char *name;
+  int worker;
+  double start;
+  double end;
+  int counted;
+  long long counters[COUNTERS_NUM];
+  memory_usage memory;
+} trace_event;
+
+extern int trace_enabled;
+
+void traceEnable(int enable);
+void traceReset();
+double traceStart();
+void traceRecord(const char *name, int worker, double start);
+void traceReport(const char *label, unsigned int edges);
+int traceTotals(long long *totals);
+FILE *traceOpen(char *path);
+void traceWrite(FILE *file, int process, const char *label);
+void traceClose(FILE *file);
+
+#endif
@@ -0,0 +1,48 @@
+/*
+ * truss.h
+ * k-truss decomposition: the trussness of every edge, the largest k such that the edge
+ * is in a subgraph where every edge closes at least k - 2 triangles.
+ *
+ * The support of every edge, the triangles it closes, is A .* A^2, so it comes from
+ * hadamardSingleStep() on slices of the rows, in parallel. Then the edges are peeled level
+ * by level (Kabir and Madduri, PKT): the frontier of a level is every edge left with
+ * support at most the level. Every frontier edge (u, v) decrements, with atomics, the
+ * support of the two other edges of each of its triangles that are still there, and an
+ * edge that drops to the level joins the next frontier of the same level. A triangle with
+ * two edges in the same frontier is only counted by the smaller one. The trussness of a
+ * peeled edge is its level + 2.
+ *
+ * Self loops are dropped first: they aren't edges of any triangle.
+ *
+ * @param edges: Every edge once, u < v, in the order of the table.
+ * @param trussness: Of every edge. 2 for the edges of no triangle.
+ * @param levels: The number of levels there were edges to peel on.
+ * @param supportTime, peelTime: In us.
+ */
+
+#ifndef TRUSS_H
+#define TRUSS_H
+
+#include "csr.h"
+
+// Slices of rows per thread for the support, so that the dynamic schedule can balance them.
+#define TRUSS_SLICES_PER_THREAD 4
+
+typedef struct {
+  unsigned long long edges;
+  uint *u;
+  uint *v;
+  uint *trussness;
+  uint maxTruss;
+  uint levels;
+  double supportTime;
+  double peelTime;
+} truss_result;
+
+// The value of every nonzero of the table in A .* A^2, in the order of the table.
+int *edgeSupport(csr table, int threads);
+truss_result trussDecomposition(csr table, int threads);
+int writeTrussness(char *path, truss_result result);
+void freeTrussResult(truss_result *result);
+
+#endif
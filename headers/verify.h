@@ -0,0 +1,40 @@
+/*
+ * verify.h
+ * Checks the triangles of every backend against an independent reference.
+ *
+ * The reference computes the same counts as the backends, (A .* A^2) / 2 by row, by
+ * marking the neighbors of every vertex in a table, so it shares no code with dot()
+ * or the partitioners. It's only computed for
+ * graphs up to VERIFY_MAX_NONZEROS. On larger graphs, the backends are compared to the
+ * first one that ran, by their total and a 64-bit checksum of the per-vertex counts.
+ *
+ * @param total: The number of triangles (the per-vertex counts add up to 3 times it).
+ * @param checksum: Depends on every count and on the vertex it belongs to.
+ * @param status: VERIFY_OK, VERIFY_MISMATCH, or VERIFY_NONE when nothing was checked.
+ * @param mismatches, first: How many vertices differ from the reference, and the first one.
+ */
+
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include "csr.h"
+
+#define VERIFY_MAX_NONZEROS (1u << 24)
+
+#define VERIFY_NONE -1
+#define VERIFY_MISMATCH 0
+#define VERIFY_OK 1
+
+typedef struct {
+  unsigned long long total;
+  unsigned long long checksum;
+  int status;
+  uint mismatches;
+  uint first;
+} verify_result;
+
+uint *referenceTriangles(csr table);
+verify_result summarizeTriangles(uint *triangles, uint size);
+verify_result verifyTriangles(uint *triangles, uint *reference, verify_result *expected, uint size);
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * ktruss.c
+ *
+ * The trussness of every edge of a graph (see headers/truss.h), with the number of
+ * edges of every k-truss.
+ *
+ * Usage: ./ktruss [-t threads] [-o csv] <graph>
+ *   graph: a .mtx file, a .csr snapshot or a generator spec, like tricount takes.
+ *   -t: default: the number of cpus.
+ *   -o: one row per edge, u < v, 1-based (default: stats/truss.csv).
+ *
+ * Authors: Antonios Antoniou - 9482 - aantonii@ece.auth.gr
+ *          Efthymios Grigorakis - 9694 - eegrigor@ece.auth.gr
+ *
+ * 2021 Aristotle University of Thessaloniki
+ * Parallel and Distributed Systems.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "headers/csr.h"
+#include "headers/mmio.h"
+#include "headers/helpers.h"
+#include "headers/bench.h"
+#include "headers/generator.h"
+#include "headers/truss.h"
+
+
+static void printUsage(char *program) {
+  printf("Usage: %s [-t threads] [-o csv] <graph>\n", program);
+}
+
+
+int main(int argc, char **argv) {
+  int threads = sysconf(_SC_NPROCESSORS_ONLN);
+  char *csvName = "stats/truss.csv";
+
+  int option;
+  while ((option = getopt(argc, argv, "t:o:")) != -1) {
+    switch (option) {
+      case 't': threads = atoi(optarg); break;
+      case 'o': csvName = optarg; break;
+      default:
+        printUsage(argv[0]);
+        return 1;
+    }
+  }
+  if (optind != argc - 1) {
+    printUsage(argv[0]);
+    return 1;
+  }
+  threads = (threads < 1) ? 1 : threads;
+
+  char *name = graphName(argv[optind]);
+  csr table = loadGraph(argv[optind]);
+  if (table.rowIndex == NULL) {
+    return 1;
+  }
+
+  truss_result result = trussDecomposition(table, threads);
+  freeCSR(table);
+
+  printf("\n%s: %llu edges, max trussness %u, %u levels peeled, using %d threads.\n", name, result.edges,
+    result.maxTruss, result.levels, threads);
+  printf("Support %.0f us, peeling %.0f us, %.0f us in all.\n", result.supportTime, result.peelTime,
+    result.supportTime + result.peelTime);
+
+  // The edges of every k-truss: the ones with trussness k or more.
+  unsigned long long *counts = (unsigned long long *) calloc(result.maxTruss + 1, sizeof(unsigned long long));
+  for (unsigned long long e = 0; e < result.edges; e++) {
+    counts[result.trussness[e]]++;
+  }
+  unsigned long long inTruss = 0;
+  printf("%6s %14s %14s\n", "k", "trussness k", "in the k-truss");
+  for (uint k = result.maxTruss; k >= 2; k--) {
+    inTruss += counts[k];
+    if (counts[k] > 0) {
+      printf("%6u %14llu %14llu\n", k, counts[k], inTruss);
+    }
+  }
+
+  int written = writeTrussness(csvName, result);
+
+  free(counts);
+  freeTrussResult(&result);
+  free(name);
+  return written ? 0 : 1;
+}
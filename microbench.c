@@ -0,0 +1,321 @@
+/*
+ * microbench.c
+ *
+ * Micro-benchmark of the intersection kernels, away from the I/O and the partitioning.
+ * Every kernel runs on the same batches of sorted list pairs, for every length of the
+ * short list, every ratio of the long list to it and every density of matches.
+ * Reports the median time per element and per match over the trials, with the median
+ * absolute deviation (both ignore the outliers), and suggests the thresholds of
+ * intersectAdaptive() for this machine.
+ *
+ * Usage: ./microbench [-n trials] [-o csv]
+ *   -n: measured trials per kernel and pair shape (default: 11).
+ *   -o: the tidy results (default: stats/microbench.csv).
+ *
+ * Authors: Antonios Antoniou - 9482 - aantonii@ece.auth.gr
+ *          Efthymios Grigorakis - 9694 - eegrigor@ece.auth.gr
+ *
+ * 2021 Aristotle University of Thessaloniki
+ * Parallel and Distributed Systems.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "headers/csr.h"
+#include "headers/mmio.h"
+#include "headers/helpers.h"
+#include "headers/bench.h"
+#include "headers/intersect.h"
+
+// Different pairs of the same shape, so the branch predictor can't learn one of them.
+#define PAIRS 32
+// Every trial repeats the batch until it takes at least this long.
+#define MIN_TRIAL_US 200
+
+// dot() scans the rest of the column list for every element that isn't in it, so its
+// time grows with short x long. Larger pairs are skipped for it.
+#define DOT_MAX_WORK (1UL << 20)
+
+#define KERNELS_NUM 6
+
+static const int lengths[] = {8, 32, 128, 512};
+static const int ratios[] = {1, 2, 4, 8, 16, 32, 64, 128, 256};
+static const double densities[] = {0.05, 0.5};
+
+#define LENGTHS_NUM (sizeof(lengths) / sizeof(lengths[0]))
+#define RATIOS_NUM (sizeof(ratios) / sizeof(ratios[0]))
+#define DENSITIES_NUM (sizeof(densities) / sizeof(densities[0]))
+
+// Two sorted lists, and a table with them as rows 0 and 1 for dot().
+typedef struct {
+  uint *a;
+  uint sizeA;
+  uint *b;
+  uint sizeB;
+  csr table;
+  uint matches;
+} list_pair;
+
+
+static unsigned long long rng_state = 88172645463325252ULL;
+
+static unsigned long long nextRandom() {
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 7;
+  rng_state ^= rng_state << 17;
+  return rng_state;
+}
+
+
+// dot() as a kernel: the pair is rows 0 and 1 of its table.
+static list_pair *current_pair;
+
+static uint intersectDot(uint *a, uint sizeA, uint *b, uint sizeB) {
+  return dot(current_pair->table, 0, 1);
+}
+
+
+static const char *kernel_names[KERNELS_NUM] = {"dot", "merge", "galloping", "simd", "hash", "adaptive"};
+static intersect_kernel kernels[KERNELS_NUM] = {
+  intersectDot, intersectMerge, intersectGalloping, intersectSIMD, intersectHash, intersectAdaptive
+};
+
+
+static int compareUints(const void *x, const void *y) {
+  uint a = *(const uint *) x;
+  uint b = *(const uint *) y;
+  return (a > b) - (a < b);
+}
+
+
+// The long list takes even numbers with random gaps. The short list takes density of
+// its elements from the long one and the rest from odd numbers across the same range,
+// so that the matches are exactly the ones we picked.
+static list_pair makePair(uint sizeA, uint sizeB, double density) {
+  list_pair pair;
+  pair.sizeB = sizeB;
+  pair.b = (uint *) malloc(sizeB * sizeof(uint));
+  uint value = 0;
+  for (uint j = 0; j < sizeB; j++) {
+    value += 2 * (1 + nextRandom() % 4);
+    pair.b[j] = value;
+  }
+
+  uint matches = (uint) (sizeA * density + 0.5);
+  matches = (matches > sizeB) ? sizeB : matches;
+  pair.a = (uint *) malloc(sizeA * sizeof(uint));
+
+  // Distinct positions of the long list, spread evenly with a random offset.
+  for (uint i = 0; i < matches; i++) {
+    uint span = sizeB / matches;
+    pair.a[i] = pair.b[i * span + nextRandom() % span];
+  }
+  for (uint i = matches; i < sizeA; i++) {
+    pair.a[i] = (nextRandom() % (value + 2)) | 1;
+  }
+  qsort(pair.a, sizeA, sizeof(uint), compareUints);
+
+  // Drop the odd numbers drawn twice.
+  uint distinct = 0;
+  for (uint i = 0; i < sizeA; i++) {
+    if (distinct == 0 || pair.a[i] != pair.a[distinct - 1]) {
+      pair.a[distinct++] = pair.a[i];
+    }
+  }
+  pair.sizeA = distinct;
+  pair.matches = matches;
+
+  // Both lists as rows of a table, plus one more column, since dot() looks at colIndex[colEnd].
+  uint nonzeros = pair.sizeA + pair.sizeB;
+  pair.table.size = 2;
+  pair.table.rowIndex = (uint *) malloc(3 * sizeof(uint));
+  pair.table.rowIndex[0] = 0;
+  pair.table.rowIndex[1] = pair.sizeA;
+  pair.table.rowIndex[2] = nonzeros;
+  pair.table.colIndex = (uint *) malloc((nonzeros + 1) * sizeof(uint));
+  memcpy(pair.table.colIndex, pair.a, pair.sizeA * sizeof(uint));
+  memcpy(&pair.table.colIndex[pair.sizeA], pair.b, pair.sizeB * sizeof(uint));
+  pair.table.colIndex[nonzeros] = 0xFFFFFFFFu;
+  pair.table.values = (int *) malloc((nonzeros + 1) * sizeof(int));
+  for (uint i = 0; i <= nonzeros; i++) {
+    pair.table.values[i] = 1;
+  }
+
+  return pair;
+}
+
+
+static void freePair(list_pair pair) {
+  free(pair.a);
+  free(pair.b);
+  free(pair.table.rowIndex);
+  free(pair.table.colIndex);
+  free(pair.table.values);
+}
+
+
+// Runs the kernel over the batch. Returns the matches it found, which must be the same for every kernel.
+static unsigned long runBatch(intersect_kernel kernel, list_pair *pairs) {
+  unsigned long found = 0;
+  for (int p = 0; p < PAIRS; p++) {
+    current_pair = &pairs[p];
+    found += kernel(pairs[p].a, pairs[p].sizeA, pairs[p].b, pairs[p].sizeB);
+  }
+  return found;
+}
+
+
+// The median absolute deviation, as a fraction of the median.
+static double relativeMAD(double *times, int count, double median) {
+  double *deviations = (double *) malloc(count * sizeof(double));
+  for (int i = 0; i < count; i++) {
+    deviations[i] = fabs(times[i] - median);
+  }
+  double mad = computeStats(deviations, count).median;
+  free(deviations);
+  return (median > 0) ? mad / median : 0;
+}
+
+
+int main(int argc, char **argv) {
+  int trials = 11;
+  char *csvName = "stats/microbench.csv";
+
+  int option;
+  while ((option = getopt(argc, argv, "n:o:")) != -1) {
+    switch (option) {
+      case 'n': trials = atoi(optarg); break;
+      case 'o': csvName = optarg; break;
+      default:
+        printf("Usage: %s [-n trials] [-o csv]\n", argv[0]);
+        return 1;
+    }
+  }
+  trials = (trials < 1) ? 1 : trials;
+
+  FILE *file = fopen(csvName, "w");
+  if (file == NULL) {
+    printf("Couldn't write %s\n", csvName);
+    return 1;
+  }
+  fprintf(file, "kernel\tshort\tlong\tratio\tdensity\tmatches\tns_per_element\tns_per_match\tmad\ttrials\n");
+
+  // median ns per pair of every kernel and shape, summed over the densities, for the thresholds.
+  static double perPair[KERNELS_NUM][LENGTHS_NUM][RATIOS_NUM];
+  double *times = (double *) malloc(trials * sizeof(double));
+  int mismatches = 0;
+
+  printf("%-10s %6s %7s %6s %8s %14s %12s %7s\n", "kernel", "short", "long", "ratio", "density",
+    "ns/element", "ns/match", "mad");
+
+  for (int l = 0; l < LENGTHS_NUM; l++) {
+    for (int r = 0; r < RATIOS_NUM; r++) {
+      for (int d = 0; d < DENSITIES_NUM; d++) {
+        list_pair pairs[PAIRS];
+        unsigned long elements = 0;
+        for (int p = 0; p < PAIRS; p++) {
+          pairs[p] = makePair(lengths[l], lengths[l] * ratios[r], densities[d]);
+          elements += pairs[p].sizeA + pairs[p].sizeB;
+        }
+
+        unsigned long expected = runBatch(intersectMerge, pairs);
+        for (int k = 0; k < KERNELS_NUM; k++) {
+          if (kernels[k] == intersectDot && (unsigned long) lengths[l] * lengths[l] * ratios[r] > DOT_MAX_WORK) {
+            continue;
+          }
+
+          unsigned long found = runBatch(kernels[k], pairs);
+          if (found != expected) {
+            printf("%s found %lu matches instead of %lu (short %d, ratio %d).\n",
+              kernel_names[k], found, expected, lengths[l], ratios[r]);
+            mismatches++;
+          }
+
+          // Enough repetitions of the batch to measure it well above the clock's resolution.
+          int repeats = 1;
+          double start = nowMicros();
+          runBatch(kernels[k], pairs);
+          double once = nowMicros() - start;
+          repeats = (once < MIN_TRIAL_US) ? (int) (MIN_TRIAL_US / (once + 0.01)) + 1 : 1;
+
+          for (int t = 0; t < trials; t++) {
+            start = nowMicros();
+            for (int rep = 0; rep < repeats; rep++) {
+              runBatch(kernels[k], pairs);
+            }
+            times[t] = (nowMicros() - start) * 1000 / repeats;
+          }
+
+          double median = computeStats(times, trials).median;
+          double mad = relativeMAD(times, trials, median);
+          double perElement = median / elements;
+          double perMatch = (expected > 0) ? median / expected : 0;
+          perPair[k][l][r] += median / PAIRS;
+
+          printf("%-10s %6d %7d %6d %8.2f %14.3f %12.3f %6.1f%%\n", kernel_names[k], lengths[l],
+            lengths[l] * ratios[r], ratios[r], densities[d], perElement, perMatch, mad * 100);
+          fprintf(file, "%s\t%d\t%d\t%d\t%.2f\t%lu\t%.4f\t%.4f\t%.4f\t%d\n", kernel_names[k], lengths[l],
+            lengths[l] * ratios[r], ratios[r], densities[d], expected, perElement, perMatch, mad, trials);
+        }
+
+        for (int p = 0; p < PAIRS; p++) {
+          freePair(pairs[p]);
+        }
+      }
+    }
+  }
+  fclose(file);
+
+  // kernels[]: 1 merge, 2 galloping, 3 simd.
+  // The gallop ratio: for every short length, the smallest ratio from which on galloping
+  // beats both linear kernels. We suggest the median of those.
+  uint crossings[LENGTHS_NUM];
+  int crossings_num = 0;
+  for (int l = 0; l < LENGTHS_NUM; l++) {
+    uint crossing = 0;
+    for (int r = RATIOS_NUM - 1; r >= 0; r--) {
+      double linear = fmin(perPair[1][l][r], perPair[3][l][r]);
+      if (perPair[2][l][r] > linear) {
+        break;
+      }
+      crossing = ratios[r];
+    }
+    if (crossing > 0) {
+      crossings[crossings_num++] = crossing;
+    }
+  }
+
+  // The simd minimum: the shortest list from which on simd beats merge on lists of about equal length.
+  int simdMin = -1;
+  for (int l = LENGTHS_NUM - 1; l >= 0; l--) {
+    if (perPair[3][l][0] + perPair[3][l][1] > perPair[1][l][0] + perPair[1][l][1]) {
+      break;
+    }
+    simdMin = lengths[l];
+  }
+
+  printf("\nSuggested thresholds for headers/intersect.h on this machine:\n");
+  if (crossings_num > 0) {
+    qsort(crossings, crossings_num, sizeof(uint), compareUints);
+    printf("#define INTERSECT_GALLOP_RATIO %u\n", crossings[crossings_num / 2]);
+  } else {
+    printf("galloping never won. Keep INTERSECT_GALLOP_RATIO above %d.\n", ratios[RATIOS_NUM - 1]);
+  }
+  if (simdMin > 0) {
+    printf("#define INTERSECT_SIMD_MIN %d\n", simdMin);
+  } else {
+    printf("simd never won. Set INTERSECT_SIMD_MIN above %d.\n", lengths[LENGTHS_NUM - 1]);
+  }
+  printf("(currently %d and %d)\n", INTERSECT_GALLOP_RATIO, INTERSECT_SIMD_MIN);
+
+  free(times);
+  if (mismatches > 0) {
+    printf("%d kernel runs disagreed with merge. Don't trust these thresholds.\n", mismatches);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,519 @@
+/*
+ * mpi.c
+ *
+ * Convert a square N x N matrix into the CSR format, made for sparse matrices:
+ * https://en.wikipedia.org/wiki/Sparse_matrix#Compressed_sparse_column_(CSC_or_CCS)
+ * Then return its square in CSR format and perform the Hadamard
+ * (element-wise) operation: A (Hadamard) A^2.
+ *
+ * -- Distributed implementation of the algorithm using MPI, with openMP inside each rank. --
+ *
+ * The rows are split in contiguous blocks (1D partition) with equal nonzeros, the
+ * same way makeThreadArguments() splits them between threads. The graph is either
+ * replicated on every rank, or each rank only gets its own rows and then fetches
+ * the adjacency of the remote neighbors it needs, with one batched exchange.
+ * The per-vertex triangles are gathered back to rank 0, which writes the same results
+ * as tricount.
+ *
+ * Usage: mpirun -np <ranks> ./mpi [options] <graph ...>
+ *   graph: a .mtx file, a .csr snapshot or a generator spec, like tricount takes.
+ *   -t: the openMP threads of each rank (default: 1).
+ *   -m: replicate or distribute (default: replicate if the copies fit in memory).
+ *   -w: warmup repetitions, that aren't measured (default: 2).
+ *   -n: measured repetitions (default: 10).
+ *   -c: the tidy CSV file (default: stats/mpi.csv).
+ *   -j: the JSON file, with every measured time (default: stats/mpi.json).
+ *
+ * Authors: Antonios Antoniou - 9482 - aantonii@ece.auth.gr
+ *          Efthymios Grigorakis - 9694 - eegrigor@ece.auth.gr
+ *
+ * 2021 Aristotle University of Thessaloniki
+ * Parallel and Distributed Systems.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <mpi.h>
+#include <omp.h>
+
+#include "headers/csr.h"
+#include "headers/csr_arg.h"
+#include "headers/mmio.h"
+#include "headers/helpers.h"
+#include "headers/data_arg.h"
+#include "headers/bench.h"
+#include "headers/generator.h"
+#include "headers/verify.h"
+
+// How the table reaches the ranks.
+#define MODE_AUTO 0
+#define MODE_REPLICATE 1
+#define MODE_DISTRIBUTE 2
+
+
+// Every rank gets the same partition, calculated on rank 0.
+// Returns the first row of each rank; starts[ranks] == size.
+uint *partitionRows(csr table, int rank, int ranks, uint size) {
+  uint *starts = (uint *) malloc((ranks + 1) * sizeof(uint));
+
+  if (rank == 0) {
+    csr_arg *parts = makeThreadArguments(table, ranks);
+    for (int i = 0; i < ranks; i++) {
+      starts[i] = parts[i].start;
+    }
+    freeThreadArguments(parts, ranks);
+    starts[ranks] = size;
+  }
+
+  MPI_Bcast(starts, ranks + 1, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+  return starts;
+}
+
+
+// The rank that owns a row. starts is sorted, so we binary search it.
+int ownerOf(uint *starts, int ranks, uint row) {
+  int low = 0;
+  int high = ranks - 1;
+
+  while (low < high) {
+    int middle = (low + high + 1) / 2;
+    if (starts[middle] <= row) {
+      low = middle;
+    } else {
+      high = middle - 1;
+    }
+  }
+
+  return low;
+}
+
+
+// Sends the whole table from rank 0 to everyone.
+csr replicateTable(csr table, int rank, uint size) {
+  uint nonzeros = (rank == 0) ? table.rowIndex[size] : 0;
+  MPI_Bcast(&nonzeros, 1, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+
+  csr copy = table;
+  if (rank != 0) {
+    copy.size = size;
+    copy.rowIndex = (uint *) malloc((size + 1) * sizeof(uint));
+    copy.colIndex = (uint *) malloc(nonzeros * sizeof(uint));
+    copy.values = (int *) malloc(nonzeros * sizeof(int));
+    for (uint i = 0; i < nonzeros; i++) {
+      copy.values[i] = 1;
+    }
+  }
+
+  MPI_Bcast(copy.rowIndex, size + 1, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+  MPI_Bcast(copy.colIndex, nonzeros, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+
+  return copy;
+}
+
+
+// Gives every rank only its own rows, then fetches the adjacency of the remote
+// neighbors. The result is a table of the full size, where only the local rows
+// and the neighbor (ghost) rows are nonempty. That way dot() works on global ids.
+csr distributeTable(csr table, uint *starts, int rank, int ranks, uint size) {
+  uint start = starts[rank];
+  uint end = starts[rank + 1];
+  uint localRows = end - start;
+
+  // 1. Scatter the degrees and the adjacency of each block.
+  int *rowCounts = (int *) malloc(ranks * sizeof(int));
+  int *rowDispls = (int *) malloc(ranks * sizeof(int));
+  int *nzCounts = (int *) malloc(ranks * sizeof(int));
+  int *nzDispls = (int *) malloc(ranks * sizeof(int));
+  uint *degrees = NULL;
+
+  if (rank == 0) {
+    degrees = (uint *) malloc(size * sizeof(uint));
+    for (uint i = 0; i < size; i++) {
+      degrees[i] = table.rowIndex[i+1] - table.rowIndex[i];
+    }
+    for (int r = 0; r < ranks; r++) {
+      rowCounts[r] = starts[r + 1] - starts[r];
+      rowDispls[r] = starts[r];
+      nzCounts[r] = table.rowIndex[starts[r + 1]] - table.rowIndex[starts[r]];
+      nzDispls[r] = table.rowIndex[starts[r]];
+    }
+  }
+  MPI_Bcast(nzCounts, ranks, MPI_INT, 0, MPI_COMM_WORLD);
+
+  uint localNonzeros = nzCounts[rank];
+  uint *localDegrees = (uint *) malloc(localRows * sizeof(uint));
+  uint *localAdjacency = (uint *) malloc(localNonzeros * sizeof(uint));
+
+  MPI_Scatterv(degrees, rowCounts, rowDispls, MPI_UNSIGNED,
+    localDegrees, localRows, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+  MPI_Scatterv(table.colIndex, nzCounts, nzDispls, MPI_UNSIGNED,
+    localAdjacency, localNonzeros, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+
+  // 2. Find the remote neighbors, without duplicates. Walking the marks in order
+  // gives them sorted, so the ones of each owner are already contiguous.
+  char *needed = (char *) calloc(size, sizeof(char));
+  for (uint i = 0; i < localNonzeros; i++) {
+    uint column = localAdjacency[i];
+    if (column < start || column >= end) {
+      needed[column] = 1;
+    }
+  }
+
+  uint ghosts = 0;
+  for (uint i = 0; i < size; i++) {
+    ghosts += needed[i];
+  }
+
+  uint *ghostIds = (uint *) malloc(ghosts * sizeof(uint));
+  int *sendCounts = (int *) calloc(ranks, sizeof(int));
+  for (uint i = 0, g = 0; i < size; i++) {
+    if (needed[i]) {
+      ghostIds[g++] = i;
+      sendCounts[ownerOf(starts, ranks, i)]++;
+    }
+  }
+  free(needed);
+
+  // 3. One batched request: tell every owner which rows we need.
+  int *recvCounts = (int *) malloc(ranks * sizeof(int));
+  MPI_Alltoall(sendCounts, 1, MPI_INT, recvCounts, 1, MPI_INT, MPI_COMM_WORLD);
+
+  int *sendDispls = (int *) calloc(ranks, sizeof(int));
+  int *recvDispls = (int *) calloc(ranks, sizeof(int));
+  for (int r = 1; r < ranks; r++) {
+    sendDispls[r] = sendDispls[r-1] + sendCounts[r-1];
+    recvDispls[r] = recvDispls[r-1] + recvCounts[r-1];
+  }
+  uint requested = recvDispls[ranks-1] + recvCounts[ranks-1];
+
+  uint *requestedIds = (uint *) malloc(requested * sizeof(uint));
+  MPI_Alltoallv(ghostIds, sendCounts, sendDispls, MPI_UNSIGNED,
+    requestedIds, recvCounts, recvDispls, MPI_UNSIGNED, MPI_COMM_WORLD);
+
+  // The offset of each local row inside localAdjacency.
+  uint *localOffsets = (uint *) malloc((localRows + 1) * sizeof(uint));
+  localOffsets[0] = 0;
+  for (uint i = 0; i < localRows; i++) {
+    localOffsets[i+1] = localOffsets[i] + localDegrees[i];
+  }
+
+  // 4. Answer with the degrees of the requested rows, then their adjacency.
+  uint *replyDegrees = (uint *) malloc(requested * sizeof(uint));
+  int *adjSendCounts = (int *) calloc(ranks, sizeof(int));
+  for (int r = 0; r < ranks; r++) {
+    for (int i = recvDispls[r]; i < recvDispls[r] + recvCounts[r]; i++) {
+      replyDegrees[i] = localDegrees[requestedIds[i] - start];
+      adjSendCounts[r] += replyDegrees[i];
+    }
+  }
+
+  uint *ghostDegrees = (uint *) malloc(ghosts * sizeof(uint));
+  MPI_Alltoallv(replyDegrees, recvCounts, recvDispls, MPI_UNSIGNED,
+    ghostDegrees, sendCounts, sendDispls, MPI_UNSIGNED, MPI_COMM_WORLD);
+
+  int *adjRecvCounts = (int *) calloc(ranks, sizeof(int));
+  for (int r = 0; r < ranks; r++) {
+    for (int i = sendDispls[r]; i < sendDispls[r] + sendCounts[r]; i++) {
+      adjRecvCounts[r] += ghostDegrees[i];
+    }
+  }
+
+  int *adjSendDispls = (int *) calloc(ranks, sizeof(int));
+  int *adjRecvDispls = (int *) calloc(ranks, sizeof(int));
+  for (int r = 1; r < ranks; r++) {
+    adjSendDispls[r] = adjSendDispls[r-1] + adjSendCounts[r-1];
+    adjRecvDispls[r] = adjRecvDispls[r-1] + adjRecvCounts[r-1];
+  }
+  uint replySize = adjSendDispls[ranks-1] + adjSendCounts[ranks-1];
+  uint ghostNonzeros = adjRecvDispls[ranks-1] + adjRecvCounts[ranks-1];
+
+  uint *replyAdjacency = (uint *) malloc(replySize * sizeof(uint));
+  for (uint i = 0, k = 0; i < requested; i++) {
+    uint row = requestedIds[i] - start;
+    for (uint j = localOffsets[row]; j < localOffsets[row+1]; j++) {
+      replyAdjacency[k++] = localAdjacency[j];
+    }
+  }
+
+  uint *ghostAdjacency = (uint *) malloc(ghostNonzeros * sizeof(uint));
+  MPI_Alltoallv(replyAdjacency, adjSendCounts, adjSendDispls, MPI_UNSIGNED,
+    ghostAdjacency, adjRecvCounts, adjRecvDispls, MPI_UNSIGNED, MPI_COMM_WORLD);
+
+  printf("rank %d: rows %u-%u, %u local nonzeros, %u ghost rows, %u ghost nonzeros\n",
+    rank, start, end, localNonzeros, ghosts, ghostNonzeros);
+
+  // 5. Put the local and the ghost rows in one table of the full size.
+  uint nonzeros = localNonzeros + ghostNonzeros;
+  csr local = {
+    size,
+    (int *) malloc(nonzeros * sizeof(int)),
+    (uint *) malloc(nonzeros * sizeof(uint)),
+    (uint *) calloc(size + 1, sizeof(uint))
+  };
+
+  for (uint i = 0; i < localRows; i++) {
+    local.rowIndex[start + i + 1] = localDegrees[i];
+  }
+  for (uint i = 0; i < ghosts; i++) {
+    local.rowIndex[ghostIds[i] + 1] = ghostDegrees[i];
+  }
+  for (uint i = 0; i < size; i++) {
+    local.rowIndex[i+1] += local.rowIndex[i];
+  }
+
+  memcpy(&local.colIndex[local.rowIndex[start]], localAdjacency, localNonzeros * sizeof(uint));
+  for (uint i = 0, k = 0; i < ghosts; i++) {
+    uint row = ghostIds[i];
+    for (uint j = local.rowIndex[row]; j < local.rowIndex[row+1]; j++) {
+      local.colIndex[j] = ghostAdjacency[k++];
+    }
+  }
+  for (uint i = 0; i < nonzeros; i++) {
+    local.values[i] = 1;
+  }
+
+  free(rowCounts); free(rowDispls); free(nzCounts); free(nzDispls); free(degrees);
+  free(localDegrees); free(localAdjacency); free(localOffsets);
+  free(ghostIds); free(ghostDegrees); free(ghostAdjacency);
+  free(sendCounts); free(recvCounts); free(sendDispls); free(recvDispls);
+  free(requestedIds); free(replyDegrees); free(replyAdjacency);
+  free(adjSendCounts); free(adjRecvCounts); free(adjSendDispls); free(adjRecvDispls);
+
+  return local;
+}
+
+
+// The rows of this rank, counted by the openMP threads. Returns the triangles
+// of rows start..end-1.
+uint *countTrianglesRows(csr table, uint start, uint end, int threads) {
+  uint *triangles = (uint *) calloc(end - start, sizeof(uint));
+
+  omp_set_num_threads(threads);
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (uint row = start; row < end; row++) {
+    uint sum = 0;
+    for (uint index = table.rowIndex[row]; index < table.rowIndex[row+1]; index++) {
+      sum += dot(table, row, table.colIndex[index]);
+    }
+    // Same as countTriangles(): the row sum of A (Hadamard) A^2 divided by 2.
+    triangles[row - start] = sum / 2;
+  }
+
+  return triangles;
+}
+
+
+// Decides whether every rank can keep its own copy of the table. All the ranks
+// of a node share its memory, so we only replicate if the copies fill at most half of it.
+int shouldReplicate(uint size, uint nonzeros, int ranks) {
+  unsigned long tableBytes = (unsigned long) (size + 1) * sizeof(uint) +
+    (unsigned long) nonzeros * (sizeof(uint) + sizeof(int));
+  unsigned long memory = (unsigned long) sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE);
+
+  return tableBytes * ranks < memory / 2;
+}
+
+
+// Distributes the table (if needed), counts the local rows and gathers all the
+// triangles back to rank 0. Only rank 0 gets a result; the rest get NULL.
+data_arg measureTimeMPI(csr mtx, uint *starts, int rank, int ranks, uint size, int threads, int replicate) {
+  MPI_Barrier(MPI_COMM_WORLD);
+  double start = MPI_Wtime();
+
+  csr table = (replicate)
+    ? replicateTable(mtx, rank, size)
+    : distributeTable(mtx, starts, rank, ranks, size);
+
+  uint first = starts[rank];
+  uint last = starts[rank + 1];
+  uint *localTriangles = countTrianglesRows(table, first, last, threads);
+
+  int *counts = (int *) malloc(ranks * sizeof(int));
+  int *displs = (int *) malloc(ranks * sizeof(int));
+  for (int r = 0; r < ranks; r++) {
+    counts[r] = starts[r + 1] - starts[r];
+    displs[r] = starts[r];
+  }
+
+  uint *triangles = (rank == 0) ? (uint *) calloc(size, sizeof(uint)) : NULL;
+  MPI_Gatherv(localTriangles, last - first, MPI_UNSIGNED,
+    triangles, counts, displs, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+
+  double stop = MPI_Wtime();
+  double timediff = (stop - start) * 1000000;
+
+  if (rank == 0) {
+    unsigned long total = 0;
+    for (uint i = 0; i < size; i++) {
+      total += triangles[i];
+    }
+    printf("\nMPI took %.0f us using %d ranks x %d threads (%s). Triangles: %lu\n\n",
+      timediff, ranks, threads, (replicate) ? "replicated" : "distributed", total / 3);
+  }
+
+  // Rank 0 owns the original table. Everything else was made by this call.
+  if (rank != 0 || !replicate) {
+    free(table.rowIndex);
+    free(table.colIndex);
+    free(table.values);
+  }
+  free(localTriangles);
+  free(counts);
+  free(displs);
+
+  data_arg data = {timediff, triangles};
+  return data;
+}
+
+
+static void printUsage(char *name) {
+  printf("Usage: mpirun -np <ranks> %s [-t threads per rank] [-m replicate|distribute] [-w warmups] [-n reps]"
+    " [-c csv] [-j json] <graph ...>\n", name);
+}
+
+
+// Every rank runs this for every graph. Only rank 0 loads it and fills the result.
+// Returns 0 if the graph couldn't be loaded.
+int benchmarkGraph(char *graph, int rank, int ranks, int threads, int mode, int reps, bench_result *result) {
+  // Only rank 0 reads the file.
+  csr mtx = {0, NULL, NULL, NULL};
+  uint size = 0;
+  uint nonzeros = 0;
+  int loaded = 1;
+  if (rank == 0) {
+    mtx = loadGraph(graph);
+    loaded = (mtx.rowIndex != NULL);
+    size = mtx.size;
+    nonzeros = (loaded) ? mtx.rowIndex[size] : 0;
+  }
+  MPI_Bcast(&loaded, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  if (!loaded) {
+    return 0;
+  }
+  MPI_Bcast(&size, 1, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+  MPI_Bcast(&nonzeros, 1, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+
+  int replicate = (mode == MODE_AUTO)
+    ? shouldReplicate(size, nonzeros, ranks)
+    : (mode == MODE_REPLICATE);
+  result->backend = (replicate) ? "mpi-replicated" : "mpi-distributed";
+
+  uint *starts = partitionRows(mtx, rank, ranks, size);
+
+  for (int rep = 0; rep < result->warmups + reps; rep++) {
+    data_arg data = measureTimeMPI(mtx, starts, rank, ranks, size, threads, replicate);
+
+    if (rank == 0 && rep >= result->warmups) {
+      result->times[rep - result->warmups] = data.time;
+    }
+    // The first measured repetition is kept, as in tricount.
+    if (rank == 0 && rep == result->warmups) {
+      verify_result summary = summarizeTriangles(data.triangles, size);
+      result->triangles = summary.total;
+      result->checksum = summary.checksum;
+    }
+    free(data.triangles);
+  }
+
+  if (rank == 0) {
+    result->stats = computeStats(result->times, reps);
+    result->intersections = (result->stats.median > 0) ? nonzeros / (result->stats.median / 1e6) : 0;
+    printf("%s on %s: %llu triangles, checksum %016llx, median %.0f us, using %d ranks x %d threads\n",
+      result->backend, result->graph, result->triangles, result->checksum, result->stats.median, ranks, threads);
+    freeCSR(mtx);
+  }
+  free(starts);
+  return 1;
+}
+
+
+int main(int argc, char **argv) {
+  MPI_Init(&argc, &argv);
+
+  int rank, ranks;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+  int threads = 1;
+  // By default, replicate if the copies fit in memory.
+  int mode = MODE_AUTO;
+  int warmups = 2;
+  int reps = 10;
+  char *csvName = "stats/mpi.csv";
+  char *jsonName = "stats/mpi.json";
+
+  // Every rank parses the same arguments, so they all agree on what to run.
+  int option;
+  while ((option = getopt(argc, argv, "t:m:w:n:c:j:")) != -1) {
+    switch (option) {
+      case 't': threads = atoi(optarg); break;
+      case 'm':
+        if (strcmp(optarg, "replicate") == 0) {
+          mode = MODE_REPLICATE;
+        } else if (strcmp(optarg, "distribute") == 0) {
+          mode = MODE_DISTRIBUTE;
+        } else {
+          mode = -1;
+        }
+        break;
+      case 'w': warmups = atoi(optarg); break;
+      case 'n': reps = atoi(optarg); break;
+      case 'c': csvName = optarg; break;
+      case 'j': jsonName = optarg; break;
+      default: mode = -1; break;
+    }
+  }
+  if (optind >= argc || mode < 0) {
+    if (rank == 0) {
+      printUsage(argv[0]);
+    }
+    MPI_Finalize();
+    return 1;
+  }
+  threads = (threads < 1) ? 1 : threads;
+  warmups = (warmups < 0) ? 0 : warmups;
+  reps = (reps < 1) ? 1 : reps;
+
+  int graphs = argc - optind;
+  bench_result *results = (bench_result *) calloc(graphs, sizeof(bench_result));
+  char label[64];
+  snprintf(label, sizeof(label), "mpi%dx%d", ranks, threads);
+
+  int failed = 0;
+  for (int g = 0; g < graphs; g++) {
+    bench_result *result = &results[g];
+    result->graph = graphName(argv[optind + g]);
+    result->label = label;
+    result->threads = threads;
+    result->warmups = warmups;
+    result->times = (double *) malloc(reps * sizeof(double));
+    result->ipc = -1;
+    result->missesPerEdge = -1;
+    result->verified = VERIFY_NONE;
+    result->peakHeap = -1;
+    result->peakRSS = -1;
+    result->retained = -1;
+    result->bytesPerEdge = -1;
+
+    // A graph that couldn't be loaded has no samples, so it has no row, like the runs tricount skips.
+    if (!benchmarkGraph(argv[optind + g], rank, ranks, threads, mode, reps, result)) {
+      failed = 1;
+    }
+  }
+
+  if (rank == 0) {
+    bench_meta meta = readBenchMeta();
+    writeResultsCSV(csvName, results, graphs, meta);
+    writeResultsJSON(jsonName, results, graphs, meta);
+  }
+
+  for (int g = 0; g < graphs; g++) {
+    free(results[g].graph);
+    free(results[g].times);
+  }
+  free(results);
+  MPI_Finalize();
+  return failed;
+}
@@ -16,6 +16,11 @@ end
 # ╔═╡ 0635fef4-8da7-4a7d-b763-791f6f227077
 df = DataFrame(CSV.File("stats/data.csv", delim = '\t'));
 
+# ╔═╡ 5b0e8c1a-3f47-4d2e-9a61-7c2d9e4f1b20
+# One row per graph, backend and number of threads, written by tricount.
+# Has the min, median, mean, p95 and stddev (in us) and the host, compiler and flags of the run.
+results = isfile("stats/results.csv") ? DataFrame(CSV.File("stats/results.csv", delim = '\t')) : nothing;
+
 # ╔═╡ 2685000b-9ed0-4c21-9a40-90a6147357aa
 md"""
 # Parallel and Distributed Systems - Assignment 1: Sparse matrices
@@ -156,6 +161,15 @@ b5 = groupedbar(
   ylabel = "Execution times in ms"
 )
 
+# ╔═╡ 8e2b6d41-0c5a-4f3e-b7d9-2a6f1c9e3b57
+# The medians of the latest tricount run, one bar per backend and number of threads.
+b6 = results === nothing ? nothing : groupedbar(
+  results.graph, results.median_us ./ 1000, group = results.label,
+  title = "stats/results.csv",
+  xlabel = "Graph",
+  ylabel = "Median execution times in ms"
+)
+
 # ╔═╡ 00000000-0000-0000-0000-000000000001
 PLUTO_PROJECT_TOML_CONTENTS = """
 [deps]
@@ -1416,6 +1430,7 @@ version = "0.9.1+5"
 # ╔═╡ Cell order:
 # ╟─f4789190-4754-11ec-2a9b-cd01d6b5a6b4
 # ╟─0635fef4-8da7-4a7d-b763-791f6f227077
+# ╟─5b0e8c1a-3f47-4d2e-9a61-7c2d9e4f1b20
 # ╟─2685000b-9ed0-4c21-9a40-90a6147357aa
 # ╟─886d7a04-a520-4f90-9b0c-077cc7aff289
 # ╟─dc15e6a5-e1ac-4b9b-8ae7-b76cb5441f0a
@@ -1429,5 +1444,6 @@ version = "0.9.1+5"
 # ╟─36e9e4dd-b9b6-45c1-a381-11511977aeb2
 # ╟─6663a703-56f0-4ff0-bc68-72d968126a36
 # ╟─66a1adb5-34f9-46af-b096-bd0f72272268
+# ╟─8e2b6d41-0c5a-4f3e-b7d9-2a6f1c9e3b57
 # ╟─00000000-0000-0000-0000-000000000001
 # ╟─00000000-0000-0000-0000-000000000002
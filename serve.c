@@ -0,0 +1,71 @@
+/*
+ * serve.c
+ *
+ * Keeps graphs loaded and answers triangle queries over a Unix socket (see headers/server.h
+ * for the queries), or sends it one.
+ *
+ * Usage: ./serve [-t threads] [-s socket] <graph ...>
+ *        ./serve [-s socket] -q <query>
+ *   graph: a .mtx file, a .csr snapshot or a generator spec, like tricount takes, or
+ *          name=graph to give it a name. The queries name the graph.
+ *   -t: default: the number of cpus.
+ *   -s: default: /tmp/tricount.sock.
+ *   -q: sends the query to the daemon and prints the reply. Exits with 1 on ERR.
+ *
+ * Authors: Antonios Antoniou - 9482 - aantonii@ece.auth.gr
+ *          Efthymios Grigorakis - 9694 - eegrigor@ece.auth.gr
+ *
+ * 2021 Aristotle University of Thessaloniki
+ * Parallel and Distributed Systems.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "headers/csr.h"
+#include "headers/server.h"
+
+
+static void printUsage(char *program) {
+  printf("Usage: %s [-t threads] [-s socket] <graph ...>\n", program);
+  printf("       %s [-s socket] -q <query>\n", program);
+}
+
+
+int main(int argc, char **argv) {
+  int threads = sysconf(_SC_NPROCESSORS_ONLN);
+  char *socketPath = SERVER_SOCKET;
+  char *query = NULL;
+
+  int option;
+  while ((option = getopt(argc, argv, "t:s:q:")) != -1) {
+    switch (option) {
+      case 't': threads = atoi(optarg); break;
+      case 's': socketPath = optarg; break;
+      case 'q': query = optarg; break;
+      default:
+        printUsage(argv[0]);
+        return 1;
+    }
+  }
+  if (query != NULL && optind == argc) {
+    return sendQuery(socketPath, query) ? 0 : 1;
+  }
+  if (query != NULL || optind >= argc) {
+    printUsage(argv[0]);
+    return 1;
+  }
+  threads = (threads < 1) ? 1 : threads;
+
+  int count = argc - optind;
+  served_graph *graphs = loadServedGraphs(&argv[optind], count);
+  if (graphs == NULL) {
+    return 1;
+  }
+
+  int served = serveQueries(socketPath, graphs, count, threads);
+  freeServedGraphs(graphs, count);
+  return served ? 0 : 1;
+}
@@ -0,0 +1,237 @@
+/*
+ * stream.c
+ *
+ * Keeps the triangle counts of a graph up to date under batches of edge insertions and
+ * deletions (see headers/dynamic.h), and reports the latency of every batch next to the
+ * time of counting the whole graph again.
+ *
+ * Usage: ./stream [-t threads] [-b batch] [-n updates] [-d deletes] [-s seed] [-u file] [-o csv] [-v] <graph>
+ *   graph: a .mtx file, a .csr snapshot or a generator spec, like tricount takes.
+ *   -t: default: the number of cpus.
+ *   -b: updates per batch (default: 1000).
+ *   -n: random updates in all (default: 100000). Ignored with -u.
+ *   -d: the fraction of the random updates that delete an existing edge (default: 0.5).
+ *       The rest insert an edge between two random vertices.
+ *   -s: the seed of the random updates (default: 1).
+ *   -u: the updates, one per line: "+ u v" inserts and "- u v" deletes, 1-based like .mtx files.
+ *   -o: one row per batch (default: stats/stream.csv).
+ *   -v: checks the counts against the reference (see headers/verify.h) after the last batch.
+ *
+ * Authors: Antonios Antoniou - 9482 - aantonii@ece.auth.gr
+ *          Efthymios Grigorakis - 9694 - eegrigor@ece.auth.gr
+ *
+ * 2021 Aristotle University of Thessaloniki
+ * Parallel and Distributed Systems.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "headers/csr.h"
+#include "headers/mmio.h"
+#include "headers/helpers.h"
+#include "headers/bench.h"
+#include "headers/generator.h"
+#include "headers/verify.h"
+#include "headers/dynamic.h"
+
+
+// Reads the updates of a file. Returns NULL if it can't be read.
+static edge_update *readUpdates(char *path, uint *count) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    printf("Couldn't read %s\n", path);
+    return NULL;
+  }
+
+  uint allocated = 1024;
+  edge_update *updates = (edge_update *) malloc(allocated * sizeof(edge_update));
+  *count = 0;
+
+  char sign;
+  uint u, v;
+  while (fscanf(file, " %c %u %u", &sign, &u, &v) == 3) {
+    if ((sign != '+' && sign != '-') || u == 0 || v == 0) {
+      printf("Skipping the update %c %u %u of %s\n", sign, u, v, path);
+      continue;
+    }
+    if (*count == allocated) {
+      allocated *= 2;
+      updates = (edge_update *) realloc(updates, allocated * sizeof(edge_update));
+    }
+    edge_update update = {u - 1, v - 1, (sign == '+') ? DYNAMIC_INSERT : DYNAMIC_DELETE};
+    updates[(*count)++] = update;
+  }
+
+  fclose(file);
+  return updates;
+}
+
+
+// Random updates, drawn from the seed only. A deletion picks an edge of the graph as it
+// is when the batch starts, so most of them delete something.
+static void randomBatch(dynamic_graph *graph, edge_update *updates, uint count, double deletes,
+  unsigned long long seed, unsigned long long first)
+{
+  for (uint i = 0; i < count; i++) {
+    unsigned long long draw = 3 * (first + i);
+    int remove = (splitmix64(seed, draw) >> 11) * (1.0 / 9007199254740992.0) < deletes;
+    uint u = splitmix64(seed, draw + 1) % graph->size;
+    uint v = splitmix64(seed, draw + 2) % graph->size;
+
+    if (remove && graph->degree[u] > 0) {
+      v = graph->neighbors[u][splitmix64(seed, draw + 2) % graph->degree[u]];
+    }
+    edge_update update = {u, v, remove ? DYNAMIC_DELETE : DYNAMIC_INSERT};
+    updates[i] = update;
+  }
+}
+
+
+static void printUsage(char *program) {
+  printf("Usage: %s [-t threads] [-b batch] [-n updates] [-d deletes] [-s seed] [-u file] [-o csv] [-v] <graph>\n",
+    program);
+}
+
+
+int main(int argc, char **argv) {
+  int threads = sysconf(_SC_NPROCESSORS_ONLN);
+  uint batch = 1000;
+  uint total = 100000;
+  double deletes = 0.5;
+  unsigned long long seed = 1;
+  char *updateName = NULL;
+  char *csvName = "stats/stream.csv";
+  int verify = 0;
+
+  int option;
+  while ((option = getopt(argc, argv, "t:b:n:d:s:u:o:v")) != -1) {
+    switch (option) {
+      case 't': threads = atoi(optarg); break;
+      case 'b': batch = atoi(optarg); break;
+      case 'n': total = atoi(optarg); break;
+      case 'd': deletes = atof(optarg); break;
+      case 's': seed = strtoull(optarg, NULL, 10); break;
+      case 'u': updateName = optarg; break;
+      case 'o': csvName = optarg; break;
+      case 'v': verify = 1; break;
+      default:
+        printUsage(argv[0]);
+        return 1;
+    }
+  }
+  if (optind != argc - 1) {
+    printUsage(argv[0]);
+    return 1;
+  }
+  threads = (threads < 1) ? 1 : threads;
+  batch = (batch < 1) ? 1 : batch;
+
+  char *graphPath = argv[optind];
+  char *name = graphName(graphPath);
+  csr table = loadGraph(graphPath);
+  if (table.rowIndex == NULL) {
+    return 1;
+  }
+
+  double start = nowMicros();
+  dynamic_graph graph = dynamicFromCSR(table, threads);
+  double build = nowMicros() - start;
+  freeCSR(table);
+  if (graph.size == 0) {
+    printf("%s has no vertices.\n", graphPath);
+    freeDynamicGraph(&graph);
+    return 1;
+  }
+  printf("%s: %u vertices, %llu edges, %llu triangles. Built in %.0f us, using %d threads.\n",
+    name, graph.size, graph.edges, graph.total, build, threads);
+
+  edge_update *updates = NULL;
+  if (updateName != NULL) {
+    updates = readUpdates(updateName, &total);
+    if (updates == NULL) {
+      freeDynamicGraph(&graph);
+      return 1;
+    }
+  } else {
+    updates = (edge_update *) malloc(batch * sizeof(edge_update));
+  }
+
+  FILE *file = fopen(csvName, "w");
+  if (file == NULL) {
+    printf("Couldn't write %s\n", csvName);
+  } else {
+    fprintf(file, "graph\tbatch\tupdates\tinserted\tdeleted\tignored\tchange\ttriangles\tedges\tlatency_us\tthreads\n");
+  }
+
+  uint batches = (total + batch - 1) / batch;
+  double *latencies = (double *) malloc(((batches > 0) ? batches : 1) * sizeof(double));
+  unsigned long long applied = 0;
+  double elapsed = 0;
+
+  for (uint b = 0; b < batches; b++) {
+    uint first = b * batch;
+    uint count = (total - first < batch) ? total - first : batch;
+    edge_update *current = &updates[first];
+    if (updateName == NULL) {
+      randomBatch(&graph, updates, count, deletes, seed, first);
+      current = updates;
+    }
+
+    start = nowMicros();
+    batch_result result = dynamicUpdate(&graph, current, count, threads);
+    latencies[b] = nowMicros() - start;
+    elapsed += latencies[b];
+    applied += result.inserted + result.deleted;
+
+    if (file != NULL) {
+      fprintf(file, "%s\t%u\t%u\t%u\t%u\t%u\t%lld\t%llu\t%llu\t%.1f\t%d\n", name, b, count,
+        result.inserted, result.deleted, result.ignored, result.change, graph.total, graph.edges, latencies[b],
+        threads);
+    }
+  }
+  if (file != NULL) {
+    fclose(file);
+  }
+
+  // What the same graph costs from scratch, to compare every batch to.
+  start = nowMicros();
+  uint *recount = dynamicRecount(&graph, threads);
+  double full = nowMicros() - start;
+
+  time_stats stats = computeStats(latencies, batches);
+  printf("%u batches of up to %u updates: %llu changed the graph.\n", batches, batch, applied);
+  printf("Batch latency: min %.1f us, median %.1f us, p95 %.1f us, mean %.1f us.\n",
+    stats.min, stats.median, stats.p95, stats.mean);
+  printf("%.0f updates/s. A full recount takes %.0f us (%.1fx a median batch).\n",
+    (elapsed > 0) ? total / elapsed * 1e6 : 0, full, (stats.median > 0) ? full / stats.median : 0);
+  printf("Now %u vertices, %llu edges, %llu triangles.\n", graph.size, graph.edges, graph.total);
+
+  int status = 0;
+  if (verify) {
+    csr current = dynamicToCSR(&graph);
+    uint *reference = referenceTriangles(current);
+    verify_result expected = summarizeTriangles(reference, graph.size);
+    verify_result result = verifyTriangles(graph.triangles, reference, &expected, graph.size);
+    verify_result scratch = verifyTriangles(recount, reference, &expected, graph.size);
+
+    if (result.status == VERIFY_OK && scratch.status == VERIFY_OK && expected.total == graph.total) {
+      printf("Verified: %llu triangles, like the reference.\n", expected.total);
+    } else {
+      printf("MISMATCH: %u vertices differ from the reference (the first is %u), %llu triangles instead of %llu.\n",
+        result.mismatches, result.first + 1, graph.total, expected.total);
+      status = 2;
+    }
+    free(reference);
+    freeCSR(current);
+  }
+
+  free(recount);
+  free(latencies);
+  free(name);
+  free(updates);
+  freeDynamicGraph(&graph);
+  return status;
+}
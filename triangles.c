@@ -0,0 +1,101 @@
+/*
+ * triangles.c
+ *
+ * Lists the triangles of a graph, each once, into a file per thread (see headers/listing.h).
+ *
+ * Usage: ./triangles [-t threads] [-x] [-o prefix] [-v] <graph>
+ *   graph: a .mtx file, a .csr snapshot or a generator spec, like tricount takes.
+ *   -t: default: the number of cpus.
+ *   -x: text instead of binary.
+ *   -o: the files are <prefix>.<thread>.bin, or .txt (default: stats/triangles).
+ *   -v: checks the number listed against the triangles without self loops.
+ *       Exits with 2 if they differ.
+ *
+ * Authors: Antonios Antoniou - 9482 - aantonii@ece.auth.gr
+ *          Efthymios Grigorakis - 9694 - eegrigor@ece.auth.gr
+ *
+ * 2021 Aristotle University of Thessaloniki
+ * Parallel and Distributed Systems.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "headers/csr.h"
+#include "headers/mmio.h"
+#include "headers/helpers.h"
+#include "headers/bench.h"
+#include "headers/generator.h"
+#include "headers/sampling.h"
+#include "headers/listing.h"
+
+
+static void printUsage(char *program) {
+  printf("Usage: %s [-t threads] [-x] [-o prefix] [-v] <graph>\n", program);
+}
+
+
+int main(int argc, char **argv) {
+  int threads = sysconf(_SC_NPROCESSORS_ONLN);
+  int format = LISTING_BINARY;
+  char *prefix = "stats/triangles";
+  int verify = 0;
+
+  int option;
+  while ((option = getopt(argc, argv, "t:xo:v")) != -1) {
+    switch (option) {
+      case 't': threads = atoi(optarg); break;
+      case 'x': format = LISTING_TEXT; break;
+      case 'o': prefix = optarg; break;
+      case 'v': verify = 1; break;
+      default:
+        printUsage(argv[0]);
+        return 1;
+    }
+  }
+  if (optind != argc - 1) {
+    printUsage(argv[0]);
+    return 1;
+  }
+  threads = (threads < 1) ? 1 : threads;
+
+  char *name = graphName(argv[optind]);
+  csr table = loadGraph(argv[optind]);
+  if (table.rowIndex == NULL) {
+    return 1;
+  }
+
+  listing_result result = listTriangles(table, prefix, format, threads);
+  if (result.files == 0) {
+    freeCSR(table);
+    free(name);
+    return 1;
+  }
+
+  double seconds = result.time / 1e6;
+  printf("%s: %llu triangles, %llu bytes in %d files, in %.0f us using %d threads "
+    "(%.1f M triangles/s, %.1f MB/s).\n", name, result.triangles, result.bytes, result.files,
+    result.time, threads, (seconds > 0) ? result.triangles / seconds / 1e6 : 0,
+    (seconds > 0) ? result.bytes / seconds / 1e6 : 0);
+
+  char file[1024];
+  listingFileName(file, sizeof(file), prefix, format, 0);
+  printf("First file: %s\n", file);
+
+  int status = 0;
+  if (verify) {
+    unsigned long long expected = exactTriangles(table, threads, NULL);
+    if (expected == result.triangles) {
+      printf("Verified: %llu triangles.\n", expected);
+    } else {
+      printf("MISMATCH: %llu triangles expected.\n", expected);
+      status = 2;
+    }
+  }
+
+  freeCSR(table);
+  free(name);
+  return status;
+}
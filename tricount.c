@@ -0,0 +1,694 @@
+/*
+ * tricount.c
+ *
+ * Convert a square N x N matrix into the CSR format, made for sparse matrices:
+ * https://en.wikipedia.org/wiki/Sparse_matrix#Compressed_sparse_column_(CSC_or_CCS)
+ * Then return its square in CSR format and perform the Hadamard
+ * (element-wise) operation: A (Hadamard) A^2.
+ *
+ * -- The driver of every implementation of the algorithm. --
+ *
+ * Each graph is read once. Then every selected backend runs on it, with every
+ * selected number of threads. The statistics of every run are written as a tidy
+ * CSV and JSON file, and the means as the table of stats/data.csv.
+ *
+ * Usage: ./tricount [options] [graph ...]
+ *   A graph is a .mtx file, a .csr snapshot or the spec of a synthetic graph
+ *   (rmat:20:16, er:18, grid2d:20, ...). See generate.c and headers/generator.h.
+ *   -b: comma separated backends (default: serial,pthreads,openmp,cilk).
+ *       Run ./tricount -l to list the backends of this build.
+ *   -t: comma separated numbers of threads (default: 2,4,8).
+ *   -f: comma separated indices of the default files below, used when no graph is given
+ *       (default: 0,1,2,3,4).
+ *   -w: warmup repetitions, that aren't measured (default: 2).
+ *   -n: measured repetitions (default: 10).
+ *   -a: turns on NUMA mode with that affinity (compact, scatter, none or a cpu list).
+ *   -r: in NUMA mode, give each node its own copy of the table.
+ *   -p: also run the pipelined mode, that counts while the file is being read, with
+ *       every number of threads. Its rows (pipeN) include the reading of the file,
+ *       so the "load" row has the time readmtx_dynamic() alone takes, for comparison.
+ *   -o: the table of mean times (default: stats/data.csv).
+ *   -c: the tidy CSV file, one row per run (default: stats/results.csv).
+ *   -j: the JSON file, with every measured time (default: stats/results.json).
+ *   -T: times every phase of every worker. Prints the breakdown and the load imbalance
+ *       of the last repetition of each run, and writes them all as a Chrome trace there.
+ *   -P: also reads the hardware counters (cycles, instructions, LLC and branch misses) of
+ *       every phase with perf_event_open(). Adds the IPC and the misses per edge to the
+ *       breakdown and to the results.
+ *   -S: strong scaling sweep. Runs every backend from 1 thread up to the number of cpus,
+ *       and with twice as many threads (unless -t gives the counts), then writes the
+ *       speedup, efficiency, Karp-Flatt serial fraction and knee of each one.
+ *   -W: weak scaling sweep from a generator spec, e.g. -W rmat:16. The graph grows with
+ *       the threads: p threads run on scale + log2(p). The graph arguments are ignored.
+ *   -M: accounts for every allocation. Prints the heap the graph takes, what every phase
+ *       allocated, left behind and held at most, and the peak heap, the peak resident set
+ *       and the heap bytes per edge of every run, which are added to the results.
+ *   -s: the scaling results of -S and -W (default: stats/scaling.csv).
+ *   -B: compares every run to a baseline, the results.json of an earlier run, and writes
+ *       the comparison to stats/regression.csv. The backends, threads and graphs that
+ *       aren't given are the ones of the baseline. Takes at least 20 repetitions. Exits
+ *       with 3 if any run regressed or a run of the baseline is missing (see headers/regression.h).
+ *   -R: the slowdown of the median, in %, from which a run can count as regressed (default: 5).
+ *   -v: checks the triangles of every run against an independent reference count (or,
+ *       on graphs too large for it, against the first run). Every run reports its total
+ *       and checksum anyway. Exits with 2 if any run doesn't match.
+ *
+ * Authors: Antonios Antoniou - 9482 - aantonii@ece.auth.gr
+ *          Efthymios Grigorakis - 9694 - eegrigor@ece.auth.gr
+ *
+ * 2021 Aristotle University of Thessaloniki
+ * Parallel and Distributed Systems.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "headers/csr.h"
+#include "headers/csr_arg.h"
+#include "headers/mmio.h"
+#include "headers/helpers.h"
+#include "headers/data_arg.h"
+#include "headers/numa_helpers.h"
+#include "headers/backends.h"
+#include "headers/pipeline.h"
+#include "headers/bench.h"
+#include "headers/trace.h"
+#include "headers/counters.h"
+#include "headers/generator.h"
+#include "headers/scaling.h"
+#include "headers/verify.h"
+#include "headers/memory.h"
+#include "headers/regression.h"
+
+#define MAX_LIST 64
+
+// What a row of the results measures.
+#define RUN_BACKEND 0
+#define RUN_LOAD 1
+#define RUN_PIPELINE 2
+
+// A backend and the number of threads it runs with.
+// engine is NULL for the load and the pipelined runs, that read the file themselves.
+typedef struct {
+  backend *engine;
+  int threads;
+  int kind;
+} run_config;
+
+
+// Splits a comma separated list of numbers. Returns how many were read.
+int parseIntList(char *list, int *numbers) {
+  char *copy = strdup(list);
+  int count = 0;
+
+  for (char *token = strtok(copy, ","); token != NULL && count < MAX_LIST; token = strtok(NULL, ",")) {
+    numbers[count++] = atoi(token);
+  }
+
+  free(copy);
+  return count;
+}
+
+
+// Adds item to a comma separated list, unless it's already there.
+static void appendUnique(char *list, size_t length, const char *item) {
+  size_t size = strlen(item);
+  for (char *at = strstr(list, item); at != NULL; at = strstr(at + 1, item)) {
+    if ((at == list || at[-1] == ',') && (at[size] == ',' || at[size] == '\0')) {
+      return;
+    }
+  }
+  size_t used = strlen(list);
+  snprintf(list + used, length - used, "%s%s", (used > 0) ? "," : "", item);
+}
+
+
+// The backends and the numbers of threads of a baseline, as the lists of -b and -t, and
+// whether it has the load and pipelined runs of -p. The threads are the ones of the
+// parallel runs, the serial one always has 1.
+static void listBaselineRuns(bench_result *baseline, int baseline_num, char *backendList, char *threadList,
+  size_t length, int *pipelined)
+{
+  backendList[0] = '\0';
+  threadList[0] = '\0';
+  for (int i = 0; i < baseline_num; i++) {
+    bench_result *run = &baseline[i];
+    if (run->stats.samples == 0) {
+      continue;
+    }
+
+    int pipeline = strcmp(run->backend, "pipelined") == 0;
+    if (pipeline || strcmp(run->backend, "load") == 0) {
+      *pipelined = 1;
+    } else {
+      appendUnique(backendList, length, run->backend);
+    }
+
+    backend *engine = findBackend(run->backend);
+    if (pipeline || (engine != NULL && engine->parallel)) {
+      char threads[16];
+      snprintf(threads, sizeof(threads), "%d", run->threads);
+      appendUnique(threadList, length, threads);
+    }
+  }
+}
+
+
+// The graphs of a baseline, found by their names: the default files, generator specs,
+// or tables/<name>.mtx or .csr. Returns how many were found, the rest are skipped.
+static int listBaselineGraphs(bench_result *baseline, int baseline_num, char **filenames, char **names,
+  int defaults_num, char **graphs, char **graphNames)
+{
+  int count = 0;
+  for (int i = 0; i < baseline_num && count < MAX_LIST; i++) {
+    char *name = baseline[i].graph;
+    int seen = (baseline[i].stats.samples == 0);
+    for (int f = 0; f < count && !seen; f++) {
+      seen = strcmp(graphNames[f], name) == 0;
+    }
+    if (seen) {
+      continue;
+    }
+
+    char *path = NULL;
+    for (int f = 0; f < defaults_num && path == NULL; f++) {
+      path = (strcmp(names[f], name) == 0) ? strdup(filenames[f]) : NULL;
+    }
+    if (path == NULL && isGraphSpec(name)) {
+      path = strdup(name);
+    }
+    char *extensions[2] = {"mtx", "csr"};
+    for (int e = 0; e < 2 && path == NULL; e++) {
+      char file[1024];
+      snprintf(file, sizeof(file), "tables/%s.%s", name, extensions[e]);
+      path = (access(file, R_OK) == 0) ? strdup(file) : NULL;
+    }
+    if (path == NULL) {
+      printf("Couldn't find the graph %s of the baseline.\n", name);
+      continue;
+    }
+
+    graphs[count] = path;
+    graphNames[count++] = name;
+  }
+
+  return count;
+}
+
+
+// The name of a run and its row label in stats/data.csv.
+void describeConfig(run_config config, char *name, char *label, size_t length) {
+  if (config.kind == RUN_LOAD) {
+    snprintf(name, length, "load");
+    snprintf(label, length, "load");
+  } else if (config.kind == RUN_PIPELINE) {
+    snprintf(name, length, "pipelined");
+    snprintf(label, length, "pipe%d", config.threads);
+  } else if (config.engine->parallel) {
+    snprintf(name, length, "%s", config.engine->name);
+    snprintf(label, length, "%s%d", config.engine->label, config.threads);
+  } else {
+    snprintf(name, length, "%s", config.engine->name);
+    snprintf(label, length, "%s", config.engine->label);
+  }
+}
+
+
+data_arg measureTime(run_config config, csr mtx, char *filename, numa_plan *plan) {
+  int M = 0, N = 0, nz = 0;
+  MM_typecode *t = NULL;
+  uint *triangles = NULL;
+  char *name = "pipelined";
+  double loadTime = -1;
+
+  double start = nowMicros();
+  if (config.kind == RUN_BACKEND) {
+    triangles = config.engine->count(mtx, config.threads, plan);
+    name = config.engine->name;
+  }
+  else if (config.kind == RUN_LOAD) {
+    double begin = traceStart();
+    csr table = readmtx_dynamic(filename, t, N, M, nz);
+    traceRecord("load", TRACE_MAIN, begin);
+    freeCSR(table);
+    name = "readmtx_dynamic";
+  }
+  else {
+    pipeline_result result = countTrianglesPipelined(filename, config.threads);
+    triangles = result.triangles;
+    loadTime = result.loadTime;
+    freeCSR(result.table);
+  }
+  double timediff = nowMicros() - start;
+
+  printf("\n%s took %.0f us for file %s, using %d threads.\n\n",
+    name, timediff, filename, config.threads);
+  if (loadTime >= 0) {
+    printf("The file was read after %.0f us, %.0f us before the count finished.\n\n",
+      loadTime, timediff - loadTime);
+  }
+
+  data_arg data = {timediff, triangles};
+  return data;
+}
+
+
+int main(int argc, char **argv) {
+  char *filenames[5] = {
+    "tables/belgium_osm.mtx",
+    "tables/dblp-2010.mtx",
+    "tables/NACA0015.mtx",
+    "tables/mycielskian13.mtx",
+    "tables/com-Youtube.mtx"
+  };
+
+  // Used for the CSV file.
+  char *names[5] = {
+    "belgium_osm",
+    "dblp2010",
+    "NACA0015",
+    "mycielskian13",
+    "comYoutube"
+  };
+
+  char *backendList = NULL;
+  char *threadList = NULL;
+  char *fileList = NULL;
+  char *affinity = NULL;
+  char *csvName = "stats/data.csv";
+  char *resultsName = "stats/results.csv";
+  char *jsonName = "stats/results.json";
+  char *traceName = NULL;
+  int counters = 0;
+  int memory = 0;
+  int sweep = 0;
+  char *weakSpec = NULL;
+  char *scalingName = "stats/scaling.csv";
+  char *baselineName = NULL;
+  char *regressionName = "stats/regression.csv";
+  double threshold = REGRESSION_THRESHOLD;
+  int replicate = 0;
+  int pipelined = 0;
+  int verify = 0;
+  int warmups = 2;
+  int reps = 10;
+
+  int option;
+  while ((option = getopt(argc, argv, "b:t:f:w:n:a:rpo:c:j:T:PMSW:s:B:R:vl")) != -1) {
+    switch (option) {
+      case 'b': backendList = optarg; break;
+      case 't': threadList = optarg; break;
+      case 'f': fileList = optarg; break;
+      case 'w': warmups = atoi(optarg); break;
+      case 'n': reps = atoi(optarg); break;
+      case 'a': affinity = optarg; break;
+      case 'r': replicate = 1; break;
+      case 'p': pipelined = 1; break;
+      case 'o': csvName = optarg; break;
+      case 'c': resultsName = optarg; break;
+      case 'j': jsonName = optarg; break;
+      case 'T': traceName = optarg; break;
+      case 'P': counters = 1; break;
+      case 'M': memory = 1; break;
+      case 'S': sweep = 1; break;
+      case 'W': weakSpec = optarg; break;
+      case 's': scalingName = optarg; break;
+      case 'B': baselineName = optarg; break;
+      case 'R': threshold = atof(optarg) / 100; break;
+      case 'v': verify = 1; break;
+      case 'l':
+        for (int i = 0; i < backends_num; i++) {
+          printf("%s\n", backends[i].name);
+        }
+        return 0;
+      default:
+        printf("Usage: %s [-b backends] [-t threads] [-f files] [-w warmups] [-n reps] [-a affinity] [-r] [-p]"
+          " [-o csv] [-c results csv] [-j results json] [-T trace json] [-P] [-M]"
+          " [-S] [-W spec] [-s scaling csv] [-B baseline json] [-R threshold %%] [-v] [-l] [graph ...]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  if (reps < 1 || warmups < 0) {
+    printf("At least 1 measured repetition is needed.\n");
+    return 1;
+  }
+  // The test needs enough times of every run to tell a regression from noise.
+  bench_result *baseline = NULL;
+  int baseline_num = 0;
+  if (baselineName != NULL) {
+    baseline = readResultsJSON(baselineName, &baseline_num);
+    if (baseline == NULL) {
+      return 1;
+    }
+    if (reps < REGRESSION_MIN_REPS) {
+      printf("Comparing to %s: %d repetitions instead of %d.\n", baselineName, REGRESSION_MIN_REPS, reps);
+      reps = REGRESSION_MIN_REPS;
+    }
+  }
+  // Without the lists, the runs are the ones of the baseline, so that none of them goes missing.
+  char baselineBackends[1024], baselineThreads[1024];
+  int derivedBackends = 0;
+  if (baseline != NULL) {
+    int baselinePipelined = 0;
+    listBaselineRuns(baseline, baseline_num, baselineBackends, baselineThreads, sizeof(baselineBackends),
+      &baselinePipelined);
+    if (backendList == NULL) {
+      backendList = baselineBackends;
+      pipelined |= baselinePipelined;
+      derivedBackends = 1;
+    }
+    if (threadList == NULL && !sweep && weakSpec == NULL && baselineThreads[0] != '\0') {
+      threadList = baselineThreads;
+    }
+  }
+  if (replicate && affinity == NULL) {
+    affinity = "none";
+  }
+
+  graph_spec weakBase;
+  if (weakSpec != NULL && !parseGraphSpec(weakSpec, &weakBase)) {
+    return 1;
+  }
+
+  // A sweep always has the single thread runs, that everything is compared to.
+  int threads[MAX_LIST];
+  int threads_num;
+  if (weakSpec != NULL || (sweep && threadList == NULL)) {
+    threads_num = sweepThreads(threads, MAX_LIST, weakSpec != NULL);
+  } else {
+    threads_num = parseIntList((threadList != NULL) ? threadList : "2,4,8", threads);
+  }
+  if (sweep && threads[0] != 1 && threads_num < MAX_LIST) {
+    memmove(&threads[1], threads, threads_num * sizeof(int));
+    threads[0] = 1;
+    threads_num++;
+  }
+
+  // The graphs given on the command line, or the default files.
+  char **graphs;
+  char **graphNames;
+  int files_num;
+  if (weakSpec != NULL) {
+    // One graph per number of threads, twice as big every time the threads double.
+    files_num = threads_num;
+    graphs = (char **) malloc(files_num * sizeof(char *));
+    graphNames = (char **) malloc(files_num * sizeof(char *));
+    for (int f = 0; f < files_num; f++) {
+      graph_spec spec = weakBase;
+      for (int p = threads[f]; p > 1; p /= 2) {
+        spec.scale++;
+      }
+      graphs[f] = (char *) malloc(64);
+      formatGraphSpec(spec, graphs[f], 64);
+      graphNames[f] = graphs[f];
+    }
+  } else if (optind < argc) {
+    files_num = argc - optind;
+    graphs = &argv[optind];
+    graphNames = (char **) malloc(files_num * sizeof(char *));
+    for (int f = 0; f < files_num; f++) {
+      graphNames[f] = graphName(graphs[f]);
+    }
+  } else if (baseline != NULL && fileList == NULL) {
+    graphs = (char **) malloc(MAX_LIST * sizeof(char *));
+    graphNames = (char **) malloc(MAX_LIST * sizeof(char *));
+    files_num = listBaselineGraphs(baseline, baseline_num, filenames, names, 5, graphs, graphNames);
+  } else {
+    int files[MAX_LIST];
+    files_num = parseIntList((fileList != NULL) ? fileList : "0,1,2,3,4", files);
+    graphs = (char **) malloc(files_num * sizeof(char *));
+    graphNames = (char **) malloc(files_num * sizeof(char *));
+    for (int f = 0; f < files_num; f++) {
+      graphs[f] = filenames[files[f]];
+      graphNames[f] = names[files[f]];
+    }
+  }
+
+  // Every backend with every number of threads. The serial one only runs once.
+  // The default list skips whatever this build doesn't support.
+  run_config configs[MAX_LIST * MAX_LIST];
+  int configs_num = 0;
+
+  char *list = strdup((backendList != NULL) ? backendList : "serial,pthreads,openmp,cilk");
+  for (char *name = strtok(list, ","); name != NULL; name = strtok(NULL, ",")) {
+    backend *engine = findBackend(name);
+    if (engine == NULL) {
+      printf("Backend %s isn't available in this build.\n", name);
+      if (backendList != NULL && !derivedBackends) {
+        return 1;
+      }
+      continue;
+    }
+
+    for (int i = 0; i < (engine->parallel ? threads_num : 1); i++) {
+      run_config config = {engine, engine->parallel ? threads[i] : 1, RUN_BACKEND};
+      configs[configs_num++] = config;
+    }
+  }
+  free(list);
+
+  if (pipelined) {
+    run_config load = {NULL, 1, RUN_LOAD};
+    configs[configs_num++] = load;
+    for (int i = 0; i < threads_num; i++) {
+      run_config pipeline = {NULL, threads[i], RUN_PIPELINE};
+      configs[configs_num++] = pipeline;
+    }
+  }
+
+  FILE *traceFile = NULL;
+  if (traceName != NULL || counters || memory) {
+    traceEnable(1);
+    traceFile = (traceName != NULL) ? traceOpen(traceName) : NULL;
+  }
+  if (counters) {
+    countersEnable();
+  }
+  if (memory) {
+    memoryEnable();
+  }
+
+  // results[config * files_num + file]
+  bench_result *results = (bench_result *) calloc(configs_num * files_num, sizeof(bench_result));
+  int mismatches = 0;
+
+  for (int f = 0; f < files_num; f++) {
+    char *filename = graphs[f];
+    long long heapBefore = memoryLive();
+    csr mtx = loadGraph(filename);
+    int matrixFile = !isGraphSpec(filename) && !isSnapshot(filename);
+    if (mtx.rowIndex == NULL) {
+      return 1;
+    }
+    uint nonzeros = mtx.rowIndex[mtx.size];
+    if (memory) {
+      long long heap = memoryLive() - heapBefore;
+      printf("%s takes %.1f MB of heap, %.2f bytes per edge\n", graphNames[f], heap / MEMORY_MB,
+        (nonzeros > 0) ? (double) heap / nonzeros : 0);
+    }
+
+    // The reference of -v. Larger graphs are checked against the first run instead.
+    uint *reference = NULL;
+    verify_result expected;
+    int haveExpected = 0;
+    if (verify && nonzeros <= VERIFY_MAX_NONZEROS) {
+      double start = nowMicros();
+      reference = referenceTriangles(mtx);
+      expected = summarizeTriangles(reference, mtx.size);
+      haveExpected = 1;
+      printf("Reference for %s: %llu triangles in %.0f us\n", graphNames[f], expected.total,
+        nowMicros() - start);
+    }
+
+    for (int c = 0; c < configs_num; c++) {
+      bench_result *result = &results[c * files_num + f];
+      char name[64], label[64];
+      describeConfig(configs[c], name, label, sizeof(name));
+      result->graph = graphNames[f];
+      result->backend = strdup(name);
+      result->label = strdup(label);
+      result->threads = configs[c].threads;
+      result->warmups = warmups;
+      result->times = (double *) malloc(reps * sizeof(double));
+      result->verified = VERIFY_NONE;
+      result->peakHeap = -1;
+      result->peakRSS = -1;
+      result->retained = -1;
+      result->bytesPerEdge = -1;
+
+      // The load and the pipelined runs read the file themselves, so they need a .mtx file.
+      // In a weak sweep, each graph only runs with its own number of threads.
+      // The runs that are skipped have no samples and are left out of the results.
+      int skip = weakSpec != NULL && configs[c].threads != threads[f];
+      if (configs[c].kind != RUN_BACKEND && !matrixFile) {
+        printf("%s needs a .mtx file. Skipping %s.\n", label, graphNames[f]);
+        skip = 1;
+      }
+      if (skip) {
+        result->stats = computeStats(result->times, 0);
+        result->ipc = -1;
+        result->missesPerEdge = -1;
+        continue;
+      }
+
+      // Place the table according to the row partition before any measurement.
+      csr table = mtx;
+      numa_plan plan;
+      numa_plan *plan_addr = NULL;
+      csr_arg *partition = NULL;
+      if (affinity != NULL && configs[c].kind == RUN_BACKEND) {
+        plan = makeNumaPlan(configs[c].threads, affinity, replicate);
+        partition = makeThreadArguments(mtx, configs[c].threads);
+        table = firstTouchCSR(mtx, partition, &plan);
+        replicateCSR(table, &plan);
+        plan_addr = &plan;
+      }
+
+      long long liveBefore = memoryLive();
+      if (memory) {
+        memoryResetPeak();
+      }
+
+      for (int rep = 0; rep < warmups + reps; rep++) {
+        traceReset();
+        data_arg data = measureTime(configs[c], table, filename, plan_addr);
+
+        if (rep >= warmups) {
+          result->times[rep - warmups] = data.time;
+        }
+
+        // The first measured repetition is checked. The load run counts nothing.
+        if (rep == warmups && data.triangles != NULL) {
+          verify_result check = verify
+            ? verifyTriangles(data.triangles, reference, haveExpected ? &expected : NULL, mtx.size)
+            : summarizeTriangles(data.triangles, mtx.size);
+          if (verify && !haveExpected) {
+            expected = check;
+            haveExpected = 1;
+          }
+          result->triangles = check.total;
+          result->checksum = check.checksum;
+          result->verified = check.status;
+
+          printf("%s on %s: %llu triangles, checksum %016llx", label, graphNames[f], check.total, check.checksum);
+          if (check.status == VERIFY_MISMATCH) {
+            mismatches++;
+            if (reference != NULL) {
+              printf(" MISMATCH at %u vertices, first %u (%u instead of %u)", check.mismatches,
+                check.first, data.triangles[check.first], reference[check.first]);
+            } else {
+              printf(" MISMATCH with the first run (%llu triangles)", expected.total);
+            }
+          } else if (check.status == VERIFY_OK) {
+            printf(" OK");
+          }
+          printf("\n");
+        }
+        free(data.triangles);
+      }
+
+      result->stats = computeStats(result->times, reps);
+
+      if (memory) {
+        result->peakHeap = memoryPeak();
+        result->peakRSS = memoryPeakRSS();
+        result->retained = (memoryLive() - liveBefore) / (warmups + reps);
+        result->bytesPerEdge = (nonzeros > 0) ? (double) result->peakHeap / nonzeros : 0;
+        printf("%s on %s: peak heap %.1f MB (%.2f bytes/edge)\tpeak RSS %.1f MB\t%.1f MB left per repetition\n",
+          label, graphNames[f], result->peakHeap / MEMORY_MB, result->bytesPerEdge,
+          result->peakRSS / MEMORY_MB, result->retained / MEMORY_MB);
+      }
+
+      // Every nonzero is the intersection of two rows. The pipelined mode reads the same ones.
+      uint edges = (configs[c].kind == RUN_LOAD) ? 0 : nonzeros;
+      long long totals[COUNTERS_NUM];
+      result->intersections = (result->stats.median > 0) ? edges / (result->stats.median / 1e6) : 0;
+      result->ipc = -1;
+      result->missesPerEdge = -1;
+      if (counters && traceTotals(totals)) {
+        result->ipc = (totals[COUNTER_CYCLES] > 0)
+          ? (double) totals[COUNTER_INSTRUCTIONS] / totals[COUNTER_CYCLES] : 0;
+        result->missesPerEdge = (edges > 0) ? (double) totals[COUNTER_LLC_MISSES] / edges : 0;
+      }
+      printf("%s on %s: min %.0f\tmedian %.0f\tmean %.0f\tp95 %.0f\tstddev %.0f us\n",
+        label, graphNames[f], result->stats.min, result->stats.median, result->stats.mean,
+        result->stats.p95, result->stats.stddev);
+
+      if (traceName != NULL || counters || memory) {
+        char run[160];
+        snprintf(run, sizeof(run), "%s on %s", label, graphNames[f]);
+        traceReport(run, edges);
+        traceWrite(traceFile, c * files_num + f, run);
+      }
+
+      if (plan_addr != NULL) {
+        reportNumaAccess(partition, plan_addr);
+        freeNumaPlan(plan_addr);
+        freeCSR(table);
+        freeThreadArguments(partition, configs[c].threads);
+      }
+    }
+
+    free(reference);
+    freeCSR(mtx);
+  }
+
+  // One row per backend and number of threads, one column per file.
+  FILE *statsFile = fopen(csvName, "w");
+  fprintf(statsFile, "library_threads");
+  for (int f = 0; f < files_num; f++) {
+    fprintf(statsFile, "\t%s", graphNames[f]);
+  }
+
+  for (int c = 0; c < configs_num; c++) {
+    fprintf(statsFile, "\n%s", results[c * files_num].label);
+    for (int f = 0; f < files_num; f++) {
+      fprintf(statsFile, "\t%.0f", results[c * files_num + f].stats.mean);
+    }
+  }
+  fprintf(statsFile, "\n");
+  fclose(statsFile);
+
+  traceClose(traceFile);
+
+  bench_meta meta = readBenchMeta();
+  writeResultsCSV(resultsName, results, configs_num * files_num, meta);
+  writeResultsJSON(jsonName, results, configs_num * files_num, meta);
+
+  if (sweep || weakSpec != NULL) {
+    scaling_point *points = (scaling_point *) malloc(configs_num * files_num * sizeof(scaling_point));
+    int points_num = computeScaling(results, configs_num * files_num,
+      (weakSpec != NULL) ? SCALING_WEAK : SCALING_STRONG, points);
+    printScaling(points, points_num);
+    writeScalingCSV(scalingName, points, points_num, meta);
+  }
+
+  int regressions = 0, missing = 0;
+  if (baseline != NULL) {
+    regression_row *rows = (regression_row *) malloc((configs_num * files_num + baseline_num) * sizeof(regression_row));
+    int rows_num = compareToBaseline(results, configs_num * files_num, baseline, baseline_num, threshold, rows);
+    printRegressions(rows, rows_num);
+    writeRegressionCSV(regressionName, rows, rows_num, meta);
+    for (int i = 0; i < rows_num; i++) {
+      regressions += (rows[i].verdict == REGRESSION_REGRESSED);
+      missing += (rows[i].verdict == REGRESSION_MISSING);
+    }
+  }
+
+  if (mismatches > 0) {
+    printf("%d runs didn't match the reference.\n", mismatches);
+    return 2;
+  }
+  if (regressions > 0) {
+    printf("%d runs regressed from %s.\n", regressions, baselineName);
+    return 3;
+  }
+  if (missing > 0) {
+    printf("%d runs of %s are missing.\n", missing, baselineName);
+    return 3;
+  }
+  return 0;
+}